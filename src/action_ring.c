@@ -0,0 +1,41 @@
+#include "action_ring.h"
+
+void init_action_ring(action_ring *ring) {
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+}
+
+unsigned push_actions(action_ring *ring, const game_action *actions, unsigned nb_actions) {
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    // The indexes are free-running, their difference is the number of actions in the ring
+    unsigned free_slots = ACTION_RING_CAPACITY - (tail - head);
+    if (nb_actions > free_slots) {
+        nb_actions = free_slots;
+    }
+
+    for (unsigned i = 0; i < nb_actions; i++) {
+        ring->slots[(tail + i) & (ACTION_RING_CAPACITY - 1)] = actions[i];
+    }
+    atomic_store_explicit(&ring->tail, tail + nb_actions, memory_order_release);
+
+    return nb_actions;
+}
+
+unsigned pop_actions(action_ring *ring, game_action *actions, unsigned max_actions) {
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    unsigned nb_actions = tail - head;
+    if (nb_actions > max_actions) {
+        nb_actions = max_actions;
+    }
+
+    for (unsigned i = 0; i < nb_actions; i++) {
+        actions[i] = ring->slots[(head + i) & (ACTION_RING_CAPACITY - 1)];
+    }
+    atomic_store_explicit(&ring->head, head + nb_actions, memory_order_release);
+
+    return nb_actions;
+}
@@ -0,0 +1,31 @@
+#ifndef SRC_ACTION_RING_H_
+#define SRC_ACTION_RING_H_
+
+#include "messages.h"
+
+#include <stdatomic.h>
+
+#define ACTION_RING_CAPACITY 256 // Has to be a power of two
+
+/** Bounded queue of game actions between one producer thread and one consumer thread, without lock
+ * Neither side ever waits for the other: the producer drops the actions which do not fit
+ */
+typedef struct action_ring {
+    atomic_uint head; // Next slot to read, only written by the consumer
+    atomic_uint tail; // Next slot to write, only written by the producer
+    game_action slots[ACTION_RING_CAPACITY];
+} action_ring;
+
+void init_action_ring(action_ring *ring);
+
+/** Adds the actions at the end of the ring, it must only be called by the producer
+ * Returns the number of actions added, the others are dropped because the ring is full
+ */
+unsigned push_actions(action_ring *ring, const game_action *actions, unsigned nb_actions);
+
+/** Moves at most max_actions of the oldest actions of the ring to actions, it must only be called by the consumer
+ * Returns the number of actions moved
+ */
+unsigned pop_actions(action_ring *ring, game_action *actions, unsigned max_actions);
+
+#endif // SRC_ACTION_RING_H_
@@ -0,0 +1,99 @@
+#include "bitboard.h"
+#include "utils.h"
+
+#include <stdio.h>
+
+static uint64_t *get_plane(const bitboard *bb, TILE t) {
+    return bb->planes + (t - 1) * bb->nb_words;
+}
+
+/** Returns the word w of the union of the planes of tiles_mask */
+static uint64_t get_planes_word(const bitboard *bb, unsigned tiles_mask, int w) {
+    uint64_t word = 0;
+    for (TILE t = INDESTRUCTIBLE_WALL; t <= NB_BITBOARD_PLANES; t++) {
+        if (tiles_mask & TILE_MASK(t)) {
+            word |= get_plane(bb, t)[w];
+        }
+    }
+    return word;
+}
+
+/** Returns the bits of the word w which are in [from, to] */
+static uint64_t get_range_mask(int w, int from, int to) {
+    int first_bit = from - w * BITBOARD_WORD_BITS;
+    int last_bit = to - w * BITBOARD_WORD_BITS;
+    uint64_t mask = ~(uint64_t)0;
+    if (first_bit > 0) {
+        mask &= ~(uint64_t)0 << first_bit;
+    }
+    if (last_bit < BITBOARD_WORD_BITS - 1) {
+        mask &= ~(uint64_t)0 >> (BITBOARD_WORD_BITS - 1 - last_bit);
+    }
+    return mask;
+}
+
+bitboard *create_bitboard(dimension dim) {
+    bitboard *bb = malloc(sizeof(bitboard));
+    RETURN_NULL_IF_NULL_PERROR(bb, "malloc bitboard");
+
+    bb->dim = dim;
+    bb->nb_words = (dim.width * dim.height + BITBOARD_WORD_BITS - 1) / BITBOARD_WORD_BITS;
+    bb->planes = calloc(NB_BITBOARD_PLANES * bb->nb_words, sizeof(uint64_t));
+    if (bb->planes == NULL) {
+        perror("calloc bitboard planes");
+        free(bb);
+        return NULL;
+    }
+
+    return bb;
+}
+
+void free_bitboard(bitboard *bb) {
+    RETURN_IF_NULL(bb);
+
+    free(bb->planes);
+    free(bb);
+}
+
+void set_bitboard_tile(bitboard *bb, int i, TILE old_tile, TILE new_tile) {
+    uint64_t bit = (uint64_t)1 << (i % BITBOARD_WORD_BITS);
+    if (old_tile != EMPTY && old_tile <= NB_BITBOARD_PLANES) {
+        get_plane(bb, old_tile)[i / BITBOARD_WORD_BITS] &= ~bit;
+    }
+    if (new_tile != EMPTY && new_tile <= NB_BITBOARD_PLANES) {
+        get_plane(bb, new_tile)[i / BITBOARD_WORD_BITS] |= bit;
+    }
+}
+
+TILE get_bitboard_tile(const bitboard *bb, int i) {
+    for (TILE t = INDESTRUCTIBLE_WALL; t <= NB_BITBOARD_PLANES; t++) {
+        if (is_in_planes(bb, TILE_MASK(t), i)) {
+            return t;
+        }
+    }
+    return EMPTY;
+}
+
+bool is_in_planes(const bitboard *bb, unsigned tiles_mask, int i) {
+    return (get_planes_word(bb, tiles_mask, i / BITBOARD_WORD_BITS) >> (i % BITBOARD_WORD_BITS)) & 1;
+}
+
+int find_first_in_planes(const bitboard *bb, unsigned tiles_mask, int from, int to) {
+    for (int w = from / BITBOARD_WORD_BITS; w <= to / BITBOARD_WORD_BITS; w++) {
+        uint64_t word = get_planes_word(bb, tiles_mask, w) & get_range_mask(w, from, to);
+        if (word != 0) {
+            return w * BITBOARD_WORD_BITS + __builtin_ctzll(word);
+        }
+    }
+    return -1;
+}
+
+int find_last_in_planes(const bitboard *bb, unsigned tiles_mask, int from, int to) {
+    for (int w = to / BITBOARD_WORD_BITS; w >= from / BITBOARD_WORD_BITS; w--) {
+        uint64_t word = get_planes_word(bb, tiles_mask, w) & get_range_mask(w, from, to);
+        if (word != 0) {
+            return w * BITBOARD_WORD_BITS + BITBOARD_WORD_BITS - 1 - __builtin_clzll(word);
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,56 @@
+#ifndef SRC_BITBOARD_H_
+#define SRC_BITBOARD_H_
+
+#include "model.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BITBOARD_WORD_BITS 64
+
+/** One plane per tile which can be in a grid, from INDESTRUCTIBLE_WALL to PLAYER_4 (EMPTY is the absence of bit) */
+#define NB_BITBOARD_PLANES PLAYER_4
+
+/** Mask of tiles to give to the functions looking at several planes at once */
+#define TILE_MASK(t) (1u << (t))
+
+#define WALL_TILES (TILE_MASK(INDESTRUCTIBLE_WALL) | TILE_MASK(DESTRUCTIBLE_WALL))
+#define PLAYER_TILES (TILE_MASK(PLAYER_1) | TILE_MASK(PLAYER_2) | TILE_MASK(PLAYER_3) | TILE_MASK(PLAYER_4))
+#define BLOCKING_TILES (WALL_TILES | TILE_MASK(BOMB) | PLAYER_TILES)
+
+/** Grid stored as bit-planes of 64-bit words, the tile i of the flatten grid is the bit i of each plane
+ */
+typedef struct bitboard {
+    dimension dim;
+    int nb_words;     // Words of each plane
+    uint64_t *planes; // NB_BITBOARD_PLANES planes of nb_words words
+} bitboard;
+
+/** Returns an empty bitboard of the given dimension
+ */
+bitboard *create_bitboard(dimension dim);
+
+void free_bitboard(bitboard *bb);
+
+/** Moves the tile i from the plane of old_tile to the plane of new_tile
+ */
+void set_bitboard_tile(bitboard *bb, int i, TILE old_tile, TILE new_tile);
+
+/** Returns the tile i, EMPTY if it is in none of the planes
+ */
+TILE get_bitboard_tile(const bitboard *bb, int i);
+
+/** Returns true if the tile i is in one of the planes of tiles_mask
+ */
+bool is_in_planes(const bitboard *bb, unsigned tiles_mask, int i);
+
+/** Returns the first tile of [from, to] in one of the planes of tiles_mask, -1 if there is none
+ * The range is checked a word at a time
+ */
+int find_first_in_planes(const bitboard *bb, unsigned tiles_mask, int from, int to);
+
+/** Returns the last tile of [from, to] in one of the planes of tiles_mask, -1 if there is none
+ */
+int find_last_in_planes(const bitboard *bb, unsigned tiles_mask, int from, int to);
+
+#endif // SRC_BITBOARD_H_
@@ -109,7 +109,7 @@ void add_to_line(chat *chat, char c) {
     }
 }
 
-chat_node *create_chat_node(int sender, char msg[TEXT_SIZE], bool whispered) {
+chat_node *create_chat_node(int sender, const char msg[TEXT_SIZE], bool whispered) {
     if (sender < 0 || sender >= PLAYER_NUM) {
         return NULL;
     }
@@ -132,7 +132,7 @@ chat_node *create_chat_node(int sender, char msg[TEXT_SIZE], bool whispered) {
     return new_node;
 }
 
-int add_message_from_server(chat *c, int sender, char *message, bool whispered) {
+int add_message_from_server(chat *c, int sender, const char *message, bool whispered) {
     RETURN_FAILURE_IF_NULL(c);
     RETURN_FAILURE_IF_NULL(c->history);
 
@@ -49,7 +49,7 @@ void add_to_line(chat *chat, char c);
 
 /** Adds a message to the chat history sent by the server
  */
-int add_message_from_server(chat *c, int sender, char *message, bool whispered);
+int add_message_from_server(chat *c, int sender, const char *message, bool whispered);
 
 /** Adds a message to the chat history sent by the client
  */
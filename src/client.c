@@ -15,6 +15,7 @@
 typedef struct flags {
     char *mode;
     char *port;
+    char *frame_rate;
 } flags;
 
 static GAME_MODE choosen_game_mode;
@@ -30,6 +31,7 @@ int init_client_flags() {
     RETURN_FAILURE_IF_NULL(client_flags);
     client_flags->mode = NULL;
     client_flags->port = NULL;
+    client_flags->frame_rate = NULL;
 
     return EXIT_SUCCESS;
 }
@@ -40,6 +42,8 @@ void parse_client_flags(int argc, char *argv[]) {
             client_flags->port = argv[i];
         } else if (strcmp(argv[i - 1], "-m") == 0) {
             client_flags->mode = argv[i];
+        } else if (strcmp(argv[i - 1], "-f") == 0) {
+            client_flags->frame_rate = argv[i];
         }
     }
 }
@@ -130,8 +134,28 @@ int try_to_init_port_and_connect_client() {
     }
 }
 
+int try_to_init_frame_rate_client() {
+    if (client_flags->frame_rate == NULL) {
+        return EXIT_SUCCESS;
+    }
+    int frame_rate = parse_unsigned_within_bounds(client_flags->frame_rate, MIN_FRAME_RATE, MAX_FRAME_RATE);
+    if (frame_rate < 0) {
+        printf("Your frame rate argument is not valid, it has to be between %d and %d.\n", MIN_FRAME_RATE,
+               MAX_FRAME_RATE);
+        return EXIT_FAILURE;
+    }
+    set_frame_rate(frame_rate);
+    return EXIT_SUCCESS;
+}
+
 int try_to_init_client() {
-    int r = try_to_init_mode_client();
+    int r = try_to_init_frame_rate_client();
+
+    if (r != EXIT_SUCCESS) {
+        return r;
+    }
+
+    r = try_to_init_mode_client();
 
     if (r != EXIT_SUCCESS) {
         return r;
@@ -22,38 +22,28 @@ int send_connexion_header_raw(int sock, connection_header_raw *serialized_head)
 }
 
 int send_initial_connexion_information(int sock, GAME_MODE mode) {
-    initial_connection_header *head = malloc(sizeof(initial_connection_header));
-    RETURN_FAILURE_IF_NULL_PERROR(head, "malloc initial_connection_header");
-    head->game_mode = mode;
+    initial_connection_header head;
+    head.game_mode = mode;
 
-    connection_header_raw *serialized_head = serialize_initial_connection(head);
-    free(head);
+    connection_header_raw serialized_head;
+    RETURN_FAILURE_IF_ERROR(serialize_initial_connection_into(&head, &serialized_head));
 
-    RETURN_FAILURE_IF_NULL(serialized_head);
-    int res = send_connexion_header_raw(sock, serialized_head);
-    free(serialized_head);
-
-    return res;
+    return send_connexion_header_raw(sock, &serialized_head);
 }
 
 int send_ready_connexion_information(int sock, GAME_MODE mode, int id, int eq) {
-    ready_connection_header *head = malloc(sizeof(ready_connection_header));
-    RETURN_FAILURE_IF_NULL_PERROR(head, "malloc ready connection header");
-    head->game_mode = mode;
-    head->id = id;
-    head->eq = eq;
-
-    connection_header_raw *serialized_head = serialize_ready_connection(head);
-    free(head);
+    ready_connection_header head;
+    head.game_mode = mode;
+    head.id = id;
+    head.eq = eq;
 
-    RETURN_FAILURE_IF_NULL(serialized_head);
-    int res = send_connexion_header_raw(sock, serialized_head);
-    free(serialized_head);
+    connection_header_raw serialized_head;
+    RETURN_FAILURE_IF_ERROR(serialize_ready_connection_into(&head, &serialized_head));
 
-    return res;
+    return send_connexion_header_raw(sock, &serialized_head);
 }
 
-int send_tcp(int sock, const void *buffer, uint8_t size) {
+int send_tcp(int sock, const void *buffer, size_t size) {
     unsigned sent = 0;
     while (sent < size) {
         int res = send(sock, (char *)buffer + sent, size - sent, 0);
@@ -70,58 +60,30 @@ int send_tcp(int sock, const void *buffer, uint8_t size) {
     return EXIT_SUCCESS;
 }
 
-int send_chat_message(int sock, chat_message_type type, int id, int eq, uint8_t message_length, char *message) {
-    chat_message *msg = malloc(sizeof(chat_message));
-    RETURN_FAILURE_IF_NULL_PERROR(msg, "malloc chat_message");
-    msg->type = type;
-    msg->id = id;
-    msg->eq = eq;
-    msg->message_length = message_length;
-    msg->message = malloc(message_length);
-    if (msg->message == NULL) {
-        free(msg);
-        perror("malloc chat_message message");
-        return EXIT_FAILURE;
-    }
-    strncpy(msg->message, message, message_length);
+int send_chat_message(int sock, chat_message_type type, int id, int eq, uint8_t message_length, const char *message) {
+    chat_message_view msg = {type, id, eq, message_length, message};
 
-    char *serialized_msg = client_serialize_chat_message(msg);
+    char serialized_msg[CHAT_MESSAGE_SIZE(UINT8_MAX)];
+    int size = client_serialize_chat_message_into(&msg, serialized_msg, sizeof(serialized_msg));
+    RETURN_FAILURE_IF_NEG(size);
 
-    if (serialized_msg == NULL) {
-        free(msg->message);
-        free(msg);
-        return EXIT_FAILURE;
-    }
-    int res = send_tcp(sock, serialized_msg, 3 + message_length);
-    free(msg->message);
-    free(msg);
-    free(serialized_msg);
-    return res;
+    return send_tcp(sock, serialized_msg, size);
 }
 
-connection_information_raw *recv_connexion_information_raw(int sock) {
-    connection_information_raw *head = malloc(sizeof(connection_information_raw));
-    RETURN_NULL_IF_NULL_PERROR(head, "malloc connection_information_raw");
+connection_information *recv_connexion_information(int sock) {
+    connection_information_raw head;
+    char *data = (char *)&head;
     unsigned received = 0;
     while (received < sizeof(connection_information_raw)) {
-        int res = recv(sock, head + received, sizeof(connection_information_raw) - received, 0);
+        int res = recv(sock, data + received, sizeof(connection_information_raw) - received, 0);
 
-        if (res < 0) {
+        if (res <= 0) {
             perror("recv connection_information_raw");
-            free(head);
             return NULL;
         }
         received += res;
     }
-    return head;
-}
-
-connection_information *recv_connexion_information(int sock) {
-    connection_information_raw *head = recv_connexion_information_raw(sock);
-    RETURN_NULL_IF_NULL(head);
-    connection_information *deserialized_head = deserialize_connection_information(head);
-    free(head);
-    return deserialized_head;
+    return deserialize_connection_information(&head);
 }
 
 int recv_tcp(int sock, void *buffer, int size) {
@@ -141,51 +103,32 @@ int recv_tcp(int sock, void *buffer, int size) {
     return EXIT_SUCCESS;
 }
 
-chat_message *recv_chat_message(int sock, uint16_t header) {
-    uint8_t length;
-    int res = recv_tcp(sock, &length, sizeof(uint8_t));
-    RETURN_NULL_IF_NEG_PERROR(res, "recv chat_message length");
-
-    char *message = malloc(length + 1);
-    RETURN_NULL_IF_NULL_PERROR(message, "malloc chat_message message");
-    res = recv_tcp(sock, message, length * sizeof(char));
-    if (res < 0) {
-        perror("recv chat_message message");
-        free(message);
-        return NULL;
-    }
-
-    // Allocate memory for the total received message
-    char *total_received = malloc(3 + length);
-    if (total_received == NULL) {
-        perror("malloc chat_message total_received");
-        free(message);
-        return NULL;
+int recv_chat_message(int sock, uint16_t header, char *buffer, size_t capacity, chat_message_view *msg) {
+    if (capacity < CHAT_MESSAGE_SIZE(UINT8_MAX) + 1) {
+        return EXIT_FAILURE;
     }
 
-    // Copy the header, length and message into the total_received buffer
-    memcpy(total_received, &header, 2);
-    memcpy(total_received + 2, &length, 1);
-    memcpy(total_received + 3, message, length);
+    // The header is already received, the length and the message follow it in the buffer
+    memcpy(buffer, &header, sizeof(uint16_t));
+    int res = recv_tcp(sock, buffer + 2, sizeof(uint8_t));
+    RETURN_FAILURE_IF_ERROR(res);
 
-    chat_message *msg = server_deserialize_chat_message(total_received);
+    uint8_t length = buffer[2];
+    res = recv_tcp(sock, buffer + 3, length);
+    RETURN_FAILURE_IF_ERROR(res);
+    buffer[CHAT_MESSAGE_SIZE(length)] = '\0';
 
-    if (msg == NULL) {
-        perror("deserialize chat_message");
-        free(total_received);
-        free(message);
-        return NULL;
+    if (server_deserialize_chat_message_view(buffer, CHAT_MESSAGE_SIZE(length), msg) != EXIT_SUCCESS) {
+        fprintf(stderr, "deserialize chat_message: invalid message\n");
+        return EXIT_FAILURE;
     }
-    free(total_received);
-    free(message);
-
-    return msg;
+    return EXIT_SUCCESS;
 }
 
 u_int16_t recv_header(int sock) {
     uint16_t header;
     int res = recv_tcp(sock, &header, sizeof(uint16_t));
-    if (res < 0) {
+    if (res != EXIT_SUCCESS) {
         perror("recv header");
         return 0;
     }
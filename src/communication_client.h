@@ -9,11 +9,14 @@
 
 int send_initial_connexion_information(int sock, GAME_MODE mode);
 int send_ready_connexion_information(int sock, GAME_MODE mode, int id, int eq);
-int send_chat_message(int sock, chat_message_type type, int id, int eq, uint8_t message_length, char *message);
+int send_chat_message(int sock, chat_message_type type, int id, int eq, uint8_t message_length, const char *message);
 
 connection_information *recv_connexion_information(int sock);
 
-chat_message *recv_chat_message(int sock, u_int16_t header);
+/** Receives the rest of the chat message whose header is given, in buffer
+ * buffer must have room for CHAT_MESSAGE_SIZE(UINT8_MAX) + 1 bytes, so that the text of msg is `\0` terminated
+ */
+int recv_chat_message(int sock, u_int16_t header, char *buffer, size_t capacity, chat_message_view *msg);
 u_int16_t recv_header(int sock);
 
 #endif // SRC_COMMUNICATION_CLIENT_H_
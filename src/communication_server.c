@@ -1,8 +1,11 @@
+#define _GNU_SOURCE // recvmmsg
+
 #include "communication_server.h"
 #include "messages.h"
 #include "model.h"
 #include "utils.h"
 
+#include <errno.h>
 #include <netinet/in.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -10,265 +13,191 @@
 #include <string.h>
 #include <sys/socket.h>
 
-int send_connexion_information_raw(int sock, connection_information_raw *serialized_head) {
-    char *data = (char *)serialized_head;
-    unsigned sent = 0;
-    while (sent < sizeof(connection_information_raw)) {
-        int res = send(sock, data + sent, sizeof(connection_information_raw) - sent, 0);
-
-        if (res < 0) {
-            perror("send connection_information");
-            return EXIT_FAILURE;
-        }
-        sent += res;
-    }
-    return EXIT_SUCCESS;
-}
-
-int send_connexion_information(int sock, GAME_MODE mode, int id, int eq, int portudp, int portmdiff,
-                               uint16_t adrmdiff[8]) {
-    connection_information *head = malloc(sizeof(connection_information));
-    RETURN_FAILURE_IF_NULL_PERROR(head, "malloc connection_information");
-    head->game_mode = mode;
-    head->id = id;
-    head->eq = eq;
-    head->portudp = portudp;
-    head->portmdiff = portmdiff;
-
+#define MAX_GAME_BOARD_SIZE PACKED_GAME_BOARD_SIZE(UINT8_MAX, UINT8_MAX)
+
+struct recv_batch {
+    char slots[RECV_BATCH_SIZE][GAME_ACTION_SIZE];
+    struct sockaddr_in6 sources[RECV_BATCH_SIZE];
+    struct iovec iovecs[RECV_BATCH_SIZE];
+    struct mmsghdr headers[RECV_BATCH_SIZE];
+};
+
+int send_connexion_information(tcp_output *out, GAME_MODE mode, int id, int eq, int portudp, int portmdiff,
+                               uint16_t adrmdiff[8], uint32_t token, game_transport transport) {
+    connection_information head;
+    head.game_mode = mode;
+    head.id = id;
+    head.eq = eq;
+    head.portudp = portudp;
+    head.portmdiff = portmdiff;
     for (unsigned i = 0; i < 8; i++) {
-        head->adrmdiff[i] = adrmdiff[i];
+        head.adrmdiff[i] = adrmdiff[i];
     }
-    connection_information_raw *serialized_head = serialize_connection_information(head);
-    free(head);
+    head.token = token;
+    head.transport = transport;
+
+    char serialized_head[sizeof(connection_information_raw)];
+    int size = serialize_connection_information_into(&head, serialized_head, sizeof(serialized_head));
+    RETURN_FAILURE_IF_NEG(size);
 
-    RETURN_FAILURE_IF_NULL(serialized_head);
-    int res = send_connexion_information_raw(sock, serialized_head);
-    free(serialized_head);
+    return send_tcp_output(out, serialized_head, size);
+}
 
-    return res;
+/** Queues the datagram for its multicast group, or once for all the receivers in unicast */
+int send_string_to_clients(egress_queue *egress, const game_destination *dest, char *message, size_t message_length) {
+    if (dest->group != NULL) {
+        return queue_datagram(egress, dest->group, message, message_length);
+    }
+    return queue_datagram_to_receivers(egress, dest->receivers, dest->nb_receivers, dest->max_queued, message,
+                                       message_length);
 }
-int send_string_to_clients_multicast(int sock, struct sockaddr_in6 *addr_mult, char *message, size_t message_length) {
-    int a;
-    if ((a = sendto(sock, message, message_length, 0, (struct sockaddr *)addr_mult, sizeof(struct sockaddr_in6))) < 0) {
+
+/** Sends the board in bands of whole rows, a datagram per band
+ */
+static int send_game_board_bands(egress_queue *egress, const game_destination *dest, const game_board_view *head) {
+    uint16_t rows_per_band = GAME_BOARD_BAND_ROWS(head->width);
+    if (rows_per_band == 0) {
         return EXIT_FAILURE;
     }
 
+    char serialized_band[GAME_BOARD_BAND_SIZE];
+    for (uint16_t first_row = 0; first_row < head->height; first_row += rows_per_band) {
+        uint16_t nb_rows = min(rows_per_band, head->height - first_row);
+        int size = serialize_game_board_band_into(head, first_row, nb_rows, serialized_band, sizeof(serialized_band));
+        RETURN_FAILURE_IF_NEG(size);
+        RETURN_FAILURE_IF_ERROR(send_string_to_clients(egress, dest, serialized_band, size));
+    }
     return EXIT_SUCCESS;
 }
 
-int send_game_board(int sock, struct sockaddr_in6 *addr_mult, uint16_t num, board *board_) {
-    game_board_information *head = malloc(sizeof(game_board_information));
-    RETURN_FAILURE_IF_NULL(head);
-
-    head->num = num;
-    head->width = board_->dim.width;
-    head->height = board_->dim.height;
-    head->board = malloc(head->width * head->height * sizeof(TILE));
+int send_game_board(egress_queue *egress, const game_destination *dest, uint16_t num, board *board_) {
+    game_board_view head;
+    head.num = num;
+    head.width = board_->dim.width;
+    head.height = board_->dim.height;
+    head.tiles = board_->grid;
 
-    for (unsigned i = 0; i < head->width * head->height; i++) {
-        head->board[i] = board_->grid[i];
+    if (IS_LARGE_BOARD(head.height, head.width)) {
+        return send_game_board_bands(egress, dest, &head);
     }
 
-    char *serialized_head = serialize_game_board(head);
-    free(head->board);
-    free(head);
-    RETURN_FAILURE_IF_NULL(serialized_head);
-
-    size_t len_serialized_head = 6 + board_->dim.width * board_->dim.height;
+    char serialized_head[MAX_GAME_BOARD_SIZE];
+    int size = serialize_packed_game_board_into(&head, serialized_head, sizeof(serialized_head));
+    RETURN_FAILURE_IF_NEG(size);
 
-    return send_string_to_clients_multicast(sock, addr_mult, serialized_head, len_serialized_head);
+    return send_string_to_clients(egress, dest, serialized_head, size);
 }
 
-int send_game_update(int sock, struct sockaddr_in6 *addr_mult, int num, tile_diff *diff, uint8_t nb) {
-    game_board_update *head = malloc(sizeof(game_board_update));
-    RETURN_FAILURE_IF_NULL(head);
+int send_game_region(egress_queue *egress, const game_destination *dest, uint16_t num, const board *board_,
+                     int region) {
+    region_grid grid;
+    init_region_grid(&grid, board_->dim);
+    coord origin;
+    dimension area;
+    get_region_area(&grid, region, &origin, &area);
+
+    // The rows of the region are not contiguous in the board
+    char tiles[REGION_TILES];
+    for (int row = 0; row < area.height; row++) {
+        memcpy(tiles + row * area.width, board_->grid + (origin.y + row) * board_->dim.width + origin.x, area.width);
+    }
 
-    head->num = num;
-    head->diff = diff;
-    head->nb = nb;
+    game_region_view view;
+    view.num = num;
+    view.height = board_->dim.height;
+    view.width = board_->dim.width;
+    view.region = region;
+    view.tiles = tiles;
 
-    char *serialized_head = serialize_game_board_update(head);
-    free(head);
-    RETURN_FAILURE_IF_NULL(serialized_head);
-    size_t len_serialized_head = 5 + nb * 3;
+    char serialized[GAME_REGION_SIZE];
+    int size = serialize_game_region_into(&view, serialized, sizeof(serialized));
+    RETURN_FAILURE_IF_NEG(size);
 
-    return send_string_to_clients_multicast(sock, addr_mult, serialized_head, len_serialized_head);
+    return send_string_to_clients(egress, dest, serialized, size);
 }
 
-int send_tcp(int sock, const void *buffer, uint8_t size) {
-    unsigned sent = 0;
-    while (sent < size) {
-        int res = send(sock, (char *)buffer + sent, size - sent, 0);
-        if (res < 0) {
-            perror("send tcp");
-            return EXIT_FAILURE;
-        }
-        if (res == 0) {
-            perror("send tcp: connection closed");
-            return EXIT_FAILURE;
-        }
-        sent += res;
-    }
-    return EXIT_SUCCESS;
+int send_game_update(egress_queue *egress, const game_destination *dest, char *update, size_t update_length) {
+    return send_string_to_clients(egress, dest, update, update_length);
 }
 
-int send_chat_message(int sock, chat_message_type type, int id, int eq, uint8_t message_length, char *message) {
-    chat_message *msg = malloc(sizeof(chat_message));
-    RETURN_FAILURE_IF_NULL_PERROR(msg, "malloc chat_message");
-    msg->type = type;
-    msg->id = id;
-    msg->eq = eq;
-    msg->message_length = message_length;
-    msg->message = malloc(message_length);
-    if (msg->message == NULL) {
-        free(msg);
-        perror("malloc chat_message message");
-        return EXIT_FAILURE;
-    }
-    strncpy(msg->message, message, message_length);
+int send_chat_message(tcp_output *out, chat_message_type type, int id, int eq, uint8_t message_length,
+                      const char *message) {
+    chat_message_view msg = {type, id, eq, message_length, message};
 
-    char *serialized_msg = server_serialize_chat_message(msg);
-    if (serialized_msg == NULL) {
-        free(msg->message);
-        free(msg);
-        return EXIT_FAILURE;
-    }
+    char serialized_msg[CHAT_MESSAGE_SIZE(UINT8_MAX)];
+    int size = server_serialize_chat_message_into(&msg, serialized_msg, sizeof(serialized_msg));
+    RETURN_FAILURE_IF_NEG(size);
 
-    int res = send_tcp(sock, serialized_msg, 3 + message_length);
-    free(msg->message);
-    free(msg);
-    free(serialized_msg);
-    return res;
+    return send_tcp_output(out, serialized_msg, size);
 }
 
-int send_game_over(int sock, GAME_MODE mode, int id, int eq) {
-    game_end *head = malloc(sizeof(game_end));
-    RETURN_FAILURE_IF_NULL_PERROR(head, "malloc game_end");
-    head->game_mode = mode;
-    head->id = id;
-    head->eq = eq;
+int send_game_over(tcp_output *out, GAME_MODE mode, int id, int eq) {
+    game_end head;
+    head.game_mode = mode;
+    head.id = id;
+    head.eq = eq;
 
-    char *serialized_head = serialize_game_end(head);
-    free(head);
-    RETURN_FAILURE_IF_NULL(serialized_head);
+    char serialized_head[GAME_END_SIZE];
+    int size = serialize_game_end_into(&head, serialized_head, sizeof(serialized_head));
+    RETURN_FAILURE_IF_NEG(size);
 
-    int res = send_tcp(sock, serialized_head, 2);
-    free(serialized_head);
-
-    return res;
+    return send_tcp_output(out, serialized_head, size);
 }
 
-connection_header_raw *recv_connexion_header_raw(int sock) {
-    connection_header_raw *head = malloc(sizeof(connection_header_raw));
-    RETURN_NULL_IF_NULL_PERROR(head, "malloc connection_header_raw");
-    unsigned received = 0;
-    while (received < sizeof(connection_header_raw)) {
-        int res = recv(sock, head + received, sizeof(connection_header_raw) - received, 0);
-        if (res < 0) {
-            perror("recv connection_header_raw");
-            free(head);
-            return NULL;
-        }
-        received += res;
-    }
-    return head;
-}
+recv_batch *create_recv_batch() {
+    recv_batch *batch = calloc(1, sizeof(recv_batch));
+    RETURN_NULL_IF_NULL_PERROR(batch, "calloc recv_batch");
 
-initial_connection_header *recv_initial_connection_header(int sock) {
-    connection_header_raw *head = recv_connexion_header_raw(sock);
-    RETURN_NULL_IF_NULL(head);
-    initial_connection_header *deserialized_head = deserialize_initial_connection(head);
-    free(head);
-    return deserialized_head;
+    for (unsigned i = 0; i < RECV_BATCH_SIZE; i++) {
+        batch->iovecs[i].iov_base = batch->slots[i];
+        batch->iovecs[i].iov_len = GAME_ACTION_SIZE;
+        batch->headers[i].msg_hdr.msg_iov = &batch->iovecs[i];
+        batch->headers[i].msg_hdr.msg_iovlen = 1;
+        batch->headers[i].msg_hdr.msg_name = &batch->sources[i];
+    }
+    return batch;
 }
 
-ready_connection_header *recv_ready_connexion_header(int sock) {
-    connection_header_raw *head = recv_connexion_header_raw(sock);
-    RETURN_NULL_IF_NULL(head);
-    ready_connection_header *deserialized_head = deserialize_ready_connection(head);
-    free(head);
-    return deserialized_head;
+void free_recv_batch(recv_batch *batch) {
+    free(batch);
 }
 
-char *recv_string_udp(int sock, size_t size) {
-    char *res = malloc(size);
-    RETURN_NULL_IF_NULL(res);
-    if (recvfrom(sock, res, size, 0, NULL, 0) < 0) {
-        perror("recvfrom string udp");
-        free(res);
-        return NULL;
+int recv_client_datagrams(int sock, recv_batch *batch, client_datagram *datagrams) {
+    for (unsigned i = 0; i < RECV_BATCH_SIZE; i++) {
+        batch->headers[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in6); // Changed by each reception
+    }
+    int nb_received = recvmmsg(sock, batch->headers, RECV_BATCH_SIZE, MSG_WAITFORONE, NULL);
+    if (nb_received < 0) {
+        if (errno != EINTR) {
+            perror("recvmmsg game actions");
+        }
+        return -1;
     }
-    return res;
-}
-
-game_action *recv_game_action(int sock) {
-    char *head = recv_string_udp(sock, sizeof(game_action));
-    RETURN_NULL_IF_NULL(head);
-
-    game_action *deserialized_head = deserialize_game_action(head);
-    free(head);
-    return deserialized_head;
-}
 
-int recv_tcp(int sock, void *buffer, int size) {
-    int received = 0;
-    while (received < size) {
-        int res = recv(sock, (char *)buffer + received, size - received, 0);
-        if (res < 0) {
-            perror("recv tcp");
-            return EXIT_FAILURE;
+    int nb_datagrams = 0;
+    for (int i = 0; i < nb_received; i++) {
+        // Datagrams of another size are neither game actions nor keyframe requests
+        if (batch->headers[i].msg_len != GAME_ACTION_SIZE || (batch->headers[i].msg_hdr.msg_flags & MSG_TRUNC)) {
+            continue;
+        }
+        client_datagram *datagram = &datagrams[nb_datagrams];
+        if (deserialize_game_action_into(batch->slots[i], &datagram->action) == EXIT_SUCCESS) {
+            datagram->type = ACTION_DATAGRAM;
+            datagram->token = datagram->action.token;
+            datagram->id = datagram->action.id;
+            datagram->source = batch->sources[i];
+            nb_datagrams++;
+            continue;
         }
-        if (res == 0) {
-            perror("recv tcp: connection closed");
-            return EXIT_FAILURE;
+        keyframe_request request;
+        bool is_region;
+        if (deserialize_keyframe_request_into(batch->slots[i], &request, &is_region) == EXIT_SUCCESS) {
+            datagram->type = is_region ? REGION_REQUEST_DATAGRAM : BOARD_REQUEST_DATAGRAM;
+            datagram->token = request.token;
+            datagram->id = request.id;
+            datagram->source = batch->sources[i];
+            nb_datagrams++;
         }
-        received += res;
     }
-    return EXIT_SUCCESS;
+    return nb_datagrams;
 }
-
-chat_message *recv_chat_message(int sock) {
-    uint16_t header;
-    int res = recv_tcp(sock, &header, sizeof(uint16_t));
-    RETURN_NULL_IF_NEG_PERROR(res, "recv chat_message header");
-
-    uint8_t length;
-    res = recv_tcp(sock, &length, sizeof(uint8_t));
-    RETURN_NULL_IF_NEG_PERROR(res, "recv chat_message length");
-
-    char *message = malloc(length);
-    RETURN_NULL_IF_NULL_PERROR(message, "malloc chat_message message");
-    res = recv_tcp(sock, message, length * sizeof(char));
-    if (res < 0) {
-        perror("recv chat_message message");
-        free(message);
-        return NULL;
-    }
-
-    // Allocate memory for the total received message
-    char *total_received = malloc(3 + length);
-    if (total_received == NULL) {
-        perror("malloc chat_message total_received");
-        free(message);
-        return NULL;
-    }
-
-    // Copy the header, length and message into the total received message
-    memcpy(total_received, &header, 2);
-    memcpy(total_received + 2, &length, 1);
-    memcpy(total_received + 3, message, length);
-
-    // Deserialize the chat message
-    chat_message *msg = client_deserialize_chat_message(total_received);
-    if (msg == NULL) {
-        perror("deserialize chat_message");
-        free(total_received);
-        free(message);
-        return NULL;
-    }
-
-    free(total_received);
-    free(message);
-
-    return msg;
-}
\ No newline at end of file
@@ -4,19 +4,70 @@
 #ifndef SRC_COMMUNICATION_SERVER_H_
 #define SRC_COMMUNICATION_SERVER_H_
 
+#include "./egress.h"
 #include "./messages.h"
 #include "./model.h"
+#include "./tcp_output.h"
 
-int send_connexion_information(int sock, GAME_MODE mode, int id, int eq, int port_udp, int portmdiff,
-                               uint16_t adrmdiff[8]);
-int send_game_board(int sock, struct sockaddr_in6 *addr_mult, uint16_t num, board *board_);
-int send_game_update(int sock, struct sockaddr_in6 *addr_mult, int num, tile_diff *diff, uint8_t nb);
-int send_chat_message(int sock, chat_message_type type, int id, int eq, uint8_t message_length, char *message);
-int send_game_over(int sock, GAME_MODE mode, int id, int eq);
-
-initial_connection_header *recv_initial_connection_header(int sock);
-ready_connection_header *recv_ready_connexion_header(int sock);
-game_action *recv_game_action(int sock);
-chat_message *recv_chat_message(int sock);
+// The messages to a client are sent on its TCP output without blocking, see send_tcp_output
+int send_connexion_information(tcp_output *out, GAME_MODE mode, int id, int eq, int port_udp, int portmdiff,
+                               uint16_t adrmdiff[8], uint32_t token, game_transport transport);
+// The game datagrams are only queued in egress, they are sent when it is flushed at the end of the tick
+
+/** Receivers of a game datagram: a multicast group, of the game or of a region, or the clients themselves in
+ * unicast, each one within max_queued bytes
+ */
+typedef struct game_destination {
+    const struct sockaddr_in6 *group; // NULL in unicast
+    egress_receiver *const *receivers;
+    unsigned nb_receivers;
+    size_t max_queued;
+} game_destination;
+
+/** Sends the whole board in a single message, or in bands if it has more than UINT8_MAX tiles per side
+ */
+int send_game_board(egress_queue *egress, const game_destination *dest, uint16_t num, board *board_);
+/** Sends the tiles of a region of a large board to the receivers of the region
+ */
+int send_game_region(egress_queue *egress, const game_destination *dest, uint16_t num, const board *board_,
+                     int region);
+/** Sends an update already serialized, so that the ticks do not allocate
+ */
+int send_game_update(egress_queue *egress, const game_destination *dest, char *update, size_t update_length);
+int send_chat_message(tcp_output *out, chat_message_type type, int id, int eq, uint8_t message_length,
+                      const char *message);
+int send_game_over(tcp_output *out, GAME_MODE mode, int id, int eq);
+
+#define RECV_BATCH_SIZE 32
+
+/** Preallocated slots receiving a batch of datagrams in a single system call
+ */
+typedef struct recv_batch recv_batch;
+
+recv_batch *create_recv_batch();
+
+void free_recv_batch(recv_batch *batch);
+
+typedef enum client_datagram_type {
+    ACTION_DATAGRAM,
+    BOARD_REQUEST_DATAGRAM,  // Keyframe request of the whole board
+    REGION_REQUEST_DATAGRAM, // Keyframe request of a region
+} client_datagram_type;
+
+/** Datagram of a player on the UDP port of the actions, game action or keyframe request
+ */
+typedef struct client_datagram {
+    client_datagram_type type;
+    uint32_t token;             // Session token of the game
+    int id;                     // Player who sent the datagram
+    struct sockaddr_in6 source; // Where the game messages of the player go in unicast
+    game_action action;         // Only for the game actions
+} client_datagram;
+
+/** Waits for datagrams and receives all those already there, up to RECV_BATCH_SIZE, with one recvmmsg call
+ * The valid ones are written in datagrams, which must have RECV_BATCH_SIZE slots
+ * Returns the number of valid datagrams, -1 in case of error
+ */
+int recv_client_datagrams(int sock, recv_batch *batch, client_datagram *datagrams);
 
 #endif // SRC_COMMUNICATION_SERVER_H_
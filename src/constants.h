@@ -6,10 +6,12 @@
 
 #define MIN_GAMEBOARD_WIDTH 10
 #define MIN_GAMEBOARD_HEIGHT 10
+#define MAX_GAMEBOARD_WIDTH 1024 // Within a band of a whole board, see GAME_BOARD_BAND_TILES
+#define MAX_GAMEBOARD_HEIGHT 1024
 #define GAMEBOARD_WIDTH 52
 #define GAMEBOARD_HEIGHT 25
 #define DESTRUCTIBLE_WALL_CHANCE 20
-#define BOMB_LIFETIME 3 // in seconds
+#define BOMB_LIFETIME 3000 // in milliseconds
 
 #define TEXT_SIZE 60
 #define MAX_CHAT_HISTORY_LEN 23
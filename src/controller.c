@@ -5,9 +5,11 @@
 #include "./view.h"
 #include "chat_model.h"
 #include "model.h"
+#include "update_stream.h"
 
+#include <errno.h>
 #include <ncurses.h>
-#include <pthread.h>
+#include <poll.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -30,20 +32,18 @@
 #define BLUE_COLOR "\033[34m"
 #define YELLOW_COLOR "\033[33m"
 
-static board *game_board = NULL;
-static pthread_mutex_t game_board_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define MAX_GAME_MESSAGES_PER_WAKE 256 // Received before the keys are read and the game is drawn again
 
+// The client loop is the only thread of the game, nothing needs a lock
+static board *game_board = NULL;
 static chat *client_chat = NULL;
-static pthread_mutex_t chat_mutex = PTHREAD_MUTEX_INITIALIZER;
-
 static bool is_game_end = false;
-static pthread_mutex_t game_end_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool has_changed = true;                         // Something to draw since the game was last drawn
+static long frame_interval = 1000 / DEFAULT_FRAME_RATE; // in ms, shortest time between two drawings
+static long last_frame = -1;                            // in ms, when the game was last drawn
 
 static int winner_team = -1;
-static pthread_mutex_t winner_team_mutex = PTHREAD_MUTEX_INITIALIZER;
-
 static int winner_player = -1;
-static pthread_mutex_t winner_player_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static GAME_MODE game_mode = SOLO;
 static int player_id = 0;
@@ -51,7 +51,25 @@ static int player_id = 0;
 static int message_number = 0;
 static int eq = 0;
 
-static pthread_mutex_t view_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char game_message[MAX_GAME_MESSAGE_SIZE];
+static char game_tiles[UINT8_MAX * UINT8_MAX]; // Unpacked tiles of game_message, or of a band
+static update_stream game_updates;
+static char chat_message_buffer[CHAT_MESSAGE_SIZE(UINT8_MAX) + 1];
+
+#define REGION_LOOKUP_PERIOD 200 // in ms, how often the region of the player is looked for on a large board
+
+/** Regions of a large board whose groups are joined, each one with its own updates
+ */
+static struct {
+    unsigned nb;
+    int regions[MAX_SUBSCRIBED_REGIONS];
+    update_stream *streams[MAX_SUBSCRIBED_REGIONS];
+    long last_lookup; // in ms, -1 before the first lookup
+} subscriptions = {0, {0}, {NULL}, -1};
+
+void set_frame_rate(unsigned frame_rate) {
+    frame_interval = 1000 / frame_rate;
+}
 
 void init_controller() {
     intrflush(stdscr, FALSE); /* No need to flush when intr key is pressed */
@@ -66,6 +84,7 @@ void init_controller() {
     for (int i = 0; i < game_board->dim.height * game_board->dim.width; i++) {
         game_board->grid[i] = EMPTY;
     }
+    init_update_stream(&game_updates);
     client_chat = create_chat();
     RETURN_IF_NULL_PERROR(client_chat, "create_chat");
 }
@@ -135,22 +154,12 @@ CHAT_ACTION key_press_to_chat_action(int c) {
     return a;
 }
 
-int mutex_getch() {
-    int c;
-    pthread_mutex_lock(&view_mutex);
-    c = getch();
-    pthread_mutex_unlock(&view_mutex);
-    return c;
-}
-
 int get_pressed_key() {
     int c;
     int prev_c = ERR;
-    while ((c = mutex_getch()) != ERR) { // getch returns the first key press in the queue
+    while ((c = getch()) != ERR) { // getch returns the first key press in the queue
         if (prev_c != ERR && prev_c != c) {
-            pthread_mutex_lock(&view_mutex);
             ungetch(c); // put 'c' back in the queue
-            pthread_mutex_unlock(&view_mutex);
             break;
         }
         prev_c = c;
@@ -158,6 +167,14 @@ int get_pressed_key() {
     return prev_c;
 }
 
+/** Ends the game on the side of the client, the sockets are closed */
+void leave_game() {
+    is_game_end = true;
+    close_socket_tcp();
+    close_socket_udp();
+    close_socket_diff();
+}
+
 bool perform_chat_action(int c) {
     CHAT_ACTION a = key_press_to_chat_action(c);
     switch (a) {
@@ -190,12 +207,7 @@ bool perform_chat_action(int c) {
             set_chat_focus(client_chat, false);
             break;
         case CHAT_GAME_QUIT:
-            pthread_mutex_lock(&game_end_mutex);
-            is_game_end = true;
-            pthread_mutex_unlock(&game_end_mutex);
-            close_socket_tcp();
-            close_socket_udp();
-            close_socket_diff();
+            leave_game();
             return true;
         case CHAT_NONE:
             break;
@@ -231,12 +243,7 @@ bool perform_game_action(int c) {
             set_chat_focus(client_chat, true);
             break;
         case GAME_QUIT:
-            pthread_mutex_lock(&game_end_mutex);
-            is_game_end = true;
-            close_socket_tcp();
-            close_socket_udp();
-            close_socket_diff();
-            pthread_mutex_unlock(&game_end_mutex);
+            leave_game();
             return true;
         case GAME_NONE:
             break;
@@ -245,9 +252,7 @@ bool perform_game_action(int c) {
     return false;
 }
 
-bool control() {
-    int c = get_pressed_key();
-
+bool control(int c) {
     if (is_chat_on_focus(client_chat)) {
         if (perform_chat_action(c)) {
             return true;
@@ -273,250 +278,321 @@ int init_game(int player_nb, int eq_, GAME_MODE mode) {
     return EXIT_SUCCESS;
 }
 
-board *get_board() {
-    board *b = malloc(sizeof(board));
-    RETURN_NULL_IF_NULL_PERROR(b, "malloc board");
-
-    pthread_mutex_lock(&game_board_mutex);
-    b->dim = game_board->dim;
-    b->grid = malloc(b->dim.height * b->dim.width);
-    if (b->grid == NULL) {
-        pthread_mutex_unlock(&game_board_mutex);
-        free(b);
-        return NULL;
+/** Returns the stream of the updates of a region, NULL if the region is not subscribed */
+update_stream *get_region_stream(int region) {
+    for (unsigned i = 0; i < subscriptions.nb; i++) {
+        if (subscriptions.regions[i] == region) {
+            return subscriptions.streams[i];
+        }
     }
-    for (int i = 0; i < b->dim.height * b->dim.width; i++) {
-        b->grid[i] = game_board->grid[i];
+    return NULL;
+}
+
+/** Looks for the tile of the player in the area, returns false if it is not there */
+bool find_player_in_area(char player, coord origin, dimension area, coord *position) {
+    for (int y = origin.y; y < origin.y + area.height; y++) {
+        for (int x = origin.x; x < origin.x + area.width; x++) {
+            if (game_board->grid[y * game_board->dim.width + x] == player) {
+                *position = (coord){x, y};
+                return true;
+            }
+        }
     }
-    pthread_mutex_unlock(&game_board_mutex);
+    return false;
+}
 
-    return b;
+/** Looks for the player in the subscribed regions first, where it usually stays, then in the whole board */
+bool find_player(const region_grid *grid, coord *position) {
+    char player = PLAYER_1 + player_id;
+    for (unsigned i = 0; i < subscriptions.nb; i++) {
+        coord origin;
+        dimension area;
+        get_region_area(grid, subscriptions.regions[i], &origin, &area);
+        if (find_player_in_area(player, origin, area, position)) {
+            return true;
+        }
+    }
+    return find_player_in_area(player, (coord){0, 0}, game_board->dim, position);
 }
 
-void update_board(board *b, TILE *grid, int width, int height) {
-    b->dim.width = width;
-    b->dim.height = height;
-    b->grid = malloc(b->dim.height * b->dim.width);
+void unsubscribe_region(unsigned i) {
+    set_region_subscription(subscriptions.regions[i], false);
+    free_update_stream(subscriptions.streams[i]);
+    free(subscriptions.streams[i]);
 
-    for (int i = 0; i < b->dim.height * b->dim.width; i++) {
-        b->grid[i] = grid[i];
-    }
+    subscriptions.nb--;
+    subscriptions.regions[i] = subscriptions.regions[subscriptions.nb];
+    subscriptions.streams[i] = subscriptions.streams[subscriptions.nb];
 }
 
-void update_tile_diff(board *b, tile_diff *diff, int size) {
-    for (int i = 0; i < size; i++) {
-        int pos = diff[i].y * b->dim.width + diff[i].x;
-        b->grid[pos] = diff[i].tile;
+void subscribe_region(const region_grid *grid, int region) {
+    update_stream *stream = malloc(sizeof(update_stream));
+    RETURN_IF_NULL_PERROR(stream, "malloc region stream");
+    if (set_region_subscription(region, true) != EXIT_SUCCESS) {
+        free(stream);
+        return;
     }
+
+    init_region_stream(stream, grid, region);
+    subscriptions.regions[subscriptions.nb] = region;
+    subscriptions.streams[subscriptions.nb] = stream;
+    subscriptions.nb++;
 }
 
-/** Updates the game board based on the server MESSAGE*/
-void *game_board_info_thread_function() {
-    while (true) {
-        pthread_mutex_lock(&game_end_mutex);
-        if (is_game_end) {
-            pthread_mutex_unlock(&game_end_mutex);
-            break;
-        }
-        pthread_mutex_unlock(&game_end_mutex);
+/** Follows the player on a large board, only the regions around it are received
+ * The regions are subscribed once the whole board has been received, and ask for a whole region when an update
+ * of theirs is missing
+ */
+void update_region_subscriptions(long now) {
+    if (!game_updates.synced || !IS_LARGE_BOARD(game_board->dim.height, game_board->dim.width)) {
+        return;
+    }
 
-        // Check if connection is still alive
-        if (has_server_disconnected_tcp()) {
-            close_socket_tcp();
-            close_socket_udp();
-            close_socket_diff();
-            pthread_mutex_lock(&game_end_mutex);
-            is_game_end = true;
-            pthread_mutex_unlock(&game_end_mutex);
-            break;
+    for (unsigned i = 0; i < subscriptions.nb; i++) {
+        if (should_request_keyframe(subscriptions.streams[i], now)) {
+            send_region_keyframe_request(subscriptions.regions[i]);
         }
+    }
+
+    if (subscriptions.last_lookup != -1 && now - subscriptions.last_lookup < REGION_LOOKUP_PERIOD) {
+        return;
+    }
+    subscriptions.last_lookup = now;
+
+    region_grid grid;
+    init_region_grid(&grid, game_board->dim);
+    coord position;
+    if (!find_player(&grid, &position)) {
+        return; // The subscriptions are kept while the player is not on the board
+    }
 
-        received_game_message *received_message = recv_game_message();
-        if (received_message == NULL || received_message->message == NULL) {
-            // TODO: Handle error
-            continue;
+    int wanted[MAX_SUBSCRIBED_REGIONS];
+    unsigned nb_wanted = get_regions_around(&grid, position.x, position.y, wanted);
+    for (unsigned i = 0; i < subscriptions.nb;) {
+        bool is_wanted = false;
+        for (unsigned j = 0; j < nb_wanted; j++) {
+            is_wanted = is_wanted || wanted[j] == subscriptions.regions[i];
         }
-        switch (received_message->type) {
-            case GAME_BOARD_INFORMATION:
-                game_board_information *info = deserialize_game_board(received_message->message);
-                pthread_mutex_lock(&game_board_mutex);
-                update_board(game_board, info->board, info->width, info->height);
-                pthread_mutex_unlock(&game_board_mutex);
-                free_game_board_information(info);
-                break;
-            case GAME_BOARD_UPDATE:
-                game_board_update *update = deserialize_game_board_update(received_message->message);
-                pthread_mutex_lock(&game_board_mutex);
-                update_tile_diff(game_board, update->diff, update->nb);
-                pthread_mutex_unlock(&game_board_mutex);
-                free_game_board_update(update);
-                break;
-            default:
-                printf("Unknown message type\n");
-                /* TODO: Handle error */
-                break;
+        if (is_wanted) {
+            i++;
+        } else {
+            unsubscribe_region(i); // The last subscription takes its place
+        }
+    }
+    for (unsigned j = 0; j < nb_wanted; j++) {
+        if (get_region_stream(wanted[j]) == NULL) {
+            subscribe_region(&grid, wanted[j]);
         }
-        free(received_message->message);
-
-        board *b = get_board();
-        pthread_mutex_lock(&view_mutex);
-        refresh_game(game_mode, b, client_chat, player_id);
-        pthread_mutex_unlock(&view_mutex);
-        free_board(b);
     }
+}
 
-    printf("Game board info thread ended\n");
-    return NULL;
+void free_region_subscriptions() {
+    for (unsigned i = 0; i < subscriptions.nb; i++) {
+        free_update_stream(subscriptions.streams[i]);
+        free(subscriptions.streams[i]);
+    }
+    subscriptions.nb = 0;
 }
 
-void *chat_message_thread_function() {
-    while (true) {
-        pthread_mutex_lock(&game_end_mutex);
-        if (is_game_end) {
-            pthread_mutex_unlock(&game_end_mutex);
+/** Applies a game message of game_message to the board */
+void handle_game_message(game_message_type type, int size) {
+    switch (type) {
+        case GAME_BOARD_INFORMATION:
+            game_board_view info;
+            if (deserialize_game_board_into(game_message, size, game_tiles, sizeof(game_tiles), &info) !=
+                EXIT_SUCCESS) {
+                return;
+            }
+            apply_keyframe(&game_updates, game_board, &info);
             break;
-        }
-        pthread_mutex_unlock(&game_end_mutex);
-
-        // Check if connection is still alive
-        if (has_server_disconnected_tcp()) {
-            close_socket_tcp();
-            close_socket_udp();
-            close_socket_diff();
-            pthread_mutex_lock(&game_end_mutex);
-            is_game_end = true;
-            pthread_mutex_unlock(&game_end_mutex);
+        case GAME_BOARD_BAND:
+            game_board_band_view band;
+            if (deserialize_game_board_band_into(game_message, size, game_tiles, sizeof(game_tiles), &band) !=
+                EXIT_SUCCESS) {
+                return;
+            }
+            apply_keyframe_band(&game_updates, game_board, &band);
             break;
-        }
-
-        u_int16_t header = recv_header_from_server();
-        char *header_char = (char *)&header;
-
-        game_end *game_end_header = deserialize_game_end(header_char);
-
-        if (game_end_header != NULL) {
-            if (game_end_header->game_mode == game_mode) {
-                if (game_mode == SOLO) {
-                    pthread_mutex_lock(&winner_player_mutex);
-                    winner_player = game_end_header->id;
-                    pthread_mutex_unlock(&winner_player_mutex);
-                }
-
-                if (game_mode == TEAM) {
-                    pthread_mutex_lock(&winner_team_mutex);
-                    winner_team = game_end_header->eq;
-                    pthread_mutex_unlock(&winner_team_mutex);
-                }
+        case GAME_REGION:
+            game_region_view region;
+            if (deserialize_game_region_into(game_message, size, game_tiles, sizeof(game_tiles), &region) !=
+                EXIT_SUCCESS) {
+                return;
+            }
+            update_stream *region_stream = get_region_stream(region.region);
+            if (region_stream == NULL) {
+                return; // Subscribed by another client of the host
+            }
+            apply_region_keyframe(region_stream, game_board, &region);
+            break;
+        case GAME_BOARD_UPDATE:
+            game_board_update_view update;
+            if (deserialize_game_board_update_view(game_message, size, &update) != EXIT_SUCCESS) {
+                return;
+            }
+            update_stream *stream = update.region == -1 ? &game_updates : get_region_stream(update.region);
+            if (stream == NULL) {
+                return;
+            }
+            apply_update(stream, game_board, game_message, size);
+            break;
+        default:
+            printf("Unknown message type\n");
+            /* TODO: Handle error */
+            return;
+    }
+    has_changed = true;
+}
 
-                pthread_mutex_lock(&game_end_mutex);
-                is_game_end = true;
-                pthread_mutex_unlock(&game_end_mutex);
+/** Applies the game messages already received, at most MAX_GAME_MESSAGES_PER_WAKE so that the keys are not delayed
+ */
+void receive_game_messages() {
+    for (unsigned i = 0; i < MAX_GAME_MESSAGES_PER_WAKE; i++) {
+        game_message_type type;
+        int size = recv_game_message(game_message, MAX_GAME_MESSAGE_SIZE, &type);
+        if (size == 0) {
+            return;
+        }
+        if (size > 0) {
+            handle_game_message(type, size);
+        }
+    }
+}
 
-                // TODO: CHECK IF ERROR : shutdown_tcp_on_write();
-                close_socket_tcp();
-                close_socket_udp();
-                close_socket_diff();
+/** Receives a message of the server on the TCP connection, a chat message or the end of the game, which also comes
+ * when the server leaves
+ */
+void receive_server_message() {
+    u_int16_t header = recv_header_from_server();
+    if (header == 0) {
+        leave_game(); // The server has left
+        return;
+    }
 
-                free(game_end_header);
-                break;
-            }
+    game_end game_end_header;
+    if (deserialize_game_end_into((char *)&header, &game_end_header) == EXIT_SUCCESS &&
+        game_end_header.game_mode == game_mode) {
+        if (game_mode == SOLO) {
+            winner_player = game_end_header.id;
         }
-
-        chat_message *chat_msg = recv_chat_message_from_server(header);
-        if (chat_msg != NULL) {
-            pthread_mutex_lock(&chat_mutex);
-            if (chat_msg->type == GLOBAL_M) {
-                add_message_from_server(client_chat, chat_msg->id, chat_msg->message, false);
-            } else if (chat_msg->type == TEAM_M) {
-                add_message_from_server(client_chat, chat_msg->id, chat_msg->message, true);
-            }
-            pthread_mutex_unlock(&chat_mutex);
-            free(chat_msg->message);
-            free(chat_msg);
+        if (game_mode == TEAM) {
+            winner_team = game_end_header.eq;
         }
-
-        board *b = get_board();
-        pthread_mutex_lock(&view_mutex);
-        refresh_game(game_mode, b, client_chat, player_id);
-        pthread_mutex_unlock(&view_mutex);
-        free_board(b);
+        // TODO: CHECK IF ERROR : shutdown_tcp_on_write();
+        leave_game();
+        return;
     }
 
-    close_socket_tcp();
-    close_socket_udp();
-    close_socket_diff();
+    chat_message_view chat_msg;
+    if (recv_chat_message_from_server(header, chat_message_buffer, sizeof(chat_message_buffer), &chat_msg) ==
+        EXIT_SUCCESS) {
+        // The text is `\0` terminated in the buffer
+        if (chat_msg.type == GLOBAL_M) {
+            add_message_from_server(client_chat, chat_msg.id, chat_msg.message, false);
+        } else if (chat_msg.type == TEAM_M) {
+            add_message_from_server(client_chat, chat_msg.id, chat_msg.message, true);
+        }
+        has_changed = true;
+    }
+}
 
-    printf("Chat message thread ended\n");
-    return NULL;
+/** Performs the keys pressed since the last wake up */
+void read_keys() {
+    int c;
+    while (!is_game_end && (c = get_pressed_key()) != ERR) {
+        control(c);
+        has_changed = true;
+    }
 }
 
 void print_result() {
     if (game_mode == SOLO) {
-        pthread_mutex_lock(&winner_player_mutex);
         if (winner_player == player_id) {
             printf(GREEN_COLOR "You won\n" RESET_COLOR);
         } else {
             printf(RED_COLOR "You lost\n" RESET_COLOR);
             printf(YELLOW_COLOR "Winner player: %d\n" RESET_COLOR, winner_player + 1);
         }
-        pthread_mutex_unlock(&winner_player_mutex);
     }
 
     if (game_mode == TEAM) {
-        pthread_mutex_lock(&winner_team_mutex);
         if (winner_team == eq) {
             printf(GREEN_COLOR "Your team won\n" RESET_COLOR);
         } else {
             printf(RED_COLOR "Your team lost\n" RESET_COLOR);
             printf(YELLOW_COLOR "Winner team: %d\n" RESET_COLOR, winner_team);
         }
-        pthread_mutex_unlock(&winner_team_mutex);
     }
 
     printf(BLUE_COLOR "Game Ended\n" RESET_COLOR);
 }
 
-/** Sends to the server the performed action*/
-void *view_thread_function() {
-    while (true) {
-        pthread_mutex_lock(&game_end_mutex);
-        if (is_game_end) {
-            pthread_mutex_unlock(&game_end_mutex);
-            break;
-        }
-        pthread_mutex_unlock(&game_end_mutex);
+typedef enum client_poll_fd { GAME_MESSAGES_FD, SERVER_MESSAGES_FD, KEYS_FD, NB_CLIENT_POLL_FDS } client_poll_fd;
 
-        control();
+/** Draws the game if something changed and the last drawing is at least frame_interval old
+ * Returns how long to wait for the next drawing, in ms, -1 if there is nothing to draw
+ */
+long draw_frame(long now) {
+    if (!has_changed) {
+        return -1;
     }
-
-    printf("View thread ended\n");
-
-    return NULL;
+    long next_frame = last_frame + frame_interval;
+    if (last_frame != -1 && now < next_frame) {
+        return next_frame - now;
+    }
+    refresh_game(game_mode, game_board, client_chat, player_id);
+    has_changed = false;
+    last_frame = now;
+    return -1;
 }
 
+/** Waits for the game messages, the messages of the server and the keys together, the game is only drawn again when
+ * one of them changed something, at most once per frame_interval so that the bursts of messages are drawn together
+ * The loop also wakes up every GAME_MESSAGE_TIMEOUT ms to ask for the whole boards or regions missing
+ */
 int game_loop() {
     RETURN_FAILURE_IF_NULL(game_board);
 
-    pthread_t game_board_info_thread;
-    if (pthread_create(&game_board_info_thread, NULL, game_board_info_thread_function, NULL) != 0) {
-        return EXIT_FAILURE;
-    }
+    struct pollfd fds[NB_CLIENT_POLL_FDS];
+    fds[GAME_MESSAGES_FD] = (struct pollfd){.fd = get_game_message_socket(), .events = POLLIN};
+    fds[SERVER_MESSAGES_FD] = (struct pollfd){.fd = get_server_socket(), .events = POLLIN};
+    fds[KEYS_FD] = (struct pollfd){.fd = STDIN_FILENO, .events = POLLIN};
 
-    pthread_t chat_message_thread;
-    if (pthread_create(&chat_message_thread, NULL, chat_message_thread_function, NULL) != 0) {
-        return EXIT_FAILURE;
-    }
+    while (!is_game_end) {
+        long frame_wait = draw_frame(get_time_ms());
+        int timeout = frame_wait >= 0 && frame_wait < GAME_MESSAGE_TIMEOUT ? (int)frame_wait : GAME_MESSAGE_TIMEOUT;
 
-    pthread_t view_thread;
-    if (pthread_create(&view_thread, NULL, view_thread_function, NULL) != 0) {
-        return EXIT_FAILURE;
-    }
+        int nb_ready = poll(fds, NB_CLIENT_POLL_FDS, timeout);
+        if (nb_ready < 0 && errno != EINTR) {
+            perror("poll client");
+            leave_game();
+            break;
+        }
+
+        bool has_game_messages = nb_ready > 0 && (fds[GAME_MESSAGES_FD].revents & POLLIN);
+        bool has_server_message = nb_ready > 0 && (fds[SERVER_MESSAGES_FD].revents & (POLLIN | POLLHUP | POLLERR));
+        bool has_keys = nb_ready > 0 && (fds[KEYS_FD].revents & POLLIN);
 
-    pthread_join(game_board_info_thread, NULL);
-    pthread_join(chat_message_thread, NULL);
-    pthread_join(view_thread, NULL);
+        if (has_game_messages) {
+            receive_game_messages();
+        }
+        long now = get_time_ms();
+        if (should_request_keyframe(&game_updates, now)) {
+            send_keyframe_request(game_updates.expected_num);
+        }
+        update_region_subscriptions(now);
+
+        if (has_server_message) {
+            receive_server_message();
+        }
+        if (has_keys && !is_game_end) {
+            read_keys();
+        }
+    }
 
     free_board(game_board);
+    free_update_stream(&game_updates);
+    free_region_subscriptions();
     free_chat(client_chat);
     end_view();
     print_result();
@@ -4,6 +4,14 @@
 #include "./model.h"
 #include <stdbool.h>
 
+#define DEFAULT_FRAME_RATE 60 // in frames per second
+#define MIN_FRAME_RATE 1
+#define MAX_FRAME_RATE 240
+
+/** Sets how many times per second the game is drawn at most, the changes in between are drawn together
+ */
+void set_frame_rate(unsigned frame_rate);
+
 /** Initialize view, controller and model to start a game
  */
 int init_game(int id, int eq, GAME_MODE);
@@ -0,0 +1,216 @@
+#define _GNU_SOURCE // sendmmsg
+
+#include "egress.h"
+#include "utils.h"
+
+#include <errno.h>
+#include <netinet/udp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+struct egress_queue {
+    int sock;
+    bool gso;
+
+    char buffer[EGRESS_BUFFER_SIZE]; // The datagrams of a message are contiguous
+    size_t used;
+
+    unsigned nb_messages;
+    struct mmsghdr headers[EGRESS_BATCH_SIZE];
+    struct iovec iovecs[EGRESS_BATCH_SIZE];
+    struct sockaddr_in6 addrs[EGRESS_BATCH_SIZE];
+    int socks[EGRESS_BATCH_SIZE];            // Socket of each message
+    size_t segment_sizes[EGRESS_BATCH_SIZE]; // Size of the first datagram of each message
+    unsigned nb_segments[EGRESS_BATCH_SIZE];
+    char controls[EGRESS_BATCH_SIZE][CMSG_SPACE(sizeof(uint16_t))];
+
+    unsigned long datagrams; // Queued since the creation of the queue
+    unsigned long syscalls;  // Calls to sendmmsg since the creation of the queue
+};
+
+egress_queue *create_egress_queue(int sock, bool use_gso) {
+    egress_queue *queue = malloc(sizeof(egress_queue));
+    RETURN_NULL_IF_NULL_PERROR(queue, "malloc egress_queue");
+
+    queue->sock = sock;
+    queue->gso = false;
+#ifdef UDP_SEGMENT
+    int no_segment = 0; // The size is given per message, this only checks that the kernel knows the option
+    queue->gso = use_gso && setsockopt(sock, SOL_UDP, UDP_SEGMENT, &no_segment, sizeof(no_segment)) == 0;
+#else
+    (void)use_gso;
+#endif
+    queue->used = 0;
+    queue->nb_messages = 0;
+    queue->datagrams = 0;
+    queue->syscalls = 0;
+    return queue;
+}
+
+void free_egress_queue(egress_queue *queue) {
+    free(queue);
+}
+
+static bool is_same_address(const struct sockaddr_in6 *a, const struct sockaddr_in6 *b) {
+    return a->sin6_port == b->sin6_port && a->sin6_scope_id == b->sin6_scope_id &&
+           memcmp(&a->sin6_addr, &b->sin6_addr, sizeof(a->sin6_addr)) == 0;
+}
+
+/** The datagram extends the last message if the kernel can split them again: same address, every datagram of the
+ * message as large as the first one, except the last one which may be smaller
+ */
+static bool can_extend_last_message(const egress_queue *queue, const struct sockaddr_in6 *addr, size_t size) {
+    if (!queue->gso || queue->nb_messages == 0) {
+        return false;
+    }
+    unsigned last = queue->nb_messages - 1;
+    size_t segment_size = queue->segment_sizes[last];
+    size_t length = queue->iovecs[last].iov_len;
+    return queue->socks[last] == queue->sock && is_same_address(&queue->addrs[last], addr) && size <= segment_size &&
+           segment_size <= EGRESS_MAX_SEGMENT_SIZE && length == queue->nb_segments[last] * segment_size &&
+           queue->nb_segments[last] < EGRESS_MAX_SEGMENTS && length + size <= EGRESS_MAX_MESSAGE_SIZE;
+}
+
+int queue_datagram(egress_queue *queue, const struct sockaddr_in6 *addr, const char *datagram, size_t size) {
+    if (size > EGRESS_MAX_MESSAGE_SIZE) {
+        return EXIT_FAILURE;
+    }
+    if (queue->used + size > EGRESS_BUFFER_SIZE || queue->nb_messages == EGRESS_BATCH_SIZE) {
+        flush_egress_queue(queue);
+    }
+
+    // Only the last message ends at the end of the used buffer, so that its datagrams stay contiguous
+    bool extends = can_extend_last_message(queue, addr, size);
+    memcpy(queue->buffer + queue->used, datagram, size);
+    queue->used += size;
+    queue->datagrams++;
+
+    if (extends) {
+        unsigned last = queue->nb_messages - 1;
+        queue->iovecs[last].iov_len += size;
+        queue->nb_segments[last]++;
+        return EXIT_SUCCESS;
+    }
+
+    unsigned m = queue->nb_messages;
+    queue->iovecs[m].iov_base = queue->buffer + queue->used - size;
+    queue->iovecs[m].iov_len = size;
+    queue->addrs[m] = *addr;
+    queue->socks[m] = queue->sock;
+    queue->segment_sizes[m] = size;
+    queue->nb_segments[m] = 1;
+    queue->nb_messages++;
+    return EXIT_SUCCESS;
+}
+
+int queue_datagram_to_receivers(egress_queue *queue, egress_receiver *const *receivers, unsigned nb_receivers,
+                                size_t max_queued, const char *datagram, size_t size) {
+    if (size > EGRESS_MAX_MESSAGE_SIZE || nb_receivers > EGRESS_BATCH_SIZE) {
+        return EXIT_FAILURE;
+    }
+    if (queue->used + size > EGRESS_BUFFER_SIZE || queue->nb_messages + nb_receivers > EGRESS_BATCH_SIZE) {
+        flush_egress_queue(queue);
+    }
+
+    char *copy = NULL; // Only made if a receiver takes the datagram
+    for (unsigned i = 0; i < nb_receivers; i++) {
+        egress_receiver *receiver = receivers[i];
+        if (receiver->queued + size > max_queued) {
+            receiver->dropped++;
+            continue;
+        }
+        if (copy == NULL) {
+            copy = queue->buffer + queue->used;
+            memcpy(copy, datagram, size);
+            queue->used += size;
+        }
+        receiver->queued += size;
+        queue->datagrams++;
+
+        unsigned m = queue->nb_messages;
+        queue->iovecs[m].iov_base = copy;
+        queue->iovecs[m].iov_len = size;
+        queue->addrs[m] = receiver->addr;
+        queue->socks[m] = receiver->sock != -1 ? receiver->sock : queue->sock;
+        queue->segment_sizes[m] = size;
+        queue->nb_segments[m] = 1;
+        queue->nb_messages++;
+    }
+    return EXIT_SUCCESS;
+}
+
+/** Fills the header of the message m, with its segment size if the kernel has to split it */
+static void prepare_message(egress_queue *queue, unsigned m) {
+    struct msghdr *header = &queue->headers[m].msg_hdr;
+    memset(header, 0, sizeof(struct msghdr));
+    header->msg_name = &queue->addrs[m];
+    header->msg_namelen = sizeof(struct sockaddr_in6);
+    header->msg_iov = &queue->iovecs[m];
+    header->msg_iovlen = 1;
+
+#ifdef UDP_SEGMENT
+    if (queue->nb_segments[m] > 1) {
+        header->msg_control = queue->controls[m];
+        header->msg_controllen = sizeof(queue->controls[m]);
+        struct cmsghdr *control = CMSG_FIRSTHDR(header);
+        control->cmsg_level = SOL_UDP;
+        control->cmsg_type = UDP_SEGMENT;
+        control->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        uint16_t segment_size = queue->segment_sizes[m];
+        memcpy(CMSG_DATA(control), &segment_size, sizeof(segment_size));
+    }
+#endif
+}
+
+int flush_egress_queue(egress_queue *queue) {
+    int res = EXIT_SUCCESS;
+    for (unsigned m = 0; m < queue->nb_messages; m++) {
+        prepare_message(queue, m);
+    }
+
+    unsigned sent = 0;
+    while (sent < queue->nb_messages) {
+        // A call per run of consecutive messages sent on the same socket
+        int sock = queue->socks[sent];
+        unsigned run = 1;
+        while (sent + run < queue->nb_messages && queue->socks[sent + run] == sock) {
+            run++;
+        }
+
+        int nb_sent = sendmmsg(sock, queue->headers + sent, run, MSG_DONTWAIT);
+        queue->syscalls++;
+        if (nb_sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (nb_sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // Waiting for room would delay the next tick of every game, the receivers recover with a whole board
+            fprintf(stderr, "sendmmsg egress: the socket buffer is full, %u messages are dropped\n", run);
+            res = EXIT_FAILURE;
+            nb_sent = run;
+        }
+        if (nb_sent <= 0) {
+            // The first message is refused, the following ones are tried again without it
+            perror("sendmmsg egress");
+            if (queue->nb_segments[sent] > 1) {
+                queue->gso = false; // The kernel or the interface does not split the messages
+            }
+            res = EXIT_FAILURE;
+            nb_sent = 1;
+        }
+        sent += nb_sent;
+    }
+
+    queue->used = 0;
+    queue->nb_messages = 0;
+    return res;
+}
+
+unsigned long get_egress_datagrams(const egress_queue *queue) {
+    return queue->datagrams;
+}
+
+unsigned long get_egress_syscalls(const egress_queue *queue) {
+    return queue->syscalls;
+}
@@ -0,0 +1,64 @@
+#ifndef SRC_EGRESS_H_
+#define SRC_EGRESS_H_
+
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define EGRESS_BATCH_SIZE 256         // Messages sent by a single sendmmsg call
+#define EGRESS_BUFFER_SIZE 262144     // Bytes of the datagrams waiting to be sent, a whole packed board fits many times
+#define EGRESS_MAX_SEGMENTS 64        // Datagrams of a message split by the kernel (UDP_SEGMENT)
+#define EGRESS_MAX_SEGMENT_SIZE 1232  // Largest datagram of a split message, within the minimal MTU of IPv6
+#define EGRESS_MAX_MESSAGE_SIZE 65000 // Bytes of a message, below the largest UDP payload
+
+/** Datagrams collected from all the games during a tick, then sent together with sendmmsg
+ * Where the kernel supports UDP GSO, the consecutive datagrams to the same address with the same size (the bands
+ * of a board, the fragments of an update) are sent as a single message that the kernel splits
+ * The datagrams to the unicast receivers may be sent on other sockets, a sendmmsg call per run of messages on the
+ * same socket
+ * It is only used by one thread
+ */
+typedef struct egress_queue egress_queue;
+
+/** Creates a queue sending on sock, which stays owned by the caller
+ * The kernel segments the messages only if use_gso is true and the socket supports it
+ */
+egress_queue *create_egress_queue(int sock, bool use_gso);
+
+void free_egress_queue(egress_queue *queue);
+
+/** Copies the datagram in the queue, which is flushed first if it is full
+ * Returns EXIT_FAILURE if the datagram is too large for the queue
+ */
+int queue_datagram(egress_queue *queue, const struct sockaddr_in6 *addr, const char *datagram, size_t size);
+
+/** Client receiving the game datagrams in unicast, owned by its game
+ * The bytes queued for it are bounded, so that a client far behind only loses its own datagrams, which it recovers
+ * with a whole board, instead of filling the queue of all the games
+ */
+typedef struct egress_receiver {
+    struct sockaddr_in6 addr;
+    int sock;              // Socket the receiver sends its datagrams to, so that the answers follow the same path,
+                           // -1 for the socket of the queue
+    size_t queued;         // Bytes queued for the receiver since its owner last reset it
+    unsigned long dropped; // Datagrams dropped because the receiver was over its bound
+} egress_receiver;
+
+/** Copies the datagram once in the queue and sends it to each receiver which stays within max_queued bytes, the
+ * messages of the receivers share the copy
+ * Returns EXIT_FAILURE if the datagram is too large for the queue
+ */
+int queue_datagram_to_receivers(egress_queue *queue, egress_receiver *const *receivers, unsigned nb_receivers,
+                                size_t max_queued, const char *datagram, size_t size);
+
+/** Sends all the datagrams of the queue without blocking, the ones the kernel refuses are dropped, as well as all the
+ * remaining ones if the socket buffer is full
+ * Returns EXIT_FAILURE if a datagram was dropped
+ */
+int flush_egress_queue(egress_queue *queue);
+
+/** Number of datagrams queued and of sendmmsg calls since the creation of the queue */
+unsigned long get_egress_datagrams(const egress_queue *queue);
+unsigned long get_egress_syscalls(const egress_queue *queue);
+
+#endif // SRC_EGRESS_H_
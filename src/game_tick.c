@@ -0,0 +1,231 @@
+#include "game_tick.h"
+
+bool is_next_message(int last_num_message, int num_message, int limit) {
+    int just_after = (last_num_message + 1) % limit;
+    int limit_next_message = (last_num_message + 1 + (limit / 2)) % limit;
+
+    if (just_after < limit_next_message) {
+        return num_message >= just_after && num_message < limit_next_message;
+    } else {
+        return (num_message >= just_after && num_message < limit) || (num_message <= limit_next_message);
+    }
+}
+
+unsigned get_player_actions(const game_action *game_actions, size_t nb_game_actions,
+                            int last_num_received_message[PLAYER_NUM], player_action *player_actions) {
+    // The moves fill the buffer from the start and the bombs from the middle
+    player_action *player_moves = player_actions;
+    player_action *player_place_bomb = player_actions + PLAYER_NUM;
+
+    unsigned nb_player_moves = 0;
+    unsigned nb_place_bomb = 0;
+
+    bool already_move[PLAYER_NUM];
+    bool already_place_bomb[PLAYER_NUM];
+    for (unsigned i = 0; i < PLAYER_NUM; i++) {
+        already_move[i] = false;
+        already_place_bomb[i] = false;
+    }
+
+    for (int i = nb_game_actions - 1; i >= 0; i--) {
+        // Other actions were sent before those kept
+        if (nb_player_moves == PLAYER_NUM && nb_place_bomb == PLAYER_NUM) {
+            break;
+        }
+        // Message ignored
+        if (!is_next_message(last_num_received_message[game_actions[i].id], game_actions[i].message_number,
+                             LIMIT_LAST_NUM_MESSAGE_CLIENT)) {
+            continue;
+        }
+        // Keep the action if its a move and there is no move kept for this player
+        if (is_move(game_actions[i].action) && !already_move[game_actions[i].id]) {
+            player_moves[nb_player_moves].id = game_actions[i].id;
+            player_moves[nb_player_moves].action = game_actions[i].action;
+            already_move[game_actions[i].id] = true;
+
+            // To keep the last message number
+            if (!already_place_bomb[game_actions[i].id]) {
+                last_num_received_message[game_actions[i].id] = game_actions[i].message_number;
+            }
+            nb_player_moves++;
+            continue;
+        }
+        // Keep the action if its a place bomb and there is no bomb placing move kept for this player
+        if (game_actions[i].action == GAME_PLACE_BOMB && !already_place_bomb[game_actions[i].id]) {
+            player_place_bomb[nb_place_bomb].id = game_actions[i].id;
+            player_place_bomb[nb_place_bomb].action = game_actions[i].action;
+            already_place_bomb[game_actions[i].id] = true;
+
+            // To keep the last message number
+            if (!already_move[game_actions[i].id]) {
+                last_num_received_message[game_actions[i].id] = game_actions[i].message_number;
+            }
+            nb_place_bomb++;
+        }
+    }
+
+    // The bombs follow the moves directly
+    for (unsigned i = 0; i < nb_place_bomb; i++) {
+        player_moves[nb_player_moves + i] = player_place_bomb[i];
+    }
+
+    return nb_player_moves + nb_place_bomb;
+}
+
+/** Number of bytes of the datagrams of an update of nb differences */
+static size_t get_update_size(unsigned nb) {
+    if (nb <= UINT8_MAX) {
+        return GAME_BOARD_UPDATE_SIZE(nb);
+    }
+    unsigned nb_fragments = (nb + UINT8_MAX - 1) / UINT8_MAX;
+    return nb_fragments * UPDATE_FRAGMENT_HEADER_SIZE + nb * 3;
+}
+
+void init_tick_buffers(tick_buffers *buffers, dimension dim) {
+    buffers->by_regions = IS_LARGE_BOARD(dim.height, dim.width);
+    if (buffers->by_regions) {
+        // Each region falls back to its own keyframe, the whole board is only sent beyond the buffers
+        init_region_grid(&buffers->regions, dim);
+        for (int i = 0; i < get_region_count(&buffers->regions); i++) {
+            buffers->region_nums[i] = 0;
+        }
+        buffers->max_update_diffs = MAX_TICK_DIFFS;
+        return;
+    }
+
+    size_t keyframe_size = get_game_board_keyframe_size(dim.height, dim.width);
+    buffers->max_update_diffs = MAX_UPDATE_FRAGMENTS * UINT8_MAX;
+    while (buffers->max_update_diffs > 0 && get_update_size(buffers->max_update_diffs) > keyframe_size) {
+        buffers->max_update_diffs--;
+    }
+}
+
+static int serialize_update_fragments(uint16_t num, unsigned nb_diffs, tick_buffers *buffers) {
+    if (nb_diffs <= UINT8_MAX) {
+        game_board_update update;
+        update.num = num;
+        update.nb = nb_diffs;
+        update.diff = buffers->diffs;
+        int size = serialize_game_board_update_into(&update, buffers->fragments[0], sizeof(buffers->fragments[0]));
+        if (size < 0) {
+            return -1;
+        }
+        buffers->fragment_sizes[0] = size;
+        return 1;
+    }
+
+    game_board_update_fragment fragment;
+    fragment.num = num;
+    fragment.count = (nb_diffs + UINT8_MAX - 1) / UINT8_MAX;
+    for (int i = 0; i < fragment.count; i++) {
+        unsigned first = i * UINT8_MAX;
+        fragment.index = i;
+        fragment.nb = nb_diffs - first < UINT8_MAX ? nb_diffs - first : UINT8_MAX;
+        fragment.diff = buffers->diffs + first;
+
+        int size =
+            serialize_game_board_update_fragment_into(&fragment, buffers->fragments[i], sizeof(buffers->fragments[i]));
+        if (size < 0) {
+            return -1;
+        }
+        buffers->fragment_sizes[i] = size;
+    }
+    return fragment.count;
+}
+
+/** Sorts the differences by region, in local coordinates, with a counting sort */
+static void split_diffs_by_region(unsigned nb_diffs, tick_buffers *buffers) {
+    int nb_regions = get_region_count(&buffers->regions);
+    for (int r = 0; r <= nb_regions; r++) {
+        buffers->region_starts[r] = 0;
+    }
+    for (unsigned i = 0; i < nb_diffs; i++) {
+        buffers->region_starts[get_region_of_tile(&buffers->regions, buffers->diffs[i].x, buffers->diffs[i].y) + 1]++;
+    }
+    for (int r = 0; r < nb_regions; r++) {
+        buffers->region_starts[r + 1] += buffers->region_starts[r];
+    }
+
+    // region_starts[r] moves to the end of the region r while it is filled, then is restored
+    for (unsigned i = 0; i < nb_diffs; i++) {
+        tile_diff diff = buffers->diffs[i];
+        int region = get_region_of_tile(&buffers->regions, diff.x, diff.y);
+        diff.x %= REGION_SIDE;
+        diff.y %= REGION_SIDE;
+        buffers->region_diffs[buffers->region_starts[region]] = diff;
+        buffers->region_starts[region]++;
+    }
+    for (int r = nb_regions; r > 0; r--) {
+        buffers->region_starts[r] = buffers->region_starts[r - 1];
+    }
+    buffers->region_starts[0] = 0;
+}
+
+static int serialize_region_updates(unsigned nb_diffs, tick_buffers *buffers) {
+    split_diffs_by_region(nb_diffs, buffers);
+
+    unsigned nb_datagrams = 0;
+    size_t offset = 0;
+    buffers->nb_keyframe_regions = 0;
+    for (int r = 0; r < get_region_count(&buffers->regions); r++) {
+        unsigned nb = buffers->region_starts[r + 1] - buffers->region_starts[r];
+        if (nb == 0) {
+            continue;
+        }
+
+        coord origin;
+        dimension area;
+        get_region_area(&buffers->regions, r, &origin, &area);
+        size_t keyframe_size = GAME_REGION_HEADER_SIZE + (area.width * area.height + 1) / 2;
+        if (REGION_UPDATE_SIZE(nb) > keyframe_size) {
+            buffers->keyframe_regions[buffers->nb_keyframe_regions] = r;
+            buffers->nb_keyframe_regions++;
+            continue;
+        }
+
+        game_board_update_fragment fragment;
+        fragment.num = buffers->region_nums[r];
+        fragment.index = 0;
+        fragment.count = 1;
+        fragment.nb = nb;
+        fragment.diff = buffers->region_diffs + buffers->region_starts[r];
+        int size = serialize_region_update_fragment_into(&fragment, r, buffers->region_updates + offset,
+                                                         sizeof(buffers->region_updates) - offset);
+        if (size < 0) {
+            return -1;
+        }
+        buffers->region_datagrams[nb_datagrams].region = r;
+        buffers->region_datagrams[nb_datagrams].offset = offset;
+        buffers->region_datagrams[nb_datagrams].size = size;
+        buffers->region_nums[r]++;
+        nb_datagrams++;
+        offset += size;
+    }
+    return nb_datagrams;
+}
+
+int prepare_game_update(unsigned game_id, action_ring *actions, int last_num_received_message[PLAYER_NUM],
+                        uint16_t num, tick_buffers *buffers) {
+    // Take the game actions, in their order of arrival
+    unsigned nb_game_actions = pop_actions(actions, buffers->game_actions, ACTION_RING_CAPACITY);
+    unsigned nb_player_actions =
+        get_player_actions(buffers->game_actions, nb_game_actions, last_num_received_message, buffers->player_actions);
+
+    // It is done at each tick, even without actions, so that the bombs explode on time
+    int nb_diffs =
+        update_game_board_into(game_id, buffers->player_actions, nb_player_actions, buffers->diffs, MAX_TICK_DIFFS);
+    if (buffers->by_regions) {
+        buffers->nb_keyframe_regions = 0;
+    }
+    if (nb_diffs <= 0) {
+        return nb_diffs;
+    }
+    if ((unsigned)nb_diffs > buffers->max_update_diffs) {
+        return UPDATE_AS_KEYFRAME;
+    }
+
+    if (buffers->by_regions) {
+        return serialize_region_updates(nb_diffs, buffers);
+    }
+    return serialize_update_fragments(num, nb_diffs, buffers);
+}
@@ -0,0 +1,74 @@
+#ifndef SRC_GAME_TICK_H_
+#define SRC_GAME_TICK_H_
+
+#include "action_ring.h"
+#include "messages.h"
+#include "model.h"
+#include "regions.h"
+
+#include <stdbool.h>
+
+#define LIMIT_LAST_NUM_MESSAGE_CLIENT ((1 << 12) - 1) // 2^13
+
+#define MAX_TICK_DIFFS MAX_UPDATE_DIFFS          // Beyond, the differences of a tick are replaced by a whole board
+#define MAX_TICK_PLAYER_ACTIONS (2 * PLAYER_NUM) // A move and a bomb per player
+
+#define UPDATE_AS_KEYFRAME (-2) // Returned by prepare_game_update when a whole board is smaller than the update
+
+/** Update of a region, serialized in the region_updates of the tick buffers */
+typedef struct region_datagram {
+    int region;
+    size_t offset;
+    size_t size;
+} region_datagram;
+
+/** Scratch buffers of the ticks of a game, allocated with the game so that a tick never allocates */
+typedef struct tick_buffers {
+    game_action game_actions[ACTION_RING_CAPACITY];
+    player_action player_actions[MAX_TICK_PLAYER_ACTIONS];
+    tile_diff diffs[MAX_TICK_DIFFS];
+    unsigned max_update_diffs; // Largest update of the game which is smaller than a whole board
+    char fragments[MAX_UPDATE_FRAGMENTS][MAX_UPDATE_FRAGMENT_SIZE];
+    size_t fragment_sizes[MAX_UPDATE_FRAGMENTS];
+
+    // Only used by the large boards, which are sent by regions
+    bool by_regions;
+    region_grid regions;
+    uint16_t region_nums[MAX_REGIONS];       // Number of the next update of each region
+    unsigned region_starts[MAX_REGIONS + 1]; // The differences of the region r start at region_starts[r]
+    tile_diff region_diffs[MAX_TICK_DIFFS];  // Relative to the first tile of their region
+    region_datagram region_datagrams[MAX_REGIONS];
+    char region_updates[MAX_REGIONS * REGION_UPDATE_HEADER_SIZE + MAX_TICK_DIFFS * 3];
+    int keyframe_regions[MAX_REGIONS]; // Regions whose differences are larger than the whole region
+    unsigned nb_keyframe_regions;
+} tick_buffers;
+
+/** Chooses the messages of the updates of a board of dimension dim,
+ * and the number of differences beyond which a whole board is sent instead
+ * The large boards are sent by regions
+ */
+void init_tick_buffers(tick_buffers *buffers, dimension dim);
+
+/** The message is considered as a next message if it is between the last message
+ * and a fairly large part after the latter (half the limit) modulo limit
+ */
+bool is_next_message(int last_num_message, int num_message, int limit);
+
+/** Keeps the last move and the last bomb of each player among the game actions, in player_actions
+ * player_actions must have room for MAX_TICK_PLAYER_ACTIONS actions
+ * Returns the number of player actions, the moves come first
+ */
+unsigned get_player_actions(const game_action *game_actions, size_t nb_game_actions,
+                            int last_num_received_message[PLAYER_NUM], player_action *player_actions);
+
+/** Applies the actions of the ring to the game and serializes the differences in buffers->fragments
+ * An update of at most UINT8_MAX differences is sent as is (codereq 12), a larger one is fragmented (codereq 18)
+ * The large boards are updated by regions instead (codereq 23), in buffers->region_datagrams, and the regions
+ * whose differences are larger than the whole region are listed in buffers->keyframe_regions
+ * Returns the number of datagrams to send, 0 if nothing changed, UPDATE_AS_KEYFRAME if the differences are larger
+ * than a whole board and -1 in case of error
+ */
+int prepare_game_update(unsigned game_id, action_ring *actions, int last_num_received_message[PLAYER_NUM],
+                        uint16_t num, tick_buffers *buffers);
+
+#endif // SRC_GAME_TICK_H_
@@ -0,0 +1,125 @@
+#include "matchmaking.h"
+
+#include <stddef.h>
+
+void init_match_queue(match_queue *queue) {
+    queue->head = NULL;
+    queue->tail = NULL;
+    queue->size = 0;
+}
+
+void init_match_entry(match_entry *entry) {
+    entry->prev = NULL;
+    entry->next = NULL;
+    entry->queued = false;
+
+    // The places are taken in the order of their ids
+    entry->nb_free = PLAYER_NUM;
+    for (int i = 0; i < PLAYER_NUM; i++) {
+        entry->free_ids[i] = PLAYER_NUM - 1 - i;
+    }
+}
+
+void enqueue_lobby(match_queue *queue, match_entry *entry) {
+    entry->prev = queue->tail;
+    entry->next = NULL;
+    if (queue->tail != NULL) {
+        queue->tail->next = entry;
+    } else {
+        queue->head = entry;
+    }
+    queue->tail = entry;
+    entry->queued = true;
+    queue->size++;
+}
+
+/** Adds a lobby at the front of the queue */
+static void push_front(match_queue *queue, match_entry *entry) {
+    entry->prev = NULL;
+    entry->next = queue->head;
+    if (queue->head != NULL) {
+        queue->head->prev = entry;
+    } else {
+        queue->tail = entry;
+    }
+    queue->head = entry;
+    entry->queued = true;
+    queue->size++;
+}
+
+void dequeue_lobby(match_queue *queue, match_entry *entry) {
+    if (!entry->queued) {
+        return;
+    }
+
+    if (entry->prev != NULL) {
+        entry->prev->next = entry->next;
+    } else {
+        queue->head = entry->next;
+    }
+    if (entry->next != NULL) {
+        entry->next->prev = entry->prev;
+    } else {
+        queue->tail = entry->prev;
+    }
+    entry->prev = NULL;
+    entry->next = NULL;
+    entry->queued = false;
+    queue->size--;
+}
+
+match_entry *take_place(match_queue *queue, int *id) {
+    match_entry *entry = queue->head;
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    entry->nb_free--;
+    *id = entry->free_ids[entry->nb_free];
+    if (entry->nb_free == 0) {
+        dequeue_lobby(queue, entry);
+    }
+    return entry;
+}
+
+void give_back_place(match_queue *queue, match_entry *entry, int id) {
+    // The places given back are taken first
+    entry->free_ids[entry->nb_free] = id;
+    entry->nb_free++;
+    if (!entry->queued) {
+        push_front(queue, entry);
+    }
+}
+
+void close_places(match_queue *queue, match_entry *entry) {
+    entry->nb_free = 0;
+    dequeue_lobby(queue, entry);
+}
+
+void init_settled_places(settled_places *places) {
+    for (int i = 0; i < PLAYER_NUM; i++) {
+        places->settled[i] = false;
+    }
+    places->nb_settled = 0;
+}
+
+bool settle_place(settled_places *places, int id) {
+    if (places->settled[id]) {
+        return false; // Counted once, whatever settles it again
+    }
+    places->settled[id] = true;
+    places->nb_settled++;
+    return true;
+}
+
+void unsettle_place(settled_places *places, int id) {
+    if (!places->settled[id]) {
+        return;
+    }
+    places->settled[id] = false;
+    places->nb_settled--;
+}
+
+bool are_places_settled(const settled_places *places) {
+    return places->nb_settled == PLAYER_NUM;
+}
@@ -0,0 +1,70 @@
+#ifndef SRC_MATCHMAKING_H_
+#define SRC_MATCHMAKING_H_
+
+#include "constants.h"
+
+#include <stdbool.h>
+
+/** Places of a lobby in the matchmaking, embedded in the lobby */
+typedef struct match_entry {
+    struct match_entry *prev;
+    struct match_entry *next;
+    bool queued;
+    int free_ids[PLAYER_NUM]; // Stack of the free places, the lowest one on top
+    unsigned nb_free;
+} match_entry;
+
+/** Lobbies of a game mode with free places, the oldest ones are filled first so that their players wait less
+ * Every operation is in constant time, the queue is not synchronized and its users lock it
+ */
+typedef struct match_queue {
+    match_entry *head;
+    match_entry *tail;
+    unsigned size;
+} match_queue;
+
+void init_match_queue(match_queue *queue);
+
+/** Initializes the places of a new lobby, which are all free */
+void init_match_entry(match_entry *entry);
+
+/** Adds a new lobby at the end of the queue */
+void enqueue_lobby(match_queue *queue, match_entry *entry);
+
+/** Removes the lobby from the queue, nothing is done if it is not in the queue */
+void dequeue_lobby(match_queue *queue, match_entry *entry);
+
+/** Takes the lowest free place of the oldest lobby, in id, the lobby leaves the queue once it is full
+ * Returns the lobby, NULL if the queue is empty
+ */
+match_entry *take_place(match_queue *queue, int *id);
+
+/** Gives back the place id of a player who left, a lobby which was full goes back to the front of the queue
+ * so that it is filled first
+ */
+void give_back_place(match_queue *queue, match_entry *entry, int id);
+
+/** Gives up the free places of the lobby, which leaves the queue */
+void close_places(match_queue *queue, match_entry *entry);
+
+/** Places of a lobby which hold its game back, the game starts once each place is settled: its player is ready, has
+ * left or has not come in time
+ */
+typedef struct settled_places {
+    bool settled[PLAYER_NUM];
+    unsigned nb_settled;
+} settled_places;
+
+void init_settled_places(settled_places *places);
+
+/** Settles the place id, nothing is done if it already is
+ * Returns true if the place was not settled yet
+ */
+bool settle_place(settled_places *places, int id);
+
+/** The place id waits again for a player, after the one settled there left */
+void unsettle_place(settled_places *places, int id);
+
+bool are_places_settled(const settled_places *places);
+
+#endif // SRC_MATCHMAKING_H_
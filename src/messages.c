@@ -23,6 +23,17 @@ connection_header_raw *create_connection_header_raw(int codereq, int id, int tea
 }
 
 connection_header_raw *serialize_initial_connection(const initial_connection_header *header) {
+    connection_header_raw *connection_req = malloc(sizeof(connection_header_raw));
+    RETURN_NULL_IF_NULL_PERROR(connection_req, "malloc");
+
+    if (serialize_initial_connection_into(header, connection_req) != EXIT_SUCCESS) {
+        free(connection_req);
+        return NULL;
+    }
+    return connection_req;
+}
+
+int serialize_initial_connection_into(const initial_connection_header *header, connection_header_raw *res) {
     int codereq = 1;
     switch (header->game_mode) {
         case SOLO:
@@ -32,33 +43,52 @@ connection_header_raw *serialize_initial_connection(const initial_connection_hea
             codereq = 2;
             break;
         default:
-            return NULL;
+            return EXIT_FAILURE;
     }
-    return create_connection_header_raw(codereq, 0, 0);
+    res->req = connection_header_value(codereq, 0, 0);
+    return EXIT_SUCCESS;
 }
 
 initial_connection_header *deserialize_initial_connection(const connection_header_raw *header) {
     initial_connection_header *initial_connection = malloc(sizeof(initial_connection_header));
     RETURN_NULL_IF_NULL_PERROR(initial_connection, "malloc");
 
+    if (deserialize_initial_connection_into(header, initial_connection) != EXIT_SUCCESS) {
+        free(initial_connection);
+        return NULL;
+    }
+    return initial_connection;
+}
+
+int deserialize_initial_connection_into(const connection_header_raw *header, initial_connection_header *res) {
     uint16_t req = ntohs(header->req);
 
     switch (req >> 3) {
         case 1:
-            initial_connection->game_mode = SOLO;
+            res->game_mode = SOLO;
             break;
         case 2:
-            initial_connection->game_mode = TEAM;
+            res->game_mode = TEAM;
             break;
         default:
-            free(initial_connection);
-            return NULL;
+            return EXIT_FAILURE;
     }
 
-    return initial_connection;
+    return EXIT_SUCCESS;
 }
 
 connection_header_raw *serialize_ready_connection(const ready_connection_header *header) {
+    connection_header_raw *connection_req = malloc(sizeof(connection_header_raw));
+    RETURN_NULL_IF_NULL_PERROR(connection_req, "malloc");
+
+    if (serialize_ready_connection_into(header, connection_req) != EXIT_SUCCESS) {
+        free(connection_req);
+        return NULL;
+    }
+    return connection_req;
+}
+
+int serialize_ready_connection_into(const ready_connection_header *header, connection_header_raw *res) {
     int codereq = 1;
     switch (header->game_mode) {
         case SOLO:
@@ -68,43 +98,67 @@ connection_header_raw *serialize_ready_connection(const ready_connection_header
             codereq = 4;
             break;
         default:
-            return NULL;
+            return EXIT_FAILURE;
     }
 
     if (header->id < 0 || header->id > 3) {
-        return NULL;
+        return EXIT_FAILURE;
     }
 
     if (header->game_mode == TEAM && (header->eq < 0 || header->eq > 1)) {
-        return NULL;
+        return EXIT_FAILURE;
     }
 
-    return create_connection_header_raw(codereq, header->id, header->eq & 0x1);
+    res->req = connection_header_value(codereq, header->id, header->eq & 0x1);
+    return EXIT_SUCCESS;
 }
+
 ready_connection_header *deserialize_ready_connection(const connection_header_raw *header) {
     ready_connection_header *ready_connection = malloc(sizeof(ready_connection_header));
     RETURN_NULL_IF_NULL_PERROR(ready_connection, "malloc");
 
+    if (deserialize_ready_connection_into(header, ready_connection) != EXIT_SUCCESS) {
+        free(ready_connection);
+        return NULL;
+    }
+    return ready_connection;
+}
+
+int deserialize_ready_connection_into(const connection_header_raw *header, ready_connection_header *res) {
     uint16_t req = ntohs(header->req);
 
     switch (req >> 3) {
         case 3:
-            ready_connection->game_mode = SOLO;
+            res->game_mode = SOLO;
             break;
         case 4:
-            ready_connection->game_mode = TEAM;
+            res->game_mode = TEAM;
             break;
         default:
-            free(ready_connection);
-            return NULL;
+            return EXIT_FAILURE;
     }
 
-    ready_connection->id = (req >> 1) & 0x3; // We only need 2 bits
-    ready_connection->eq = req & 0x1;        // We only need 1 bit
-    return ready_connection;
+    res->id = (req >> 1) & 0x3; // We only need 2 bits
+    res->eq = req & 0x1;        // We only need 1 bit
+    return EXIT_SUCCESS;
+}
+
+bool is_ready_connection_of(const ready_connection_header *header, GAME_MODE mode, int id, int eq) {
+    return header->game_mode == mode && header->id == id && (mode != TEAM || header->eq == eq);
 }
 
 connection_information_raw *serialize_connection_information(const connection_information *info) {
+    connection_information_raw *raw = malloc(sizeof(connection_information_raw));
+    RETURN_NULL_IF_NULL_PERROR(raw, "malloc");
+
+    if (serialize_connection_information_into(info, (char *)raw, sizeof(connection_information_raw)) < 0) {
+        free(raw);
+        return NULL;
+    }
+    return raw;
+}
+
+int serialize_connection_information_into(const connection_information *info, char *serialized, size_t capacity) {
     int codereq = 1;
     switch (info->game_mode) {
         case SOLO:
@@ -114,58 +168,83 @@ connection_information_raw *serialize_connection_information(const connection_in
             codereq = 10;
             break;
         default:
-            return NULL;
+            return -1;
     }
 
     if (info->id < 0 || info->id > 3) {
-        return NULL;
+        return -1;
     }
 
     if (info->eq < 0 || info->eq > 1) {
-        return NULL;
+        return -1;
     }
 
-    connection_information_raw *raw = malloc(sizeof(connection_information_raw));
-    RETURN_NULL_IF_NULL_PERROR(raw, "malloc");
+    if (info->transport != MULTICAST_TRANSPORT && info->transport != UNICAST_TRANSPORT) {
+        return -1;
+    }
 
-    raw->header = connection_header_value(codereq, info->id, info->eq);
+    if (capacity < sizeof(connection_information_raw)) {
+        return -1;
+    }
 
-    raw->portudp = htons(info->portudp);
-    raw->portmdiff = htons(info->portmdiff);
+    connection_information_raw raw;
+    raw.header = connection_header_value(codereq, info->id, info->eq);
+
+    raw.portudp = htons(info->portudp);
+    raw.portmdiff = htons(info->portmdiff);
     for (int i = 0; i < 8; ++i) {
-        raw->adrmdiff[i] = htons(info->adrmdiff[i]);
+        raw.adrmdiff[i] = htons(info->adrmdiff[i]);
     }
-    return raw;
+    raw.token[0] = htons(info->token >> 16);
+    raw.token[1] = htons(info->token & 0xffff);
+    raw.transport = htons(info->transport);
+
+    memcpy(serialized, &raw, sizeof(connection_information_raw));
+    return sizeof(connection_information_raw);
 }
 
 connection_information *deserialize_connection_information(const connection_information_raw *info) {
     connection_information *connection_info = malloc(sizeof(connection_information));
     RETURN_NULL_IF_NULL_PERROR(connection_info, "malloc");
 
+    if (deserialize_connection_information_into(info, connection_info) != EXIT_SUCCESS) {
+        free(connection_info);
+        return NULL;
+    }
+    return connection_info;
+}
+
+int deserialize_connection_information_into(const connection_information_raw *info, connection_information *res) {
     uint16_t header = ntohs(info->header);
 
     switch (header >> 3) {
         case 9:
-            connection_info->game_mode = SOLO;
+            res->game_mode = SOLO;
             break;
         case 10:
-            connection_info->game_mode = TEAM;
+            res->game_mode = TEAM;
             break;
         default:
-            free(connection_info);
-            return NULL;
+            return EXIT_FAILURE;
     }
 
-    connection_info->id = (header >> 1) & 0x3; // We only need 2 bits
-    connection_info->eq = header & 0x1;        // We only need 1 bit
+    res->id = (header >> 1) & 0x3; // We only need 2 bits
+    res->eq = header & 0x1;        // We only need 1 bit
 
-    connection_info->portudp = ntohs(info->portudp);
-    connection_info->portmdiff = ntohs(info->portmdiff);
+    res->portudp = ntohs(info->portudp);
+    res->portmdiff = ntohs(info->portmdiff);
     for (int i = 0; i < 8; ++i) {
-        connection_info->adrmdiff[i] = ntohs(info->adrmdiff[i]);
+        res->adrmdiff[i] = ntohs(info->adrmdiff[i]);
     }
+    res->token = ((uint32_t)ntohs(info->token[0]) << 16) | ntohs(info->token[1]);
 
-    return connection_info;
+    uint16_t transport = ntohs(info->transport);
+    if (transport != MULTICAST_TRANSPORT && transport != UNICAST_TRANSPORT) {
+        return EXIT_FAILURE;
+    }
+    res->transport = transport;
+
+    return EXIT_SUCCESS;
 }
 
 void free_game_board_information(game_board_information *info) {
@@ -183,9 +262,17 @@ uint16_t game_action_value(int message_num, GAME_ACTION action) {
 }
 
 char *serialize_game_action(const game_action *game_action) {
-    char *raw = malloc(sizeof(uint16_t) * 2);
+    char *raw = malloc(GAME_ACTION_SIZE);
     RETURN_NULL_IF_NULL_PERROR(raw, "malloc");
 
+    if (serialize_game_action_into(game_action, raw, GAME_ACTION_SIZE) < 0) {
+        free(raw);
+        return NULL;
+    }
+    return raw;
+}
+
+int serialize_game_action_into(const game_action *game_action, char *serialized, size_t capacity) {
     int codereq = 1;
 
     switch (game_action->game_mode) {
@@ -196,49 +283,60 @@ char *serialize_game_action(const game_action *game_action) {
             codereq = 6;
             break;
         default:
-            free(raw);
-            return NULL;
+            return -1;
     }
 
     if (game_action->id < 0 || game_action->id > 3) {
-        free(raw);
-        return NULL;
+        return -1;
     }
 
     if (game_action->game_mode == TEAM && (game_action->eq < 0 || game_action->eq > 1)) {
-        free(raw);
-        return NULL;
+        return -1;
     }
 
     uint16_t header = connection_header_value(codereq, game_action->id, game_action->eq);
 
     if (game_action->message_number < 0 || game_action->message_number >= (1 << 13)) {
-        free(raw);
-        return NULL;
+        return -1;
     }
 
     if (game_action->action < 0 || game_action->action > 5) {
-        free(raw);
-        return NULL;
+        return -1;
+    }
+
+    if (capacity < GAME_ACTION_SIZE) {
+        return -1;
     }
 
     uint16_t action = game_action_value(game_action->message_number, game_action->action);
+    uint32_t token = htonl(game_action->token);
 
-    memcpy(raw, &header, sizeof(uint16_t));
-    memcpy(raw + sizeof(uint16_t), &action, sizeof(uint16_t));
+    memcpy(serialized, &header, sizeof(uint16_t));
+    memcpy(serialized + sizeof(uint16_t), &token, SESSION_TOKEN_SIZE);
+    memcpy(serialized + sizeof(uint16_t) + SESSION_TOKEN_SIZE, &action, sizeof(uint16_t));
 
-    return raw;
+    return GAME_ACTION_SIZE;
 }
 
 game_action *deserialize_game_action(const char *game_action_raw) {
     game_action *game_action_ = malloc(sizeof(game_action));
     RETURN_NULL_IF_NULL_PERROR(game_action_, "malloc");
 
+    if (deserialize_game_action_into(game_action_raw, game_action_) != EXIT_SUCCESS) {
+        free(game_action_);
+        return NULL;
+    }
+    return game_action_;
+}
+
+int deserialize_game_action_into(const char *game_action_raw, game_action *game_action_) {
     uint16_t header;
+    uint32_t token;
     uint16_t action;
 
     memcpy(&header, game_action_raw, sizeof(uint16_t));
-    memcpy(&action, game_action_raw + sizeof(uint16_t), sizeof(uint16_t));
+    memcpy(&token, game_action_raw + sizeof(uint16_t), SESSION_TOKEN_SIZE);
+    memcpy(&action, game_action_raw + sizeof(uint16_t) + SESSION_TOKEN_SIZE, sizeof(uint16_t));
 
     header = ntohs(header);
     action = ntohs(action);
@@ -251,8 +349,7 @@ game_action *deserialize_game_action(const char *game_action_raw) {
             game_action_->game_mode = TEAM;
             break;
         default:
-            free(game_action_);
-            return NULL;
+            return EXIT_FAILURE;
     }
 
     game_action_->id = (header >> 1) & 0x3; // We only need 2 bits
@@ -260,8 +357,9 @@ game_action *deserialize_game_action(const char *game_action_raw) {
 
     game_action_->message_number = action >> 3;
     game_action_->action = action & 0x7; // We only need 3 bits
+    game_action_->token = ntohl(token);
 
-    return game_action_;
+    return EXIT_SUCCESS;
 }
 
 char *serialize_game_board(const game_board_information *info) {
@@ -296,50 +394,375 @@ char *serialize_game_board(const game_board_information *info) {
 }
 
 game_board_information *deserialize_game_board(const char *info) {
+    // The size is not known here, the message is trusted to be complete
+    size_t size = PACKED_GAME_BOARD_HEADER_SIZE + UINT8_MAX * UINT8_MAX;
+    game_board_view view;
+    char *tiles = malloc(UINT8_MAX * UINT8_MAX);
+    RETURN_NULL_IF_NULL_PERROR(tiles, "malloc");
+
+    if (deserialize_game_board_into(info, size, tiles, UINT8_MAX * UINT8_MAX, &view) != EXIT_SUCCESS) {
+        free(tiles);
+        return NULL;
+    }
+
     game_board_information *game_board_info = malloc(sizeof(game_board_information));
-    RETURN_NULL_IF_NULL_PERROR(game_board_info, "malloc");
+    if (game_board_info == NULL) {
+        perror("malloc");
+        free(tiles);
+        return NULL;
+    }
 
-    uint16_t header = ntohs(*(uint16_t *)info);
+    game_board_info->num = view.num;
+    game_board_info->height = view.height;
+    game_board_info->width = view.width;
 
-    if ((header >> 3) != 11) {
+    unsigned nb_tiles = game_board_info->height * game_board_info->width;
+    game_board_info->board = malloc(nb_tiles * sizeof(TILE));
+    if (game_board_info->board == NULL) {
+        free(tiles);
         free(game_board_info);
         return NULL;
     }
 
-    if (((header >> 1) & 0x3) != 0) {
-        free(game_board_info);
-        return NULL;
+    for (unsigned i = 0; i < nb_tiles; ++i) {
+        game_board_info->board[i] = view.tiles[i];
     }
 
-    if ((header & 0x1) != 0) {
-        free(game_board_info);
-        return NULL;
+    free(tiles);
+    return game_board_info;
+}
+
+int serialize_game_board_into(const game_board_view *view, char *serialized, size_t capacity) {
+    size_t size = GAME_BOARD_SIZE(view->height, view->width);
+    if (capacity < size || IS_LARGE_BOARD(view->height, view->width)) {
+        return -1;
     }
 
-    game_board_info->num = ntohs(*(uint16_t *)(info + 2));
-    game_board_info->height = info[4];
-    game_board_info->width = info[5];
+    uint16_t header = connection_header_value(11, 0, 0);
+    uint16_t num = htons(view->num);
+    memcpy(serialized, &header, sizeof(uint16_t));
+    memcpy(serialized + 2, &num, sizeof(uint16_t));
+    serialized[4] = view->height;
+    serialized[5] = view->width;
+
+    for (int i = 0; i < view->height * view->width; ++i) {
+        if ((uint8_t)view->tiles[i] > 8) {
+            return -1;
+        }
+        serialized[6 + i] = view->tiles[i];
+    }
 
-    unsigned size = game_board_info->height * game_board_info->width;
+    return size;
+}
 
-    game_board_info->board = malloc(size * sizeof(TILE));
-    if (game_board_info->board == NULL) {
-        free(game_board_info);
-        return NULL;
+int deserialize_game_board_view(const char *info, size_t size, game_board_view *view) {
+    if (size < GAME_BOARD_SIZE(0, 0)) {
+        return EXIT_FAILURE;
     }
 
-    for (unsigned i = 0; i < size; ++i) {
-        game_board_info->board[i] = info[6 + i];
+    uint16_t header;
+    memcpy(&header, info, sizeof(uint16_t));
+    if (header != connection_header_value(11, 0, 0)) {
+        return EXIT_FAILURE;
     }
 
-    return game_board_info;
+    uint16_t num;
+    memcpy(&num, info + 2, sizeof(uint16_t));
+    view->num = ntohs(num);
+    view->height = (uint8_t)info[4];
+    view->width = (uint8_t)info[5];
+    if (size < GAME_BOARD_SIZE(view->height, view->width)) {
+        return EXIT_FAILURE;
+    }
+    view->tiles = info + 6;
+
+    return EXIT_SUCCESS;
 }
 
-char *serialize_game_board_update(const game_board_update *update) {
+/** Writes two tiles per byte, the first one in the high nibble
+ * Returns the number of bytes written, -1 if they do not fit in capacity
+ */
+static int pack_tile_nibbles(const char *tiles, unsigned nb_tiles, char *packed, size_t capacity) {
+    size_t size = (nb_tiles + 1) / 2;
+    if (capacity < size) {
+        return -1;
+    }
+
+    for (unsigned i = 0; i < nb_tiles; i += 2) {
+        uint8_t second = i + 1 < nb_tiles ? tiles[i + 1] : 0;
+        packed[i / 2] = (tiles[i] << 4) | second;
+    }
+    return size;
+}
+
+/** Writes a byte per run of at most MAX_TILE_RUN identical tiles: the tile in the high nibble and the length of the
+ * run minus one in the low nibble
+ * Returns the number of bytes written, -1 if they do not fit in capacity
+ */
+static int pack_tile_runs(const char *tiles, unsigned nb_tiles, char *packed, size_t capacity) {
+    size_t size = 0;
+    unsigned i = 0;
+    while (i < nb_tiles) {
+        unsigned run = 1;
+        while (i + run < nb_tiles && run < MAX_TILE_RUN && tiles[i + run] == tiles[i]) {
+            run++;
+        }
+        if (size == capacity) {
+            return -1;
+        }
+        packed[size] = (tiles[i] << 4) | (run - 1);
+        size++;
+        i += run;
+    }
+    return size;
+}
+
+static int unpack_tile_nibbles(const char *packed, size_t size, char *tiles, unsigned nb_tiles) {
+    if (size < (nb_tiles + 1) / 2) {
+        return EXIT_FAILURE;
+    }
+
+    for (unsigned i = 0; i < nb_tiles; i++) {
+        uint8_t byte = packed[i / 2];
+        tiles[i] = i % 2 == 0 ? byte >> 4 : byte & 0xF;
+    }
+    return EXIT_SUCCESS;
+}
+
+static int unpack_tile_runs(const char *packed, size_t size, char *tiles, unsigned nb_tiles) {
+    unsigned i = 0;
+    for (size_t k = 0; i < nb_tiles; k++) {
+        if (k == size) {
+            return EXIT_FAILURE;
+        }
+        uint8_t byte = packed[k];
+        unsigned run = (byte & 0xF) + 1;
+        if (i + run > nb_tiles) {
+            return EXIT_FAILURE;
+        }
+        memset(tiles + i, byte >> 4, run);
+        i += run;
+    }
+    return EXIT_SUCCESS;
+}
+
+/** Packs the tiles with the smallest encoding, written in encoding, after the room for the nibbles is checked
+ * Returns the number of bytes of the packed tiles
+ */
+static int pack_tiles(const char *tiles, unsigned nb_tiles, char *packed, char *encoding) {
+    // The runs are kept only if they are strictly smaller than the nibbles, they are tried first to stop early
+    size_t nibbles_size = (nb_tiles + 1) / 2;
+    int size = pack_tile_runs(tiles, nb_tiles, packed, nibbles_size > 0 ? nibbles_size - 1 : 0);
+    if (size >= 0) {
+        *encoding = TILE_RUNS;
+    } else {
+        *encoding = TILE_NIBBLES;
+        size = pack_tile_nibbles(tiles, nb_tiles, packed, nibbles_size);
+    }
+    return size;
+}
+
+static int unpack_tiles(char encoding, const char *packed, size_t size, char *tiles, unsigned nb_tiles) {
+    switch (encoding) {
+        case TILE_NIBBLES:
+            return unpack_tile_nibbles(packed, size, tiles, nb_tiles);
+        case TILE_RUNS:
+            return unpack_tile_runs(packed, size, tiles, nb_tiles);
+        default:
+            return EXIT_FAILURE;
+    }
+}
+
+int serialize_packed_game_board_into(const game_board_view *view, char *serialized, size_t capacity) {
+    unsigned nb_tiles = view->height * view->width;
+    if (capacity < PACKED_GAME_BOARD_SIZE(view->height, view->width) || IS_LARGE_BOARD(view->height, view->width)) {
+        return -1;
+    }
+
+    for (unsigned i = 0; i < nb_tiles; ++i) {
+        if ((uint8_t)view->tiles[i] > 8) {
+            return -1;
+        }
+    }
+
+    uint16_t header = connection_header_value(17, 0, 0);
+    uint16_t num = htons(view->num);
+    memcpy(serialized, &header, sizeof(uint16_t));
+    memcpy(serialized + 2, &num, sizeof(uint16_t));
+    serialized[4] = view->height;
+    serialized[5] = view->width;
+
+    int size = pack_tiles(view->tiles, nb_tiles, serialized + PACKED_GAME_BOARD_HEADER_SIZE, serialized + 6);
+    return PACKED_GAME_BOARD_HEADER_SIZE + size;
+}
+
+int deserialize_game_board_into(const char *info, size_t size, char *tiles, size_t capacity, game_board_view *view) {
+    if (size < PACKED_GAME_BOARD_HEADER_SIZE) {
+        return deserialize_game_board_view(info, size, view);
+    }
+
+    uint16_t header;
+    memcpy(&header, info, sizeof(uint16_t));
+    if (header != connection_header_value(17, 0, 0)) {
+        return deserialize_game_board_view(info, size, view);
+    }
+
+    uint16_t num;
+    memcpy(&num, info + 2, sizeof(uint16_t));
+    view->num = ntohs(num);
+    view->height = (uint8_t)info[4];
+    view->width = (uint8_t)info[5];
+
+    unsigned nb_tiles = view->height * view->width;
+    if (capacity < nb_tiles) {
+        return EXIT_FAILURE;
+    }
+
+    const char *payload = info + PACKED_GAME_BOARD_HEADER_SIZE;
+    RETURN_FAILURE_IF_ERROR(unpack_tiles(info[6], payload, size - PACKED_GAME_BOARD_HEADER_SIZE, tiles, nb_tiles));
+    view->tiles = tiles;
+
+    return EXIT_SUCCESS;
+}
+
+size_t get_game_board_keyframe_size(uint16_t height, uint16_t width) {
+    if (!IS_LARGE_BOARD(height, width)) {
+        return PACKED_GAME_BOARD_SIZE(height, width);
+    }
+
+    unsigned rows_per_band = GAME_BOARD_BAND_ROWS(width);
+    unsigned nb_bands = (height + rows_per_band - 1) / rows_per_band;
+    return nb_bands * GAME_BOARD_BAND_HEADER_SIZE + ((size_t)height * width + nb_bands) / 2;
+}
+
+int serialize_game_board_band_into(const game_board_view *view, uint16_t first_row, uint16_t nb_rows,
+                                   char *serialized, size_t capacity) {
+    unsigned nb_tiles = nb_rows * view->width;
+    if (nb_tiles > GAME_BOARD_BAND_TILES || first_row + nb_rows > view->height ||
+        capacity < GAME_BOARD_BAND_HEADER_SIZE + (nb_tiles + 1) / 2) {
+        return -1;
+    }
+
+    const char *tiles = view->tiles + first_row * view->width;
+    for (unsigned i = 0; i < nb_tiles; ++i) {
+        if ((uint8_t)tiles[i] > 8) {
+            return -1;
+        }
+    }
+
+    uint16_t fields[6] = {connection_header_value(20, 0, 0), htons(view->num), htons(view->height),
+                          htons(view->width), htons(first_row), htons(nb_rows)};
+    memcpy(serialized, fields, sizeof(fields));
+
+    int size = pack_tiles(tiles, nb_tiles, serialized + GAME_BOARD_BAND_HEADER_SIZE, serialized + 12);
+    return GAME_BOARD_BAND_HEADER_SIZE + size;
+}
+
+int deserialize_game_board_band_into(const char *band, size_t size, char *tiles, size_t capacity,
+                                     game_board_band_view *view) {
+    if (size < GAME_BOARD_BAND_HEADER_SIZE) {
+        return EXIT_FAILURE;
+    }
+
+    uint16_t fields[6];
+    memcpy(fields, band, sizeof(fields));
+    if (fields[0] != connection_header_value(20, 0, 0)) {
+        return EXIT_FAILURE;
+    }
+    view->num = ntohs(fields[1]);
+    view->height = ntohs(fields[2]);
+    view->width = ntohs(fields[3]);
+    view->first_row = ntohs(fields[4]);
+    view->nb_rows = ntohs(fields[5]);
+    // The dimension of the band becomes the one of the board
+    if (view->height == 0 || view->width == 0 || view->height > MAX_GAMEBOARD_HEIGHT ||
+        view->width > MAX_GAMEBOARD_WIDTH) {
+        return EXIT_FAILURE;
+    }
+
+    unsigned nb_tiles = view->nb_rows * view->width;
+    if (nb_tiles > capacity || view->first_row + view->nb_rows > view->height) {
+        return EXIT_FAILURE;
+    }
+
+    const char *payload = band + GAME_BOARD_BAND_HEADER_SIZE;
+    RETURN_FAILURE_IF_ERROR(unpack_tiles(band[12], payload, size - GAME_BOARD_BAND_HEADER_SIZE, tiles, nb_tiles));
+    view->tiles = tiles;
+
+    return EXIT_SUCCESS;
+}
+
+int serialize_game_region_into(const game_region_view *view, char *serialized, size_t capacity) {
+    region_grid grid;
+    init_region_grid(&grid, (dimension){view->width, view->height});
+    if (view->region >= get_region_count(&grid)) {
+        return -1;
+    }
+
+    coord origin;
+    dimension area;
+    get_region_area(&grid, view->region, &origin, &area);
+    unsigned nb_tiles = area.height * area.width;
+    if (capacity < GAME_REGION_HEADER_SIZE + (nb_tiles + 1) / 2) {
+        return -1;
+    }
+    for (unsigned i = 0; i < nb_tiles; ++i) {
+        if ((uint8_t)view->tiles[i] > 8) {
+            return -1;
+        }
+    }
+
+    uint16_t fields[5] = {connection_header_value(22, 0, 0), htons(view->num), htons(view->height),
+                          htons(view->width), htons(view->region)};
+    memcpy(serialized, fields, sizeof(fields));
+
+    int size = pack_tiles(view->tiles, nb_tiles, serialized + GAME_REGION_HEADER_SIZE, serialized + 10);
+    return GAME_REGION_HEADER_SIZE + size;
+}
+
+int deserialize_game_region_into(const char *region, size_t size, char *tiles, size_t capacity,
+                                 game_region_view *view) {
+    if (size < GAME_REGION_HEADER_SIZE) {
+        return EXIT_FAILURE;
+    }
+
+    uint16_t fields[5];
+    memcpy(fields, region, sizeof(fields));
+    if (fields[0] != connection_header_value(22, 0, 0)) {
+        return EXIT_FAILURE;
+    }
+    view->num = ntohs(fields[1]);
+    view->height = ntohs(fields[2]);
+    view->width = ntohs(fields[3]);
+    view->region = ntohs(fields[4]);
+
+    region_grid grid;
+    init_region_grid(&grid, (dimension){view->width, view->height});
+    if (view->region >= get_region_count(&grid)) {
+        return EXIT_FAILURE;
+    }
+    coord origin;
+    dimension area;
+    get_region_area(&grid, view->region, &origin, &area);
+    unsigned nb_tiles = area.height * area.width;
+    if (nb_tiles > capacity) {
+        return EXIT_FAILURE;
+    }
+
+    const char *payload = region + GAME_REGION_HEADER_SIZE;
+    RETURN_FAILURE_IF_ERROR(unpack_tiles(region[10], payload, size - GAME_REGION_HEADER_SIZE, tiles, nb_tiles));
+    view->tiles = tiles;
+
+    return EXIT_SUCCESS;
+}
+
+int serialize_game_board_update_into(const game_board_update *update, char *serialized, size_t capacity) {
     // 5 corresponds to the number of bytes of the header, the message number
     // and the number of tile_diffs
-    char *serialized = malloc((update->nb * 3) + 5);
-    RETURN_NULL_IF_NULL_PERROR(serialized, "malloc");
+    size_t size = GAME_BOARD_UPDATE_SIZE(update->nb);
+    if (capacity < size) {
+        return -1;
+    }
 
     uint16_t header = connection_header_value(12, 0, 0);
     uint16_t num = htons(update->num);
@@ -355,15 +778,27 @@ char *serialize_game_board_update(const game_board_update *update) {
     serialized[4] = update->nb;
 
     for (int i = 0; i < update->nb; ++i) {
-        if (update->diff[i].tile > 8) {
-            free(serialized);
-            return NULL;
+        if (update->diff[i].tile > 8 || update->diff[i].x > UINT8_MAX || update->diff[i].y > UINT8_MAX) {
+            return -1;
         }
         serialized[5 + i * 3] = update->diff[i].x;
         serialized[6 + i * 3] = update->diff[i].y;
         serialized[7 + i * 3] = update->diff[i].tile;
     }
 
+    return size;
+}
+
+char *serialize_game_board_update(const game_board_update *update) {
+    size_t size = GAME_BOARD_UPDATE_SIZE(update->nb);
+    char *serialized = malloc(size);
+    RETURN_NULL_IF_NULL_PERROR(serialized, "malloc");
+
+    if (serialize_game_board_update_into(update, serialized, size) < 0) {
+        free(serialized);
+        return NULL;
+    }
+
     return serialized;
 }
 
@@ -407,11 +842,169 @@ game_board_update *deserialize_game_board_update(const char *update) {
     return game_board_update_;
 }
 
-static char *serialize_chat_message(const chat_message *message, int initial_codereq) {
-    // 2 for the header and 1 for the message length (2+1=3)
-    char *serialized = malloc(3 + message->message_length);
-    RETURN_NULL_IF_NULL_PERROR(serialized, "malloc");
+int serialize_game_board_update_fragment_into(const game_board_update_fragment *fragment, char *serialized,
+                                              size_t capacity) {
+    size_t size = UPDATE_FRAGMENT_SIZE(fragment->nb);
+    if (capacity < size || fragment->index >= fragment->count) {
+        return -1;
+    }
+
+    uint16_t header = connection_header_value(18, 0, 0);
+    uint16_t num = htons(fragment->num);
+    memcpy(serialized, &header, sizeof(uint16_t));
+    memcpy(serialized + 2, &num, sizeof(uint16_t));
+    serialized[4] = fragment->index;
+    serialized[5] = fragment->count;
+    serialized[6] = fragment->nb;
+
+    char *diffs = serialized + UPDATE_FRAGMENT_HEADER_SIZE;
+    for (int i = 0; i < fragment->nb; ++i) {
+        if (fragment->diff[i].tile > 8 || fragment->diff[i].x > UINT8_MAX || fragment->diff[i].y > UINT8_MAX) {
+            return -1;
+        }
+        diffs[i * 3] = fragment->diff[i].x;
+        diffs[i * 3 + 1] = fragment->diff[i].y;
+        diffs[i * 3 + 2] = fragment->diff[i].tile;
+    }
+
+    return size;
+}
+
+int serialize_region_update_fragment_into(const game_board_update_fragment *fragment, uint16_t region,
+                                          char *serialized, size_t capacity) {
+    size_t size = REGION_UPDATE_SIZE(fragment->nb);
+    if (capacity < size || fragment->index >= fragment->count) {
+        return -1;
+    }
+
+    uint16_t fields[3] = {connection_header_value(23, 0, 0), htons(fragment->num), htons(region)};
+    memcpy(serialized, fields, sizeof(fields));
+    serialized[6] = fragment->index;
+    serialized[7] = fragment->count;
+    serialized[8] = fragment->nb;
+
+    char *diffs = serialized + REGION_UPDATE_HEADER_SIZE;
+    for (int i = 0; i < fragment->nb; ++i) {
+        if (fragment->diff[i].tile > 8 || fragment->diff[i].x > UINT8_MAX || fragment->diff[i].y > UINT8_MAX) {
+            return -1;
+        }
+        diffs[i * 3] = fragment->diff[i].x;
+        diffs[i * 3 + 1] = fragment->diff[i].y;
+        diffs[i * 3 + 2] = fragment->diff[i].tile;
+    }
+
+    return size;
+}
+
+int deserialize_game_board_update_view(const char *update, size_t size, game_board_update_view *view) {
+    if (size < GAME_BOARD_UPDATE_SIZE(0)) {
+        return EXIT_FAILURE;
+    }
+
+    uint16_t header;
+    uint16_t num;
+    memcpy(&header, update, sizeof(uint16_t));
+    memcpy(&num, update + 2, sizeof(uint16_t));
+    view->num = ntohs(num);
+
+    // The number of differences is the last byte of the header of the three kinds of updates
+    size_t header_size;
+    view->region = -1;
+    if (header == connection_header_value(12, 0, 0)) {
+        header_size = GAME_BOARD_UPDATE_SIZE(0);
+        view->index = 0;
+        view->count = 1;
+    } else if (header == connection_header_value(18, 0, 0) && size >= UPDATE_FRAGMENT_HEADER_SIZE) {
+        header_size = UPDATE_FRAGMENT_HEADER_SIZE;
+        view->index = update[4];
+        view->count = update[5];
+    } else if (header == connection_header_value(23, 0, 0) && size >= REGION_UPDATE_HEADER_SIZE) {
+        header_size = REGION_UPDATE_HEADER_SIZE;
+        uint16_t region;
+        memcpy(&region, update + 4, sizeof(uint16_t));
+        view->region = ntohs(region);
+        view->index = update[6];
+        view->count = update[7];
+    } else {
+        return EXIT_FAILURE;
+    }
+    if (view->index >= view->count) {
+        return EXIT_FAILURE;
+    }
+
+    view->nb = update[header_size - 1];
+    if (size < header_size + (size_t)view->nb * 3) {
+        return EXIT_FAILURE;
+    }
+    view->diffs = update + header_size;
+
+    return EXIT_SUCCESS;
+}
+
+tile_diff get_game_board_update_diff(const game_board_update_view *view, int i) {
+    tile_diff diff;
+    diff.x = (uint8_t)view->diffs[i * 3];
+    diff.y = (uint8_t)view->diffs[i * 3 + 1];
+    diff.tile = view->diffs[i * 3 + 2];
+    return diff;
+}
+
+int serialize_keyframe_request_into(const keyframe_request *request, char *serialized, size_t capacity) {
+    if (request->id < 0 || request->id > 3) {
+        return -1;
+    }
 
+    if (capacity < KEYFRAME_REQUEST_SIZE) {
+        return -1;
+    }
+
+    uint16_t header = connection_header_value(19, request->id, request->eq);
+    uint32_t token = htonl(request->token);
+    uint16_t num = htons(request->num);
+    memcpy(serialized, &header, sizeof(uint16_t));
+    memcpy(serialized + 2, &token, SESSION_TOKEN_SIZE);
+    memcpy(serialized + 2 + SESSION_TOKEN_SIZE, &num, sizeof(uint16_t));
+
+    return KEYFRAME_REQUEST_SIZE;
+}
+
+int serialize_region_keyframe_request_into(int id, int eq, uint32_t token, uint16_t region, char *serialized,
+                                           size_t capacity) {
+    keyframe_request request = {id, eq, region, token};
+    int size = serialize_keyframe_request_into(&request, serialized, capacity);
+    if (size < 0) {
+        return -1;
+    }
+
+    uint16_t header = connection_header_value(24, id, eq);
+    memcpy(serialized, &header, sizeof(uint16_t));
+    return size;
+}
+
+int deserialize_keyframe_request_into(const char *request, keyframe_request *res, bool *is_region) {
+    uint16_t header;
+    uint32_t token;
+    uint16_t num;
+    memcpy(&header, request, sizeof(uint16_t));
+    memcpy(&token, request + 2, SESSION_TOKEN_SIZE);
+    memcpy(&num, request + 2 + SESSION_TOKEN_SIZE, sizeof(uint16_t));
+    header = ntohs(header);
+
+    if ((header >> 3) != 19 && (header >> 3) != 24) {
+        return EXIT_FAILURE;
+    }
+
+    *is_region = (header >> 3) == 24;
+    res->id = (header >> 1) & 0x3; // We only need 2 bits
+    res->eq = header & 0x1;        // We only need 1 bit
+    res->num = ntohs(num);
+    res->token = ntohl(token);
+
+    return EXIT_SUCCESS;
+}
+
+static int serialize_chat_message_into(const chat_message_view *message, int initial_codereq, char *serialized,
+                                       size_t capacity) {
     int codereq = 0;
 
     if (message->type == GLOBAL_M) {
@@ -419,18 +1012,20 @@ static char *serialize_chat_message(const chat_message *message, int initial_cod
     } else if (message->type == TEAM_M) {
         codereq = initial_codereq + 1;
     } else {
-        free(serialized);
-        return NULL;
+        return -1;
     }
 
     if (message->id < 0 || message->id > 3) {
-        free(serialized);
-        return NULL;
+        return -1;
     }
 
     if (message->type == TEAM_M && (message->eq < 0 || message->eq > 1)) {
-        free(serialized);
-        return NULL;
+        return -1;
+    }
+
+    size_t size = CHAT_MESSAGE_SIZE(message->message_length);
+    if (capacity < size) {
+        return -1;
     }
 
     uint16_t header = connection_header_value(codereq, message->id, message->eq);
@@ -443,6 +1038,21 @@ static char *serialize_chat_message(const chat_message *message, int initial_cod
 
     strncpy(serialized + 3, message->message, message->message_length);
 
+    return size;
+}
+
+static char *serialize_chat_message(const chat_message *message, int initial_codereq) {
+    chat_message_view view = {message->type, message->id, message->eq, message->message_length, message->message};
+
+    size_t size = CHAT_MESSAGE_SIZE(message->message_length);
+    char *serialized = malloc(size);
+    RETURN_NULL_IF_NULL_PERROR(serialized, "malloc");
+
+    if (serialize_chat_message_into(&view, initial_codereq, serialized, size) < 0) {
+        free(serialized);
+        return NULL;
+    }
+
     return serialized;
 }
 
@@ -457,25 +1067,58 @@ char *server_serialize_chat_message(const chat_message *message) {
     return serialize_chat_message(message, SERVER_CHAT_CODE);
 }
 
-chat_message *deserialize_chat_message(const char *message, int initial_codereq) {
-    chat_message *chat_message_ = malloc(sizeof(chat_message));
-    RETURN_NULL_IF_NULL_PERROR(chat_message_, "malloc");
+int client_serialize_chat_message_into(const chat_message_view *message, char *serialized, size_t capacity) {
+    return serialize_chat_message_into(message, CLIENT_CHAT_CODE, serialized, capacity);
+}
+
+int server_serialize_chat_message_into(const chat_message_view *message, char *serialized, size_t capacity) {
+    return serialize_chat_message_into(message, SERVER_CHAT_CODE, serialized, capacity);
+}
+
+static int deserialize_chat_message_view(const char *message, size_t size, int initial_codereq,
+                                         chat_message_view *view) {
+    if (size < CHAT_MESSAGE_SIZE(0)) {
+        return EXIT_FAILURE;
+    }
 
-    uint16_t header = ntohs(*(uint16_t *)message);
+    uint16_t header;
+    memcpy(&header, message, sizeof(uint16_t));
+    header = ntohs(header);
 
     if ((header >> 3) == initial_codereq) {
-        chat_message_->type = GLOBAL_M;
+        view->type = GLOBAL_M;
     } else if ((header >> 3) == initial_codereq + 1) {
-        chat_message_->type = TEAM_M;
+        view->type = TEAM_M;
     } else {
-        free(chat_message_);
+        return EXIT_FAILURE;
+    }
+
+    view->id = (header >> 1) & 0x3; // We only need 2 bits
+    view->eq = header & 0x1;        // We only need 1 bit
+
+    view->message_length = message[2];
+    if (size < CHAT_MESSAGE_SIZE(view->message_length)) {
+        return EXIT_FAILURE;
+    }
+    view->message = message + 3;
+
+    return EXIT_SUCCESS;
+}
+
+static chat_message *deserialize_chat_message(const char *message, int initial_codereq) {
+    chat_message_view view;
+    // The size is not known here, the message is trusted to be complete
+    if (deserialize_chat_message_view(message, CHAT_MESSAGE_SIZE(UINT8_MAX), initial_codereq, &view) != EXIT_SUCCESS) {
         return NULL;
     }
 
-    chat_message_->id = (header >> 1) & 0x3; // We only need 2 bits
-    chat_message_->eq = header & 0x1;        // We only need 1 bit
+    chat_message *chat_message_ = malloc(sizeof(chat_message));
+    RETURN_NULL_IF_NULL_PERROR(chat_message_, "malloc");
 
-    chat_message_->message_length = message[2];
+    chat_message_->type = view.type;
+    chat_message_->id = view.id;
+    chat_message_->eq = view.eq;
+    chat_message_->message_length = view.message_length;
 
     chat_message_->message = malloc(chat_message_->message_length + 1);
     if (chat_message_->message == NULL) {
@@ -483,7 +1126,7 @@ chat_message *deserialize_chat_message(const char *message, int initial_codereq)
         return NULL;
     }
 
-    strncpy(chat_message_->message, message + 3, chat_message_->message_length);
+    strncpy(chat_message_->message, view.message, chat_message_->message_length);
     chat_message_->message[chat_message_->message_length] = '\0';
 
     return chat_message_;
@@ -497,10 +1140,26 @@ chat_message *server_deserialize_chat_message(const char *message) {
     return deserialize_chat_message(message, SERVER_CHAT_CODE);
 }
 
+int client_deserialize_chat_message_view(const char *message, size_t size, chat_message_view *view) {
+    return deserialize_chat_message_view(message, size, CLIENT_CHAT_CODE, view);
+}
+
+int server_deserialize_chat_message_view(const char *message, size_t size, chat_message_view *view) {
+    return deserialize_chat_message_view(message, size, SERVER_CHAT_CODE, view);
+}
+
 char *serialize_game_end(const game_end *end) {
-    char *serialized = malloc(2);
+    char *serialized = malloc(GAME_END_SIZE);
     RETURN_NULL_IF_NULL_PERROR(serialized, "malloc");
 
+    if (serialize_game_end_into(end, serialized, GAME_END_SIZE) < 0) {
+        free(serialized);
+        return NULL;
+    }
+    return serialized;
+}
+
+int serialize_game_end_into(const game_end *end, char *serialized, size_t capacity) {
     int codereq = 1;
 
     switch (end->game_mode) {
@@ -511,18 +1170,19 @@ char *serialize_game_end(const game_end *end) {
             codereq = 16;
             break;
         default:
-            free(serialized);
-            return NULL;
+            return -1;
     }
 
     if (end->game_mode == SOLO && (end->id < 0 || end->id > 3)) {
-        free(serialized);
-        return NULL;
+        return -1;
     }
 
     if (end->game_mode == TEAM && (end->eq < 0 || end->eq > 1)) {
-        free(serialized);
-        return NULL;
+        return -1;
+    }
+
+    if (capacity < GAME_END_SIZE) {
+        return -1;
     }
 
     uint16_t header = connection_header_value(codereq, end->id, end->eq);
@@ -531,31 +1191,40 @@ char *serialize_game_end(const game_end *end) {
     serialized[0] = header & 0xFF;
     serialized[1] = header >> 8;
 
-    return serialized;
+    return GAME_END_SIZE;
 }
 
 game_end *deserialize_game_end(const char *end) {
     game_end *game_end_ = malloc(sizeof(game_end));
     RETURN_NULL_IF_NULL_PERROR(game_end_, "malloc");
 
-    uint16_t header = ntohs(*(uint16_t *)end);
+    if (deserialize_game_end_into(end, game_end_) != EXIT_SUCCESS) {
+        free(game_end_);
+        return NULL;
+    }
+    return game_end_;
+}
+
+int deserialize_game_end_into(const char *end, game_end *res) {
+    uint16_t header;
+    memcpy(&header, end, sizeof(uint16_t));
+    header = ntohs(header);
 
     switch (header >> 3) {
         case 15:
-            game_end_->game_mode = SOLO;
+            res->game_mode = SOLO;
             break;
         case 16:
-            game_end_->game_mode = TEAM;
+            res->game_mode = TEAM;
             break;
         default:
-            free(game_end_);
-            return NULL;
+            return EXIT_FAILURE;
     }
 
-    game_end_->id = (header >> 1) & 0x3; // We only need 2 bits
-    game_end_->eq = header & 0x1;        // We only need 1 bit
+    res->id = (header >> 1) & 0x3; // We only need 2 bits
+    res->eq = header & 0x1;        // We only need 1 bit
 
-    return game_end_;
+    return EXIT_SUCCESS;
 }
 
 message_header *deserialize_message_header(uint16_t header) {
@@ -2,8 +2,17 @@
 #define MESSAGES_CLIENT_H
 
 #include "./model.h"
+#include "./regions.h"
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+/** The *_into serializers write in the given buffer of capacity bytes, without allocation
+ * They return the number of bytes written, -1 if the buffer is too small or the message is invalid
+ * The *_into deserializers, and the serializers of the connection headers, fill the given structure and return
+ * EXIT_FAILURE if the message is invalid
+ */
+
 typedef struct connection_header_raw {
     uint16_t req;
 } connection_header_raw;
@@ -15,7 +24,9 @@ typedef struct initial_connection_header {
 connection_header_raw *create_connection_header_raw(int codereq, int id, int team_number);
 
 connection_header_raw *serialize_initial_connection(const initial_connection_header *header);
+int serialize_initial_connection_into(const initial_connection_header *header, connection_header_raw *res);
 initial_connection_header *deserialize_initial_connection(const connection_header_raw *header);
+int deserialize_initial_connection_into(const connection_header_raw *header, initial_connection_header *res);
 
 typedef struct ready_connection_header {
     GAME_MODE game_mode;
@@ -24,13 +35,30 @@ typedef struct ready_connection_header {
 } ready_connection_header;
 
 connection_header_raw *serialize_ready_connection(const ready_connection_header *header);
+int serialize_ready_connection_into(const ready_connection_header *header, connection_header_raw *res);
 ready_connection_header *deserialize_ready_connection(const connection_header_raw *header);
-
+int deserialize_ready_connection_into(const connection_header_raw *header, ready_connection_header *res);
+/** Returns true if the ready header is the one of the player id of the team eq in a game of the mode, the team is only
+ * checked in TEAM
+ */
+bool is_ready_connection_of(const ready_connection_header *header, GAME_MODE mode, int id, int eq);
+
+/** How the game messages reach the clients, chosen by the server for all its games */
+typedef enum game_transport {
+    MULTICAST_TRANSPORT, // To the multicast group of the game, joined by the clients
+    UNICAST_TRANSPORT,   // To the address each client sends its datagrams from, where multicast is unavailable
+} game_transport;
+
+/** The session token identifies the game of the datagrams sent by its players on the UDP port of the actions,
+ * which may be shared by all the games of the server
+ */
 typedef struct connection_information_raw {
     uint16_t header;
     uint16_t portudp;
     uint16_t portmdiff;
     uint16_t adrmdiff[8];
+    uint16_t token[2]; // Most significant half first
+    uint16_t transport;
 } connection_information_raw;
 
 typedef struct connection_information {
@@ -40,11 +68,15 @@ typedef struct connection_information {
     int portudp;
     int portmdiff;
     uint16_t adrmdiff[8];
+    uint32_t token;
+    game_transport transport; // The multicast group is unused with UNICAST_TRANSPORT
 } connection_information;
 
 connection_information_raw *serialize_connection_information(const connection_information *info);
+int serialize_connection_information_into(const connection_information *info, char *serialized, size_t capacity);
 
 connection_information *deserialize_connection_information(const connection_information_raw *info);
+int deserialize_connection_information_into(const connection_information_raw *info, connection_information *res);
 
 typedef struct game_action {
     GAME_MODE game_mode;
@@ -52,12 +84,21 @@ typedef struct game_action {
     int eq;
     int message_number;
     GAME_ACTION action;
+    uint32_t token; // Session token of the game, after the header
 } game_action;
 
+#define SESSION_TOKEN_SIZE 4
+#define GAME_ACTION_SIZE (4 + SESSION_TOKEN_SIZE) // Bytes of a serialized game action
+
 char *serialize_game_action(const game_action *action);
+int serialize_game_action_into(const game_action *action, char *serialized, size_t capacity);
 
 game_action *deserialize_game_action(const char *action);
 
+/** Deserializes the action in res without allocation, returns EXIT_FAILURE if it is invalid
+ */
+int deserialize_game_action_into(const char *action, game_action *res);
+
 typedef struct game_board_information {
     uint16_t num;
     uint8_t height;
@@ -71,6 +112,85 @@ char *serialize_game_board(const game_board_information *info);
 
 game_board_information *deserialize_game_board(const char *info);
 
+/** Number of bytes of a serialized game board */
+#define GAME_BOARD_SIZE(height, width) ((size_t)6 + (height) * (width))
+
+/** Game board whose tiles are stored elsewhere, in a board grid or in a received message
+ * The boards with more than UINT8_MAX tiles per side are only sent in bands (codereq 20)
+ */
+typedef struct game_board_view {
+    uint16_t num;
+    uint16_t height;
+    uint16_t width;
+    const char *tiles; // height * width tiles of one byte
+} game_board_view;
+
+#define IS_LARGE_BOARD(height, width) ((height) > UINT8_MAX || (width) > UINT8_MAX)
+
+int serialize_game_board_into(const game_board_view *view, char *serialized, size_t capacity);
+
+/** Decodes the size bytes of info, the tiles of view point into info
+ * Returns EXIT_FAILURE if the header is invalid or the message is truncated
+ */
+int deserialize_game_board_view(const char *info, size_t size, game_board_view *view);
+
+/** Encodings of the tiles of a packed game board */
+typedef enum tile_encoding {
+    TILE_NIBBLES = 0, // Two tiles per byte
+    TILE_RUNS = 1,    // A byte per run of identical tiles, the tile and the length of the run on a nibble each
+} tile_encoding;
+
+#define MAX_TILE_RUN 16
+
+/** Header, message number, height, width and encoding */
+#define PACKED_GAME_BOARD_HEADER_SIZE 7
+
+/** Largest number of bytes of a packed game board, the runs are only used when they are smaller */
+#define PACKED_GAME_BOARD_SIZE(height, width) ((size_t)PACKED_GAME_BOARD_HEADER_SIZE + ((height) * (width) + 1) / 2)
+
+/** Serializes the board with the codereq 17, the tiles are packed with the smallest encoding
+ */
+int serialize_packed_game_board_into(const game_board_view *view, char *serialized, size_t capacity);
+
+/** Decodes a game board, packed (codereq 17) or not (codereq 11), of size bytes
+ * The packed tiles are unpacked in tiles, which must have room for all of them, the other ones are not copied
+ * Returns EXIT_FAILURE if the message is invalid or truncated
+ */
+int deserialize_game_board_into(const char *info, size_t size, char *tiles, size_t capacity, game_board_view *view);
+
+/** The large boards are split in bands of whole rows (codereq 20), packed as the boards of the codereq 17:
+ * header, message number, height, width, first row and number of rows on 2 bytes each, then encoding and tiles
+ */
+typedef struct game_board_band_view {
+    uint16_t num;
+    uint16_t height;
+    uint16_t width;
+    uint16_t first_row;
+    uint16_t nb_rows;
+    const char *tiles; // nb_rows * width tiles of one byte, from the first row
+} game_board_band_view;
+
+#define GAME_BOARD_BAND_HEADER_SIZE 13
+#define GAME_BOARD_BAND_TILES 2048 // At most, so that a band of nibbles stays far below the minimal MTU of IPv6
+#define GAME_BOARD_BAND_SIZE (GAME_BOARD_BAND_HEADER_SIZE + GAME_BOARD_BAND_TILES / 2)
+
+/** Number of rows of the bands of a board of the given width */
+#define GAME_BOARD_BAND_ROWS(width) (GAME_BOARD_BAND_TILES / (width))
+
+/** Largest number of bytes of a whole board, in a single message or in bands */
+size_t get_game_board_keyframe_size(uint16_t height, uint16_t width);
+
+/** Serializes the nb_rows rows of view from first_row as a band, in at most GAME_BOARD_BAND_SIZE bytes
+ */
+int serialize_game_board_band_into(const game_board_view *view, uint16_t first_row, uint16_t nb_rows,
+                                   char *serialized, size_t capacity);
+
+/** Decodes a band of size bytes, its tiles are unpacked in tiles, which must have room for GAME_BOARD_BAND_TILES
+ * Returns EXIT_FAILURE if the message is invalid or truncated
+ */
+int deserialize_game_board_band_into(const char *band, size_t size, char *tiles, size_t capacity,
+                                     game_board_band_view *view);
+
 typedef struct game_board_update {
     uint16_t num;
     uint8_t nb;
@@ -79,10 +199,114 @@ typedef struct game_board_update {
 
 void free_game_board_update(game_board_update *update);
 
+/** Number of bytes of a serialized update with nb tile differences */
+#define GAME_BOARD_UPDATE_SIZE(nb) ((size_t)5 + (nb) * 3)
+
 char *serialize_game_board_update(const game_board_update *update);
 
+int serialize_game_board_update_into(const game_board_update *update, char *serialized, size_t capacity);
+
 game_board_update *deserialize_game_board_update(const char *update);
 
+/** The updates of more than UINT8_MAX differences are split in fragments sharing their number (codereq 18):
+ * header, message number, index of the fragment, number of fragments and number of differences
+ */
+typedef struct game_board_update_fragment {
+    uint16_t num;
+    uint8_t index;
+    uint8_t count;
+    uint8_t nb;
+    const tile_diff *diff;
+} game_board_update_fragment;
+
+#define UPDATE_FRAGMENT_HEADER_SIZE 7
+#define UPDATE_FRAGMENT_SIZE(nb) ((size_t)UPDATE_FRAGMENT_HEADER_SIZE + (nb) * 3)
+
+/** A full fragment stays far below the minimal MTU of IPv6 (1280 bytes) */
+#define MAX_UPDATE_FRAGMENTS 8
+#define MAX_UPDATE_DIFFS (MAX_UPDATE_FRAGMENTS * UINT8_MAX)
+
+int serialize_game_board_update_fragment_into(const game_board_update_fragment *fragment, char *serialized,
+                                              size_t capacity);
+
+/** After the whole board, the large boards are sent by regions (see regions.h), each one on its own multicast group
+ * An update of a region (codereq 23) is a fragment with the region on 2 bytes after the message number,
+ * its coordinates are relative to the first tile of the region
+ */
+#define REGION_UPDATE_HEADER_SIZE 9
+#define REGION_UPDATE_SIZE(nb) ((size_t)REGION_UPDATE_HEADER_SIZE + (nb) * 3)
+#define MAX_UPDATE_FRAGMENT_SIZE REGION_UPDATE_SIZE(UINT8_MAX)
+
+int serialize_region_update_fragment_into(const game_board_update_fragment *fragment, uint16_t region,
+                                          char *serialized, size_t capacity);
+
+/** Whole region (codereq 22): header, message number, height and width of the board and region on 2 bytes each,
+ * then the encoding and the tiles of the region, packed as the boards of the codereq 17
+ */
+typedef struct game_region_view {
+    uint16_t num; // Number of the first update of the region following it
+    uint16_t height;
+    uint16_t width;
+    uint16_t region;
+    const char *tiles; // Tiles of the region, row by row
+} game_region_view;
+
+#define GAME_REGION_HEADER_SIZE 11
+#define GAME_REGION_SIZE (GAME_REGION_HEADER_SIZE + REGION_TILES / 2)
+
+int serialize_game_region_into(const game_region_view *view, char *serialized, size_t capacity);
+
+/** Decodes a whole region of size bytes, its tiles are unpacked in tiles, which must have room for REGION_TILES
+ * Returns EXIT_FAILURE if the message is invalid or truncated
+ */
+int deserialize_game_region_into(const char *region, size_t size, char *tiles, size_t capacity,
+                                 game_region_view *view);
+
+/** Update whose differences point into the received message
+ * An update which is not fragmented is its only fragment
+ */
+typedef struct game_board_update_view {
+    uint16_t num;
+    uint8_t index;
+    uint8_t count;
+    uint8_t nb;
+    int region;        // -1 in the updates of the whole board
+    const char *diffs; // nb differences of 3 bytes: x, y and tile
+} game_board_update_view;
+
+/** Decodes the size bytes of update, an update (codereq 12) or a fragment (codereq 18, or 23 for a region)
+ * The differences of view point into update
+ * Returns EXIT_FAILURE if the header is invalid or the message is truncated
+ */
+int deserialize_game_board_update_view(const char *update, size_t size, game_board_update_view *view);
+
+tile_diff get_game_board_update_diff(const game_board_update_view *view, int i);
+
+/** The updates are numbered in sequence and a whole board carries the number of the first update following it:
+ * a client applies the update num on top of the board num, or after the update num - 1
+ */
+
+/** Sent by a client which misses an update, to get a whole board without waiting for the next one
+ * The request of a region (codereq 24) carries the region instead of the number
+ */
+typedef struct keyframe_request {
+    int id;
+    int eq;
+    uint16_t num;   // Number of the first update missing
+    uint32_t token; // Session token of the game, after the header as in the game actions
+} keyframe_request;
+
+#define KEYFRAME_REQUEST_SIZE GAME_ACTION_SIZE // They are received on the same socket
+
+int serialize_keyframe_request_into(const keyframe_request *request, char *serialized, size_t capacity);
+int serialize_region_keyframe_request_into(int id, int eq, uint32_t token, uint16_t region, char *serialized,
+                                           size_t capacity);
+
+/** The number of the request of a region is its region
+ * Returns EXIT_FAILURE if the request is neither the one of a whole board nor the one of a region
+ */
+int deserialize_keyframe_request_into(const char *request, keyframe_request *res, bool *is_region);
+
 typedef enum chat_message_type { GLOBAL_M, TEAM_M } chat_message_type;
 
 typedef struct chat_message {
@@ -101,15 +325,40 @@ char *server_serialize_chat_message(const chat_message *message);
 
 chat_message *server_deserialize_chat_message(const char *message);
 
+/** Number of bytes of a serialized chat message */
+#define CHAT_MESSAGE_SIZE(length) ((size_t)3 + (length))
+
+/** Chat message whose text is stored elsewhere, for instance in the received message */
+typedef struct chat_message_view {
+    chat_message_type type;
+    int id;
+    int eq;
+    uint8_t message_length;
+    const char *message; // Not `\0` terminated
+} chat_message_view;
+
+int client_serialize_chat_message_into(const chat_message_view *message, char *serialized, size_t capacity);
+int server_serialize_chat_message_into(const chat_message_view *message, char *serialized, size_t capacity);
+
+/** Decodes the size bytes of message, the text of view points into message
+ * Returns EXIT_FAILURE if the header is invalid or the message is truncated
+ */
+int client_deserialize_chat_message_view(const char *message, size_t size, chat_message_view *view);
+int server_deserialize_chat_message_view(const char *message, size_t size, chat_message_view *view);
+
 typedef struct game_end {
     GAME_MODE game_mode;
     int id;
     int eq;
 } game_end;
 
+#define GAME_END_SIZE 2 // Bytes of a serialized game end
+
 char *serialize_game_end(const game_end *end);
+int serialize_game_end_into(const game_end *end, char *serialized, size_t capacity);
 
 game_end *deserialize_game_end(const char *end);
+int deserialize_game_end_into(const char *end, game_end *res);
 
 typedef struct message_header {
     int codereq;
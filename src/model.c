@@ -1,8 +1,9 @@
 #include "./model.h"
+#include "./bitboard.h"
 
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
-#include <time.h>
 
 #include "./utils.h"
 
@@ -13,21 +14,32 @@ typedef struct player {
 
 typedef struct bomb {
     coord pos;
-    time_t placement_time;
+    long explosion_time; // Monotonic time in milliseconds
 } bomb;
 
+/** Min-heap of the bombs ordered by explosion time, the next bomb to explode is the first one */
 typedef struct bomb_collection {
     bomb *arr;
     int total_count;
     int max_capacity;
 } bomb_collection;
 
+typedef struct dirty_tiles {
+    int *indexes;        // Tiles changed since the last differences, each one at most once
+    char *initial_tiles; // Value of each of these tiles at the time of the last differences
+    uint8_t *bitmap;     // Bit of each tile of the board set if the tile is in indexes
+    int count;
+} dirty_tiles;
+
 typedef struct game {
     board *game_board;
+    bitboard *planes; // Same tiles as game_board, for the checks over several tiles at once
+    dirty_tiles dirty;
     bomb_collection all_bombs;
     player *players[PLAYER_NUM];
     GAME_MODE game_mode;
     chat *chat;
+    pthread_mutex_t lock; // Held during every access to the game, the games of other ids are not affected
 } game;
 
 static game **games = NULL;
@@ -35,11 +47,15 @@ size_t games_size = 0;
 size_t games_capacity = 10;
 #define GROWTH_FACTOR 2
 
+// Only add_game, remove_game and reset_games change the table, the accesses to the games just read it
+static pthread_rwlock_t lock_games = PTHREAD_RWLOCK_INITIALIZER;
+
 TILE get_player(int);
 
-void free_model(unsigned int game_id);
+static void free_game(game *g);
 
-int add_game(game *g) {
+/** The games table has to be write locked */
+static int add_game(game *g) {
     if (games == NULL) {
         games = malloc(games_capacity * sizeof(game *));
         if (games == NULL) {
@@ -83,31 +99,72 @@ int add_game(game *g) {
     return -1;
 }
 
-game *get_game(unsigned int game_id) {
-    if (game_id >= games_size) {
+/** The games table has to be locked */
+static game *get_game(unsigned int game_id) {
+    if (games == NULL || game_id >= games_capacity) {
         return NULL;
     }
     return games[game_id];
 }
 
+/** Returns the locked game of game_id, NULL if there is none
+ * The game has to be given back to release_game
+ */
+static game *acquire_game(unsigned int game_id) {
+    pthread_rwlock_rdlock(&lock_games);
+    game *g = get_game(game_id);
+    if (g != NULL) {
+        pthread_mutex_lock(&g->lock);
+    }
+    pthread_rwlock_unlock(&lock_games);
+    return g;
+}
+
+static void release_game(game *g) {
+    pthread_mutex_unlock(&g->lock);
+}
+
+/** The game has to be unreachable from the games table */
+static void destroy_game(game *g) {
+    // Wait for the accesses started before the game was removed from the table
+    pthread_mutex_lock(&g->lock);
+    pthread_mutex_unlock(&g->lock);
+
+    pthread_mutex_destroy(&g->lock);
+    free_game(g);
+}
+
 void remove_game(unsigned int game_id) {
-    if (game_id >= games_capacity || games[game_id] == NULL) {
+    pthread_rwlock_wrlock(&lock_games);
+    game *g = get_game(game_id);
+    if (g == NULL) {
+        pthread_rwlock_unlock(&lock_games);
         return;
     }
-
-    free_model(game_id);
     games[game_id] = NULL;
     games_size--;
-    return;
+    pthread_rwlock_unlock(&lock_games);
+
+    destroy_game(g);
 }
 
 void reset_games() {
-    for (size_t i = 0; i < games_capacity; i++) {
-        remove_game(i);
-    }
-
-    free(games);
+    pthread_rwlock_wrlock(&lock_games);
+    game **removed_games = games;
+    size_t removed_games_capacity = games_capacity;
     games = NULL;
+    games_size = 0;
+    pthread_rwlock_unlock(&lock_games);
+
+    if (removed_games == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < removed_games_capacity; i++) {
+        if (removed_games[i] != NULL) {
+            destroy_game(removed_games[i]);
+        }
+    }
+    free(removed_games);
 }
 
 static game *init_game_struct() {
@@ -117,7 +174,18 @@ static game *init_game_struct() {
         return NULL;
     }
 
+    if (pthread_mutex_init(&g->lock, NULL) != 0) {
+        perror("pthread_mutex_init");
+        free(g);
+        return NULL;
+    }
+
     g->game_board = NULL;
+    g->planes = NULL;
+    g->dirty.indexes = NULL;
+    g->dirty.initial_tiles = NULL;
+    g->dirty.bitmap = NULL;
+    g->dirty.count = 0;
     g->all_bombs.arr = NULL;
     g->all_bombs.total_count = 0;
     g->all_bombs.max_capacity = 0;
@@ -140,54 +208,105 @@ TILE get_probably_destructible_wall() {
     return DESTRUCTIBLE_WALL;
 }
 
-int init_game_board_content(unsigned int game_id) {
-    RETURN_FAILURE_IF_NULL(games[game_id]);
+static int position_to_int(const game *g, int x, int y) {
+    return coord_to_int_dim(x, y, g->game_board->dim);
+}
 
-    board *game_board = games[game_id]->game_board;
-    RETURN_FAILURE_IF_NULL(game_board);
+static coord int_to_position(const game *g, int n) {
+    board *game_board = g->game_board;
+    coord c;
+    c.y = n / game_board->dim.width;
+    c.x = n % game_board->dim.width;
+    return c;
+}
+
+static TILE get_tile(const game *g, int x, int y) {
+    board *game_board = g->game_board;
+    if (game_board != NULL) {
+        return game_board->grid[position_to_int(g, x, y)];
+    }
+    return EXIT_FAILURE;
+}
+
+static void mark_dirty_tile(game *g, int i) {
+    dirty_tiles *dirty = &g->dirty;
+    if (dirty->bitmap[i / 8] & (1 << (i % 8))) {
+        return;
+    }
+    dirty->bitmap[i / 8] |= 1 << (i % 8);
+    dirty->indexes[dirty->count] = i;
+    dirty->initial_tiles[dirty->count] = g->game_board->grid[i];
+    dirty->count++;
+}
+
+static void set_tile(game *g, int x, int y, TILE v) {
+    board *game_board = g->game_board;
+    if (game_board != NULL) {
+        int i = position_to_int(g, x, y);
+        if (game_board->grid[i] != (char)v) {
+            mark_dirty_tile(g, i);
+            set_bitboard_tile(g->planes, i, game_board->grid[i], v);
+            game_board->grid[i] = v;
+        }
+    }
+}
+
+/** Forgets the changes of the tiles, the next differences are computed from the current board */
+static void clear_dirty_tiles(game *g) {
+    dirty_tiles *dirty = &g->dirty;
+    for (int k = 0; k < dirty->count; k++) {
+        dirty->bitmap[dirty->indexes[k] / 8] = 0;
+    }
+    dirty->count = 0;
+}
+
+static bool is_outside(const game *g, int x, int y) {
+    board *game_board = g->game_board;
+    return x < 0 || x >= game_board->dim.width || y < 0 || y >= game_board->dim.height;
+}
 
-    srandom(time(NULL));
+static int init_game_board_content(game *g) {
+    board *game_board = g->game_board;
+    RETURN_FAILURE_IF_NULL(game_board);
 
     // Indestructible wall part
     for (int c = 1; c < game_board->dim.width - 1; c += 2) {
         for (int l = 1; l < game_board->dim.height - 1; l += 2) {
-            game_board->grid[coord_to_int(c, l, game_id)] = INDESTRUCTIBLE_WALL;
+            game_board->grid[position_to_int(g, c, l)] = INDESTRUCTIBLE_WALL;
         }
     }
 
     // Destructible wall part
     for (int c = 3; c < game_board->dim.width - 3; c++) { // Fill the first and last line
-        game_board->grid[coord_to_int(c, 0, game_id)] = get_probably_destructible_wall();
-        game_board->grid[coord_to_int(c, game_board->dim.height - 1, game_id)] = get_probably_destructible_wall();
+        game_board->grid[position_to_int(g, c, 0)] = get_probably_destructible_wall();
+        game_board->grid[position_to_int(g, c, game_board->dim.height - 1)] = get_probably_destructible_wall();
     }
 
     for (int c = 2; c < game_board->dim.width - 2; c += 2) { // Fill the second and the second last line
-        game_board->grid[coord_to_int(c, 1, game_id)] = get_probably_destructible_wall();
-        game_board->grid[coord_to_int(c, game_board->dim.height - 2, game_id)] = get_probably_destructible_wall();
+        game_board->grid[position_to_int(g, c, 1)] = get_probably_destructible_wall();
+        game_board->grid[position_to_int(g, c, game_board->dim.height - 2)] = get_probably_destructible_wall();
     }
 
     for (int c = 1; c < game_board->dim.width - 1; c++) { // Fill the third and the third last line
-        game_board->grid[coord_to_int(c, 2, game_id)] = get_probably_destructible_wall();
-        game_board->grid[coord_to_int(c, game_board->dim.height - 3, game_id)] = get_probably_destructible_wall();
+        game_board->grid[position_to_int(g, c, 2)] = get_probably_destructible_wall();
+        game_board->grid[position_to_int(g, c, game_board->dim.height - 3)] = get_probably_destructible_wall();
     }
 
     for (int l = 3; l < game_board->dim.height - 3; l++) { // Fill the other lines
         if (l % 2 == 0) { // There are no indestructible walls between destructible walls on this line
             for (int c = 0; c < game_board->dim.width; c++) {
-                game_board->grid[coord_to_int(c, l, game_id)] = get_probably_destructible_wall();
+                game_board->grid[position_to_int(g, c, l)] = get_probably_destructible_wall();
             }
         } else { // There are indestructible walls between destructible walls on this line
             for (int c = 0; c < game_board->dim.width; c += 2) {
-                game_board->grid[coord_to_int(c, l, game_id)] = get_probably_destructible_wall();
+                game_board->grid[position_to_int(g, c, l)] = get_probably_destructible_wall();
             }
         }
     }
     return EXIT_SUCCESS;
 }
 
-int init_game_board(dimension dim, unsigned int game_id) {
-    RETURN_FAILURE_IF_NULL(games[game_id]);
-
+static int init_game_board(dimension dim, game *g) {
     if (dim.width % 2 == 0) { // The game_board width has to be odd to fill it with content
         dim.width--;
     }
@@ -199,7 +318,7 @@ int init_game_board(dimension dim, unsigned int game_id) {
         return EXIT_FAILURE;
     }
 
-    if (games[game_id]->game_board == NULL) {
+    if (g->game_board == NULL) {
         board *game_board = malloc(sizeof(board));
         RETURN_FAILURE_IF_NULL_PERROR(game_board, "malloc");
 
@@ -207,24 +326,42 @@ int init_game_board(dimension dim, unsigned int game_id) {
         game_board->dim.width = dim.width - 2;   // 2 columns reserved for border
 
         game_board->grid = calloc((game_board->dim.width) * (game_board->dim.height), sizeof(char));
-        RETURN_FAILURE_IF_NULL_PERROR(game_board->grid, "calloc");
+        if (game_board->grid == NULL) {
+            perror("calloc");
+            free(game_board);
+            return EXIT_FAILURE;
+        }
 
-        games[game_id]->game_board = game_board;
+        g->game_board = game_board;
     }
 
-    if (init_game_board_content(game_id) == EXIT_FAILURE) {
-        free_board(games[game_id]->game_board);
-        return EXIT_FAILURE;
+    int nb_tiles = g->game_board->dim.width * g->game_board->dim.height;
+    g->dirty.indexes = malloc(nb_tiles * sizeof(int));
+    RETURN_FAILURE_IF_NULL_PERROR(g->dirty.indexes, "malloc");
+    g->dirty.initial_tiles = malloc(nb_tiles * sizeof(char));
+    RETURN_FAILURE_IF_NULL_PERROR(g->dirty.initial_tiles, "malloc");
+    g->dirty.bitmap = calloc((nb_tiles + 7) / 8, sizeof(uint8_t));
+    RETURN_FAILURE_IF_NULL_PERROR(g->dirty.bitmap, "calloc");
+
+    // At most one bomb per tile, so that placing a bomb never reallocates during the game
+    g->all_bombs.arr = malloc(nb_tiles * sizeof(bomb));
+    RETURN_FAILURE_IF_NULL_PERROR(g->all_bombs.arr, "malloc");
+    g->all_bombs.max_capacity = nb_tiles;
+
+    RETURN_FAILURE_IF_ERROR(init_game_board_content(g));
+
+    g->planes = create_bitboard(g->game_board->dim);
+    RETURN_FAILURE_IF_NULL(g->planes);
+    for (int i = 0; i < nb_tiles; i++) {
+        set_bitboard_tile(g->planes, i, EMPTY, g->game_board->grid[i]);
     }
 
     return EXIT_SUCCESS;
 }
 
-int init_player_positions(unsigned int game_id) {
-    RETURN_FAILURE_IF_NULL(games[game_id]);
-
-    player **players = games[game_id]->players;
-    board *game_board = games[game_id]->game_board;
+static int init_player_positions(game *g) {
+    player **players = g->players;
+    board *game_board = g->game_board;
 
     for (int i = 0; i < 4; i++) {
         players[i] = malloc(sizeof(player));
@@ -242,17 +379,15 @@ int init_player_positions(unsigned int game_id) {
 
         players[i]->dead = false;
 
-        set_grid(players[i]->pos->x, players[i]->pos->y, get_player(i), game_id);
+        set_tile(g, players[i]->pos->x, players[i]->pos->y, get_player(i));
     }
     return EXIT_SUCCESS;
 }
 
-int init_game_chat(unsigned int game_id) {
-    RETURN_FAILURE_IF_NULL(games[game_id]);
-
-    if (games[game_id]->chat == NULL) {
-        games[game_id]->chat = create_chat();
-        RETURN_FAILURE_IF_NULL(games[game_id]->chat);
+static int init_game_chat(game *g) {
+    if (g->chat == NULL) {
+        g->chat = create_chat();
+        RETURN_FAILURE_IF_NULL(g->chat);
     }
 
     return EXIT_SUCCESS;
@@ -266,20 +401,22 @@ int init_model(dimension dim, GAME_MODE game_mode_) {
 
     g->game_mode = game_mode_;
 
-    int game_id = add_game(g);
-
-    if (game_id == -1) {
+    // The game is entirely built before being published in the table
+    if (init_game_board(dim, g) == EXIT_FAILURE || init_player_positions(g) == EXIT_FAILURE ||
+        init_game_chat(g) == EXIT_FAILURE) {
+        pthread_mutex_destroy(&g->lock);
+        free_game(g);
         return -1;
     }
+    clear_dirty_tiles(g); // The initial board is sent entirely
 
-    if (init_game_board(dim, game_id) == EXIT_FAILURE) {
-        return -1;
-    }
+    pthread_rwlock_wrlock(&lock_games);
+    int game_id = add_game(g);
+    pthread_rwlock_unlock(&lock_games);
 
-    if (init_player_positions(game_id) == EXIT_FAILURE) {
-        return -1;
-    }
-    if (init_game_chat(game_id) == EXIT_FAILURE) {
+    if (game_id == -1) {
+        pthread_mutex_destroy(&g->lock);
+        free_game(g);
         return -1;
     }
 
@@ -297,36 +434,31 @@ void free_board(board *game_board) {
     }
 }
 
-void free_game_board(unsigned int game_id) {
-    if (games[game_id] == NULL) {
-        return;
-    }
-    board *game_board = games[game_id]->game_board;
-    free_board(game_board);
-}
-
-void free_player_positions(unsigned int game_id) {
-    if (games[game_id] == NULL) {
-        return;
-    }
+static void free_player_positions(game *g) {
     for (int i = 0; i < PLAYER_NUM; i++) {
-        if (games[game_id]->players[i] != NULL) {
-            if (games[game_id]->players[i]->pos != NULL) {
-                free(games[game_id]->players[i]->pos);
-                games[game_id]->players[i]->pos = NULL;
+        if (g->players[i] != NULL) {
+            if (g->players[i]->pos != NULL) {
+                free(g->players[i]->pos);
+                g->players[i]->pos = NULL;
             }
-            free(games[game_id]->players[i]);
-            games[game_id]->players[i] = NULL;
+            free(g->players[i]);
+            g->players[i] = NULL;
         }
     }
 }
 
-void free_model(unsigned int game_id) {
-    free_game_board(game_id);
-    free_chat(games[game_id]->chat);
-    games[game_id]->chat = NULL;
-    free_player_positions(game_id);
-    free(games[game_id]);
+static void free_game(game *g) {
+    free_board(g->game_board);
+    g->game_board = NULL;
+    free_bitboard(g->planes);
+    free(g->dirty.indexes);
+    free(g->dirty.initial_tiles);
+    free(g->dirty.bitmap);
+    free_chat(g->chat);
+    g->chat = NULL;
+    free_player_positions(g);
+    free(g->all_bombs.arr);
+    free(g);
 }
 
 char tile_to_char(TILE t) {
@@ -370,27 +502,29 @@ char tile_to_char(TILE t) {
 }
 
 bool is_outside_board(int x, int y, unsigned int game_id) {
-    if (games[game_id] == NULL) {
+    game *g = acquire_game(game_id);
+    if (g == NULL) {
         return true;
     }
-    board *game_board = games[game_id]->game_board;
-    return x < 0 || x >= game_board->dim.width || y < 0 || y >= game_board->dim.height;
+    bool outside = is_outside(g, x, y);
+    release_game(g);
+    return outside;
 }
 
-bool can_move_to_position(int x, int y, unsigned int game_id) {
-    if (is_outside_board(x, y, game_id)) {
+static bool can_move_to_position(const game *g, int x, int y) {
+    if (is_outside(g, x, y)) {
         return false;
     }
-    TILE t = get_grid(x, y, game_id);
-    return t != BOMB && t != INDESTRUCTIBLE_WALL && t != DESTRUCTIBLE_WALL && t != PLAYER_1 && t != PLAYER_2 &&
-           t != PLAYER_3 && t != PLAYER_4;
+    return !is_in_planes(g->planes, BLOCKING_TILES, position_to_int(g, x, y));
 }
 
 coord int_to_coord(int n, unsigned int game_id) {
-    board *game_board = games[game_id]->game_board;
-    coord c;
-    c.y = n / game_board->dim.width;
-    c.x = n % game_board->dim.width;
+    coord c = {0, 0};
+    game *g = acquire_game(game_id);
+    if (g != NULL) {
+        c = int_to_position(g, n);
+        release_game(g);
+    }
     return c;
 }
 
@@ -399,27 +533,30 @@ int coord_to_int_dim(int x, int y, dimension dim) {
 }
 
 int coord_to_int(int x, int y, unsigned int game_id) {
-    board *game_board = games[game_id]->game_board;
-    return coord_to_int_dim(x, y, game_board->dim);
+    game *g = acquire_game(game_id);
+    if (g == NULL) {
+        return -1;
+    }
+    int n = position_to_int(g, x, y);
+    release_game(g);
+    return n;
 }
 
 TILE get_grid(int x, int y, unsigned int game_id) {
-    RETURN_FAILURE_IF_NULL(games[game_id]);
+    game *g = acquire_game(game_id);
+    RETURN_FAILURE_IF_NULL(g);
 
-    board *game_board = games[game_id]->game_board;
-    if (game_board != NULL) {
-        return game_board->grid[coord_to_int(x, y, game_id)];
-    }
-    return EXIT_FAILURE;
+    TILE t = get_tile(g, x, y);
+    release_game(g);
+    return t;
 }
 
 void set_grid(int x, int y, TILE v, unsigned int game_id) {
-    RETURN_IF_NULL(games[game_id]);
+    game *g = acquire_game(game_id);
+    RETURN_IF_NULL(g);
 
-    board *game_board = games[game_id]->game_board;
-    if (game_board != NULL) {
-        game_board->grid[coord_to_int(x, y, game_id)] = v;
-    }
+    set_tile(g, x, y, v);
+    release_game(g);
 }
 
 TILE get_player(int player_id) {
@@ -480,10 +617,8 @@ coord get_next_position(GAME_ACTION a, const coord *pos) {
     return c;
 }
 
-void perform_move(GAME_ACTION a, int player_id, unsigned int game_id) {
-    RETURN_IF_NULL(games[game_id]);
-
-    player **players = games[game_id]->players;
+static void move_player(game *g, GAME_ACTION a, int player_id) {
+    player **players = g->players;
 
     if (players[player_id]->dead) {
         return;
@@ -493,22 +628,71 @@ void perform_move(GAME_ACTION a, int player_id, unsigned int game_id) {
     coord old_pos = *current_pos;
 
     coord c = get_next_position(a, current_pos);
-    if (!can_move_to_position(c.x, c.y, game_id)) {
+    if (!can_move_to_position(g, c.x, c.y)) {
         return;
     }
     current_pos->x = c.x;
     current_pos->y = c.y;
-    set_grid(current_pos->x, current_pos->y, get_player(player_id), game_id);
-    if (get_grid(old_pos.x, old_pos.y, game_id) != BOMB) {
-        set_grid(old_pos.x, old_pos.y, EMPTY, game_id);
+    set_tile(g, current_pos->x, current_pos->y, get_player(player_id));
+    if (get_tile(g, old_pos.x, old_pos.y) != BOMB) {
+        set_tile(g, old_pos.x, old_pos.y, EMPTY);
     }
 }
-void place_bomb(int player_id, unsigned int game_id) {
 
-    RETURN_IF_NULL(games[game_id]);
+void perform_move(GAME_ACTION a, int player_id, unsigned int game_id) {
+    game *g = acquire_game(game_id);
+    RETURN_IF_NULL(g);
+
+    move_player(g, a, player_id);
+    release_game(g);
+}
+
+static void swap_bombs(bomb_collection *bombs, int i, int j) {
+    bomb tmp = bombs->arr[i];
+    bombs->arr[i] = bombs->arr[j];
+    bombs->arr[j] = tmp;
+}
+
+/** The capacity of the collection has to be sufficient */
+static void push_bomb(bomb_collection *bombs, bomb b) {
+    int i = bombs->total_count;
+    bombs->arr[i] = b;
+    bombs->total_count++;
+
+    while (i > 0 && bombs->arr[(i - 1) / 2].explosion_time > bombs->arr[i].explosion_time) {
+        swap_bombs(bombs, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
 
-    game *g = games[game_id];
+/** The collection must not be empty */
+static bomb pop_bomb(bomb_collection *bombs) {
+    bomb first = bombs->arr[0];
+    bombs->total_count--;
+    bombs->arr[0] = bombs->arr[bombs->total_count];
+
+    int i = 0;
+    while (true) {
+        int smallest = i;
+        int left = 2 * i + 1;
+        int right = 2 * i + 2;
+        if (left < bombs->total_count && bombs->arr[left].explosion_time < bombs->arr[smallest].explosion_time) {
+            smallest = left;
+        }
+        if (right < bombs->total_count && bombs->arr[right].explosion_time < bombs->arr[smallest].explosion_time) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            break;
+        }
+        swap_bombs(bombs, i, smallest);
+        i = smallest;
+    }
 
+    return first;
+}
+
+static void add_bomb(game *g, int player_id) {
     if (g->all_bombs.total_count == g->all_bombs.max_capacity) {
         int new_capacity = (g->all_bombs.max_capacity == 0) ? 4 : g->all_bombs.max_capacity * 2;
         bomb *new_list = realloc(g->all_bombs.arr, new_capacity * sizeof(bomb));
@@ -518,11 +702,11 @@ void place_bomb(int player_id, unsigned int game_id) {
         g->all_bombs.max_capacity = new_capacity;
     }
 
-    player **players = games[game_id]->players;
+    player **players = g->players;
 
     coord current_pos = *players[player_id]->pos;
 
-    TILE t = get_grid(current_pos.x, current_pos.y, game_id);
+    TILE t = get_tile(g, current_pos.x, current_pos.y);
     if (t == BOMB) { // Shouldn't be able to place a bomb on top of an another
         return;
     }
@@ -530,21 +714,26 @@ void place_bomb(int player_id, unsigned int game_id) {
     bomb new_bomb;
     new_bomb.pos.x = current_pos.x;
     new_bomb.pos.y = current_pos.y;
-    new_bomb.placement_time = time(NULL);
+    new_bomb.explosion_time = get_time_ms() + BOMB_LIFETIME;
 
-    g->all_bombs.arr[g->all_bombs.total_count] = new_bomb;
-    g->all_bombs.total_count++;
+    push_bomb(&g->all_bombs, new_bomb);
 
-    set_grid(current_pos.x, current_pos.y, BOMB, game_id);
+    set_tile(g, current_pos.x, current_pos.y, BOMB);
 }
 
-board *get_game_board(unsigned int game_id) {
-    RETURN_NULL_IF_NULL(games[game_id]);
+void place_bomb(int player_id, unsigned int game_id) {
+    game *g = acquire_game(game_id);
+    RETURN_IF_NULL(g);
+
+    add_bomb(g, player_id);
+    release_game(g);
+}
 
+static board *copy_game_board(const game *g) {
     board *copy = malloc(sizeof(board));
     RETURN_NULL_IF_NULL_PERROR(copy, "malloc");
 
-    board *game_board = games[game_id]->game_board;
+    board *game_board = g->game_board;
 
     copy->dim.width = game_board->dim.width;
     copy->dim.height = game_board->dim.height;
@@ -562,46 +751,85 @@ board *get_game_board(unsigned int game_id) {
     return copy;
 }
 
+board *get_game_board(unsigned int game_id) {
+    game *g = acquire_game(game_id);
+    RETURN_NULL_IF_NULL(g);
+
+    board *copy = copy_game_board(g);
+    release_game(g);
+    return copy;
+}
+
+int get_game_dimension(unsigned int game_id, dimension *dim) {
+    game *g = acquire_game(game_id);
+    RETURN_FAILURE_IF_NULL(g);
+
+    *dim = g->game_board->dim;
+    release_game(g);
+    return EXIT_SUCCESS;
+}
+
 GAME_MODE get_game_mode(unsigned int game_id) {
-    return games[game_id]->game_mode;
+    game *g = acquire_game(game_id);
+    if (g == NULL) {
+        return SOLO;
+    }
+
+    GAME_MODE game_mode = g->game_mode;
+    release_game(g);
+    return game_mode;
 }
 
 bool is_player_dead(int id, unsigned int game_id) {
-    if (games[game_id] == NULL) {
+    game *g = acquire_game(game_id);
+    if (g == NULL) {
         return true;
     }
 
-    return games[game_id]->players[id]->dead;
+    bool dead = g->players[id]->dead;
+    release_game(g);
+    return dead;
 }
 
-void set_player_dead(unsigned int game_id, int player_id) {
-    if (games[game_id] == NULL) {
-        return;
+int get_player_positions(unsigned int game_id, coord positions[PLAYER_NUM]) {
+    game *g = acquire_game(game_id);
+    RETURN_FAILURE_IF_NULL(g);
+
+    for (int i = 0; i < PLAYER_NUM; i++) {
+        positions[i] = *g->players[i]->pos;
     }
-    for (int i = 0; i < games[game_id]->game_board->dim.width * games[game_id]->game_board->dim.height; i++) {
-        coord c = int_to_coord(i, game_id);
-        if (get_grid(c.x, c.y, game_id) == get_player(player_id)) {
-            set_grid(c.x, c.y, EMPTY, game_id);
-            break;
-        }
+    release_game(g);
+    return EXIT_SUCCESS;
+}
+
+void set_player_dead(unsigned int game_id, int player_id) {
+    game *g = acquire_game(game_id);
+    RETURN_IF_NULL(g);
+
+    int nb_tiles = g->game_board->dim.width * g->game_board->dim.height;
+    int i = find_first_in_planes(g->planes, TILE_MASK(get_player(player_id)), 0, nb_tiles - 1);
+    if (i != -1) {
+        coord c = int_to_position(g, i);
+        set_tile(g, c.x, c.y, EMPTY);
     }
-    games[game_id]->players[player_id]->dead = true;
+    g->players[player_id]->dead = true;
+    release_game(g);
 }
 
-bool apply_explosion_effect(int x, int y, unsigned int game_id) {
-    if (is_outside_board(x, y, game_id)) {
+static bool apply_explosion_effect(game *g, int x, int y) {
+    if (is_outside(g, x, y)) {
         return false;
     }
 
     bool impact_happened = false;
 
-    player **players = games[game_id]->players;
+    player **players = g->players;
 
-    TILE t = get_grid(x, y, game_id);
+    TILE t = get_tile(g, x, y);
     int id;
     switch (t) {
         case DESTRUCTIBLE_WALL:
-            set_grid(x, y, EMPTY, game_id);
+            set_tile(g, x, y, EMPTY);
             impact_happened = true;
             break;
         case PLAYER_1:
@@ -610,7 +838,7 @@ bool apply_explosion_effect(int x, int y, unsigned int game_id) {
         case PLAYER_4:
             id = get_player_id(t);
             players[id]->dead = true;
-            set_grid(x, y, EMPTY, game_id);
+            set_tile(g, x, y, EMPTY);
             break;
         case INDESTRUCTIBLE_WALL:
             impact_happened = true;
@@ -633,10 +861,35 @@ bool apply_explosion_effect(int x, int y, unsigned int game_id) {
     return impact_happened;
 }
 
-void update_explosion(bomb b, unsigned int game_id) {
-    RETURN_IF_NULL(games[game_id]);
+/** Applies the explosion on the row of pos up to 2 tiles in the direction (1 or -1), until the first wall included
+ */
+static void explode_row(game *g, coord pos, int direction) {
+    int last_x = pos.x + 2 * direction;
+    if (last_x < 0) {
+        last_x = 0;
+    } else if (last_x >= g->game_board->dim.width) {
+        last_x = g->game_board->dim.width - 1;
+    }
 
-    player **players = games[game_id]->players;
+    // The tiles of a row are contiguous in the planes, so the wall is found with word operations
+    int row = position_to_int(g, 0, pos.y);
+    int wall;
+    if (direction > 0) {
+        wall = find_first_in_planes(g->planes, WALL_TILES, row + pos.x, row + last_x);
+    } else {
+        wall = find_last_in_planes(g->planes, WALL_TILES, row + last_x, row + pos.x);
+    }
+    if (wall != -1) {
+        last_x = wall - row;
+    }
+
+    for (int x = pos.x; x != last_x + direction; x += direction) {
+        apply_explosion_effect(g, x, pos.y);
+    }
+}
+
+static void update_explosion(game *g, bomb b) {
+    player **players = g->players;
 
     int x, y;
 
@@ -652,7 +905,7 @@ void update_explosion(bomb b, unsigned int game_id) {
     x = b.pos.x;
     for (int k = 0; k <= 2; ++k) {
         y = b.pos.y + k;
-        if (apply_explosion_effect(x, y, game_id)) {
+        if (apply_explosion_effect(g, x, y)) {
             break;
         }
     }
@@ -660,114 +913,127 @@ void update_explosion(bomb b, unsigned int game_id) {
     x = b.pos.x;
     for (int k = 0; k >= -2; --k) {
         y = b.pos.y + k;
-        if (apply_explosion_effect(x, y, game_id)) {
+        if (apply_explosion_effect(g, x, y)) {
             break;
         }
     }
 
     // Horizontal center
-    y = b.pos.y;
-    for (int k = 0; k <= 2; ++k) {
-        x = b.pos.x + k;
-        if (apply_explosion_effect(x, y, game_id)) {
-            break;
-        }
-    }
-
-    x = b.pos.x;
-    for (int k = 0; k >= -2; --k) {
-        x = b.pos.x + k;
-        if (apply_explosion_effect(x, y, game_id)) {
-            break;
-        }
-    }
+    explode_row(g, b.pos, 1);
+    explode_row(g, b.pos, -1);
 
     // Diagonals
     x = b.pos.x;
     y = b.pos.y;
-    apply_explosion_effect(x + 1, y + 1, game_id);
-    apply_explosion_effect(x + 1, y - 1, game_id);
-    apply_explosion_effect(x - 1, y + 1, game_id);
-    apply_explosion_effect(x - 1, y - 1, game_id);
+    apply_explosion_effect(g, x + 1, y + 1);
+    apply_explosion_effect(g, x + 1, y - 1);
+    apply_explosion_effect(g, x - 1, y + 1);
+    apply_explosion_effect(g, x - 1, y - 1);
 }
 
-void update_bombs(unsigned int game_id) {
-    RETURN_IF_NULL(games[game_id]);
+/** Only the bombs whose time has come are visited */
+static void explode_bombs(game *g) {
+    long current_time = get_time_ms();
 
-    game *g = games[game_id];
+    while (g->all_bombs.total_count > 0 && g->all_bombs.arr[0].explosion_time <= current_time) {
+        bomb b = pop_bomb(&g->all_bombs);
+        update_explosion(g, b);
+        set_tile(g, b.pos.x, b.pos.y, EMPTY);
+    }
+}
 
-    time_t current_time = time(NULL);
+void update_bombs(unsigned int game_id) {
+    game *g = acquire_game(game_id);
+    RETURN_IF_NULL(g);
+
+    explode_bombs(g);
+    release_game(g);
+}
 
-    for (int i = 0; i < g->all_bombs.total_count; ++i) {
-        bomb b = g->all_bombs.arr[i];
-        if (difftime(current_time, b.placement_time) >= BOMB_LIFETIME) {
-            update_explosion(b, game_id);
-            set_grid(b.pos.x, b.pos.y, EMPTY, game_id);
+/** Writes in res_diffs the tiles changed since the last call, at most max_diffs, and returns the number of changed
+ * tiles, including the ones which do not fit
+ * A tile changed back to its initial value is not included
+ * It only goes through the dirty tiles, not the whole board
+ */
+static unsigned get_dirty_tiles_diff(game *g, tile_diff *res_diffs, unsigned max_diffs) {
+    dirty_tiles *dirty = &g->dirty;
 
-            // Get rid of the exploded bomb
-            g->all_bombs.total_count -= 1;
-            g->all_bombs.arr[i] = g->all_bombs.arr[g->all_bombs.total_count]; // no need to free memory
+    unsigned cmpt = 0;
+    for (int k = 0; k < dirty->count; k++) {
+        int i = dirty->indexes[k];
+        if (g->game_board->grid[i] == dirty->initial_tiles[k]) {
+            continue;
+        }
+        if (cmpt >= max_diffs) {
+            cmpt++; // Only counted, so that the caller knows that the differences do not fit
+            continue;
         }
+        coord c = int_to_position(g, i);
+
+        tile_diff diff;
+        diff.x = c.x;
+        diff.y = c.y;
+        diff.tile = g->game_board->grid[i];
+
+        res_diffs[cmpt] = diff;
+        cmpt++;
     }
+    clear_dirty_tiles(g);
+
+    return cmpt;
 }
 
-tile_diff *get_diff_with_board(unsigned game_id, board *different_board, unsigned *size_tile_diff) {
-    board *current_board = games[game_id]->game_board;
-    if (current_board->dim.height != different_board->dim.height ||
-        current_board->dim.width != different_board->dim.width || size_tile_diff == NULL) {
-        return NULL;
-    }
-    unsigned cmpt = 0;
-    tile_diff diffs[current_board->dim.width * current_board->dim.height];
-    for (int i = 0; i < current_board->dim.height * current_board->dim.width; i++) {
-        if (current_board->grid[i] != different_board->grid[i]) {
-            coord c = int_to_coord(i, game_id);
-
-            tile_diff diff;
-            diff.x = c.x;
-            diff.y = c.y;
-            diff.tile = current_board->grid[i];
-
-            diffs[cmpt] = diff;
-            cmpt++;
+static void apply_actions(game *g, const player_action *actions, size_t nb_game_actions) {
+    for (unsigned i = 0; i < nb_game_actions; i++) {
+        if (actions[i].action == GAME_PLACE_BOMB) {
+            add_bomb(g, actions[i].id);
+        } else {
+            move_player(g, actions[i].action, actions[i].id);
         }
     }
-    tile_diff *res_diffs = malloc(sizeof(tile_diff) * cmpt);
-    RETURN_NULL_IF_NULL(res_diffs);
-    memmove(res_diffs, diffs, sizeof(tile_diff) * cmpt);
-    *size_tile_diff = cmpt;
-    return res_diffs;
+    explode_bombs(g);
 }
 
 tile_diff *update_game_board(unsigned game_id, player_action *actions, size_t nb_game_actions,
                              unsigned *size_tile_diff) {
     RETURN_NULL_IF_NULL(size_tile_diff);
 
-    board *current_board = get_game_board(game_id);
-    RETURN_NULL_IF_NULL(current_board);
+    game *g = acquire_game(game_id);
+    RETURN_NULL_IF_NULL(g);
 
-    for (unsigned i = 0; i < nb_game_actions; i++) {
-        if (actions[i].action == GAME_PLACE_BOMB) {
-            place_bomb(actions[i].id, game_id);
-        } else {
-            perform_move(actions[i].action, actions[i].id, game_id);
-        }
+    // The whole tick is applied while holding the lock of this game only
+    apply_actions(g, actions, nb_game_actions);
+
+    tile_diff *diffs = malloc(sizeof(tile_diff) * g->dirty.count);
+    if (diffs == NULL) {
+        perror("malloc");
+        release_game(g);
+        return NULL;
     }
-    update_bombs(game_id);
-    tile_diff *diffs = get_diff_with_board(game_id, current_board, size_tile_diff);
-    free(current_board);
+    *size_tile_diff = get_dirty_tiles_diff(g, diffs, g->dirty.count);
+    release_game(g);
+
     return diffs;
 }
 
-bool is_game_over(unsigned int game_id) {
-    if (games[game_id] == NULL) {
-        return true;
+int update_game_board_into(unsigned game_id, const player_action *actions, size_t nb_game_actions,
+                           tile_diff *diffs, unsigned max_diffs) {
+    game *g = acquire_game(game_id);
+    if (g == NULL) {
+        return -1;
     }
 
-    player **players = games[game_id]->players;
-    GAME_MODE game_mode = get_game_mode(game_id);
+    apply_actions(g, actions, nb_game_actions);
+    unsigned size_tile_diff = get_dirty_tiles_diff(g, diffs, max_diffs);
+    release_game(g);
 
-    if (game_mode == SOLO) {
+    return size_tile_diff;
+}
+
+static bool is_over(const game *g) {
+    player *const *players = g->players;
+
+    if (g->game_mode == SOLO) {
         int alive_count = 0;
         for (int i = 0; i < PLAYER_NUM; ++i) {
             if (!players[i]->dead) {
@@ -786,44 +1052,63 @@ bool is_game_over(unsigned int game_id) {
     return team1_dead || team2_dead;
 }
 
+bool is_game_over(unsigned int game_id) {
+    game *g = acquire_game(game_id);
+    if (g == NULL) {
+        return true;
+    }
+
+    bool game_over = is_over(g);
+    release_game(g);
+    return game_over;
+}
+
 int get_winner_solo(unsigned int game_id) {
-    if (games[game_id] == NULL) {
+    game *g = acquire_game(game_id);
+    if (g == NULL) {
         return -1;
     }
 
-    player **players = games[game_id]->players;
+    player **players = g->players;
 
-    for (int i = 0; i < PLAYER_NUM; i++) {
+    int winner = -1;
+    for (int i = 0; i < PLAYER_NUM && winner == -1; i++) {
         for (int j = 0; j < PLAYER_NUM; j++) {
             if (i != j && !players[i]->dead && players[j]->dead) {
-                return i;
+                winner = i;
+                break;
             }
         }
     }
 
-    return -1;
+    release_game(g);
+    return winner;
 }
 
 int get_winner_team(unsigned int game_id) {
-    if (games[game_id] == NULL) {
+    game *g = acquire_game(game_id);
+    if (g == NULL) {
         return -1;
     }
 
-    player **players = games[game_id]->players;
+    player **players = g->players;
 
+    int winner = -1;
     if (players[0]->dead && players[3]->dead) {
-        return 1;
-    }
-
-    if (players[1]->dead && players[2]->dead) {
-        return 0;
+        winner = 1;
+    } else if (players[1]->dead && players[2]->dead) {
+        winner = 0;
     }
 
-    return -1;
+    release_game(g);
+    return winner;
 }
 
 chat *get_chat(unsigned int game_id) {
-    RETURN_NULL_IF_NULL(games[game_id]);
+    game *g = acquire_game(game_id);
+    RETURN_NULL_IF_NULL(g);
 
-    return games[game_id]->chat;
+    chat *c = g->chat;
+    release_game(g);
+    return c;
 }
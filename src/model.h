@@ -67,11 +67,15 @@ typedef struct player_action {
 } player_action;
 
 typedef struct tile_diff {
-    uint8_t x;
-    uint8_t y;
+    uint16_t x; // On 1 byte in the messages of the boards of at most 255 tiles per side
+    uint16_t y;
     TILE tile;
 } tile_diff;
 
+/** The games can be used from several threads: each game has its own lock, taken by the functions below for the
+ * time of the call, so the accesses to a game never wait for the accesses to another game.
+ */
+
 /** Initializes - The game board with the width and the height
  *              - The chat line
  *              - The current position of the player
@@ -87,6 +91,7 @@ void reset_games();
 /** Frees - The game board with the width and the height
  *              - The chat line
  *              - The current position of the players
+ * It waits for the calls in progress on this game
  */
 void remove_game(unsigned int game_id);
 
@@ -138,24 +143,41 @@ void place_bomb(int player_id, unsigned int game_id);
  */
 board *get_game_board(unsigned int game_id);
 
+/** Writes the dimension of the game board, without its border, in dim
+ */
+int get_game_dimension(unsigned int game_id, dimension *dim);
+
 /** Returns the game mode of the current game
  */
 GAME_MODE get_game_mode(unsigned int game_id);
 
 bool is_player_dead(int, unsigned int game_id);
 
+/** Writes the position of each player in positions, the dead players stay where they died
+ */
+int get_player_positions(unsigned int game_id, coord positions[PLAYER_NUM]);
+
 void set_player_dead(unsigned int game_id, int player_id);
 
-/** Iterates over all bombs, removing any that have exceeded their lifetime.
+/** Explodes the bombs which have exceeded their lifetime, the other bombs are not visited.
  */
 void update_bombs(unsigned int game_id);
 
-/** Returns the tiles of the board of game_id after actions modication, which differates with current board, and change
- * size_tile_diff with the size of the result
+/** Returns the tiles of the board of game_id after actions modication, which differates with the board of the
+ * previous call (changes of the other functions since then included), and change size_tile_diff with the size of the
+ * result
+ * The actions and the bombs are applied atomically for the other threads
  */
 tile_diff *update_game_board(unsigned game_id, player_action *actions, size_t nb_game_actions,
                              unsigned *size_tile_diff);
 
+/** Same as update_game_board, but the differences are written in diffs without allocation
+ * At most max_diffs differences are written, the other ones are only visible in the next whole board
+ * Returns the number of differences, written or not, -1 if the game does not exist
+ */
+int update_game_board_into(unsigned game_id, const player_action *actions, size_t nb_game_actions,
+                           tile_diff *diffs, unsigned max_diffs);
+
 /** Returns true if the game is over
  */
 bool is_game_over(unsigned int game_id);
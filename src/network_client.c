@@ -4,6 +4,7 @@
 #include "utils.h"
 
 #include <arpa/inet.h>
+#include <errno.h>
 #include <net/if.h>
 #include <netinet/in.h>
 #include <stdint.h>
@@ -14,8 +15,6 @@
 
 static const char *IP_SERVER = "::1";
 
-static int message_gameboard_max_size = GAMEBOARD_WIDTH * GAMEBOARD_HEIGHT + 6;
-
 static int sock_tcp = -1;
 static int sock_udp = -1;
 static int sock_diff = -1;
@@ -31,6 +30,8 @@ static uint16_t adrmdiff[8];
 
 static int id;
 static int eq;
+static uint32_t token;           // Session token of the game, carried by the datagrams sent to the server
+static game_transport transport; // In unicast, the game messages come on sock_udp and sock_diff is not used
 
 void free_internal_info() {
     free(addr_udp);
@@ -204,11 +205,17 @@ int init_udp_info(connection_information *head) {
 int set_server_informations(connection_information *head) {
     id = head->id;
     eq = head->eq;
+    token = head->token;
+    transport = head->transport;
     for (unsigned i = 0; i < 8; i++) {
         adrmdiff[i] = head->adrmdiff[i];
     }
 
-    RETURN_FAILURE_IF_ERROR(init_diff_info(head));
+    // In unicast, the server sends the game messages where the datagrams of the client come from, once the game has
+    // started it learns the address with the first requests of a whole board
+    if (transport == MULTICAST_TRANSPORT) {
+        RETURN_FAILURE_IF_ERROR(init_diff_info(head));
+    }
     RETURN_FAILURE_IF_ERROR(init_udp_info(head));
 
     return EXIT_SUCCESS;
@@ -231,83 +238,134 @@ int send_ready_to_play(GAME_MODE mode) {
     return send_ready_connexion_information(sock_tcp, mode, id, eq);
 }
 
-received_game_message *recv_game_message() {
-    received_game_message *recieved = malloc(sizeof(received_game_message));
-    RETURN_NULL_IF_NULL_PERROR(recieved, "malloc received_game_message");
+int get_game_message_socket() {
+    return transport == UNICAST_TRANSPORT ? sock_udp : sock_diff;
+}
 
-    char *message = malloc(sizeof(char) * message_gameboard_max_size);
-    memset(message, 0, sizeof(char) * message_gameboard_max_size);
-    int res = recvfrom(sock_diff, message, message_gameboard_max_size, 0, NULL, 0);
+int get_server_socket() {
+    return sock_tcp;
+}
 
-    if (res < 0) {
-        free(message);
-        free(recieved);
-        return NULL;
-    } else if (res < 5) {
-        free(message);
-        free(recieved);
-        return NULL;
+int recv_game_message(char *buffer, size_t capacity, game_message_type *type) {
+    struct sockaddr_in6 source;
+    socklen_t source_len = sizeof(source);
+    int res =
+        recvfrom(get_game_message_socket(), buffer, capacity, MSG_DONTWAIT, (struct sockaddr *)&source, &source_len);
+    if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return 0;
+    }
+    if (res < (int)GAME_BOARD_UPDATE_SIZE(0)) {
+        return -1;
+    }
+    // In unicast, anyone could send to sock_udp, only the datagrams of the server are game messages
+    if (transport == UNICAST_TRANSPORT &&
+        memcmp(&source.sin6_addr, &addr_udp->sin6_addr, sizeof(source.sin6_addr)) != 0) {
+        return -1;
     }
 
-    uint16_t codereq = ntohs(*(uint16_t *)message) >> 3;
+    uint16_t codereq;
+    memcpy(&codereq, buffer, sizeof(uint16_t));
+    codereq = ntohs(codereq) >> 3;
 
     switch (codereq) {
         case 11:
-            RETURN_NULL_IF_NULL(message);
-            uint8_t height = message[4];
-            uint8_t width = message[5];
-
-            if (6 + height * width > message_gameboard_max_size) {
-                message_gameboard_max_size = 7 + height * width;
-                free(message);
-                return NULL;
-            }
-            recieved->type = GAME_BOARD_INFORMATION;
+        case 17: // Packed game board
+            *type = GAME_BOARD_INFORMATION;
+            break;
+        case 20:
+            *type = GAME_BOARD_BAND;
             break;
         case 12:
-            recieved->type = GAME_BOARD_UPDATE;
+        case 18: // Fragment of an update
+        case 23: // Update of a region of a large board
+            *type = GAME_BOARD_UPDATE;
+            break;
+        case 22:
+            *type = GAME_REGION;
             break;
         default:
-            free(message);
-            free(recieved);
-            return NULL;
+            return -1;
     }
 
-    recieved->message = message;
-
-    return recieved;
+    return res;
 }
 
 int send_game_action(game_action *action) {
-    char *serialized = serialize_game_action(action);
+    action->token = token;
+    char serialized[GAME_ACTION_SIZE];
+    RETURN_FAILURE_IF_NEG(serialize_game_action_into(action, serialized, sizeof(serialized)));
 
-    int res = sendto(sock_udp, serialized, 4, 0, (struct sockaddr *)addr_udp, sizeof(struct sockaddr_in6));
+    int res =
+        sendto(sock_udp, serialized, GAME_ACTION_SIZE, 0, (struct sockaddr *)addr_udp, sizeof(struct sockaddr_in6));
     if (res < 0) {
         perror("sendto action");
-        free(serialized);
         return EXIT_FAILURE;
     }
 
     return EXIT_SUCCESS;
 }
 
+int send_keyframe_request(uint16_t num) {
+    keyframe_request request = {.id = id, .eq = eq, .num = num, .token = token};
+    char serialized[KEYFRAME_REQUEST_SIZE];
+    RETURN_FAILURE_IF_NEG(serialize_keyframe_request_into(&request, serialized, sizeof(serialized)));
+
+    int res = sendto(sock_udp, serialized, KEYFRAME_REQUEST_SIZE, 0, (struct sockaddr *)addr_udp,
+                     sizeof(struct sockaddr_in6));
+    if (res < 0) {
+        perror("sendto keyframe request");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int send_region_keyframe_request(uint16_t region) {
+    char serialized[KEYFRAME_REQUEST_SIZE];
+    int size = serialize_region_keyframe_request_into(id, eq, token, region, serialized, sizeof(serialized));
+    RETURN_FAILURE_IF_NEG(size);
+
+    int res = sendto(sock_udp, serialized, KEYFRAME_REQUEST_SIZE, 0, (struct sockaddr *)addr_udp,
+                     sizeof(struct sockaddr_in6));
+    if (res < 0) {
+        perror("sendto region keyframe request");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int set_region_subscription(int region, bool subscribed) {
+    if (transport == UNICAST_TRANSPORT) {
+        return EXIT_SUCCESS; // The server sends the regions around the player to the client itself
+    }
+
+    uint16_t region_group[8];
+    get_region_group(adrmdiff, region, region_group);
+
+    struct ipv6_mreq group;
+    for (int i = 0; i < 8; i++) {
+        group.ipv6mr_multiaddr.s6_addr[2 * i] = region_group[i] >> 8;
+        group.ipv6mr_multiaddr.s6_addr[2 * i + 1] = region_group[i] & 0xFF;
+    }
+    group.ipv6mr_interface = if_nametoindex("eth0");
+
+    int option = subscribed ? IPV6_JOIN_GROUP : IPV6_LEAVE_GROUP;
+    if (setsockopt(sock_diff, IPPROTO_IPV6, option, &group, sizeof(group)) < 0) {
+        perror("setsockopt region group");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
 int send_chat_message_to_server(chat_message_type type, uint8_t message_length, char *message) {
     return send_chat_message(sock_tcp, type, id, eq, message_length, message);
 }
 
-chat_message *recv_chat_message_from_server(u_int16_t header) {
-    return recv_chat_message(sock_tcp, header);
+int recv_chat_message_from_server(u_int16_t header, char *buffer, size_t capacity, chat_message_view *msg) {
+    return recv_chat_message(sock_tcp, header, buffer, capacity, msg);
 }
 
 u_int16_t recv_header_from_server() {
     return recv_header(sock_tcp);
 }
-
-bool has_server_disconnected_tcp() {
-    char buffer[1];
-    int res = recv(sock_tcp, buffer, 1, MSG_PEEK | MSG_DONTWAIT);
-    if (res == 0) {
-        return true;
-    }
-    return false;
-}
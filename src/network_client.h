@@ -20,23 +20,47 @@ int send_ready_to_play(GAME_MODE mode);
 
 typedef enum game_message_type {
     GAME_BOARD_INFORMATION,
+    GAME_BOARD_BAND, // Band of rows of a large board
     GAME_BOARD_UPDATE,
+    GAME_REGION, // Whole region of a large board
 } game_message_type;
 
-typedef struct received_game_message {
-    char *message;
-    game_message_type type;
-} received_game_message;
+/** Size of the largest game message, a whole board of the largest dimension */
+#define MAX_GAME_MESSAGE_SIZE GAME_BOARD_SIZE(UINT8_MAX, UINT8_MAX)
 
 void free_internal_info();
 
-received_game_message *recv_game_message();
+#define GAME_MESSAGE_TIMEOUT 100 // in ms, longest wait for the game messages before looking for the missing ones
+
+/** Sockets waited for by the client loop: the game messages come on the first one, whichever the transport, and the
+ * chat messages and the end of the game on the other one
+ */
+int get_game_message_socket();
+int get_server_socket();
+
+/** Receives the next game message already there in buffer, which should have room for MAX_GAME_MESSAGE_SIZE bytes
+ * Returns the size of the message, 0 if none is there and -1 if it is not a game message
+ */
+int recv_game_message(char *buffer, size_t capacity, game_message_type *type);
+
+/** Sends the action with the session token of the game, which is set in action
+ */
 int send_game_action(game_action *action);
 
+/** Asks the server for a whole board, num is the number of the first update missing */
+int send_keyframe_request(uint16_t num);
+
+/** Asks the server for a whole region of a large board */
+int send_region_keyframe_request(uint16_t region);
+
+/** Joins or leaves the multicast group of a region of a large board, its messages are then received with the others
+ * Nothing is joined in unicast, where the server chooses the regions from the position of the player
+ */
+int set_region_subscription(int region, bool subscribed);
+
 int send_chat_message_to_server(chat_message_type type, uint8_t message_length, char *message);
-chat_message *recv_chat_message_from_server(u_int16_t header);
+int recv_chat_message_from_server(u_int16_t header, char *buffer, size_t capacity, chat_message_view *msg);
+/** Returns 0 if the server has left */
 u_int16_t recv_header_from_server();
 
-bool has_server_disconnected_tcp();
-
 #endif // SRC_NETWORK_CLIENT_H__H_
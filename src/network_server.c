@@ -1,23 +1,34 @@
+#define _GNU_SOURCE // accept4
+
 #include "network_server.h"
+#include "action_ring.h"
+#include "egress.h"
+#include "game_tick.h"
+#include "matchmaking.h"
 #include "messages.h"
 #include "model.h"
+#include "reactor.h"
+#include "tcp_output.h"
+#include "tick_scheduler.h"
 #include "utils.h"
 
 #include <arpa/inet.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <net/if.h>
 #include <netinet/in.h>
 #include <poll.h>
 #include <pthread.h>
 #include <signal.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/poll.h>
-#include <sys/select.h>
 #include <sys/socket.h>
+#include <time.h>
 #include <unistd.h>
 
 #define MAX_PORT_TRY 250
@@ -25,57 +36,134 @@
 
 #define ERROR_ADDRINUSE 2
 
-#define LIMIT_LAST_NUM_MESSAGE_MULT ((1 << 15) - 1)   // 2^16
-#define LIMIT_LAST_NUM_MESSAGE_CLIENT ((1 << 12) - 1) // 2^13
-
-#define FREQ 50000 // 100 00 us = 10 ms
-#define INITIAL_GAME_ACTIONS_SIZE 4
-#define INITIAL_POLL_FD_SIZE 9
-
-typedef struct tcp_thread_data {
-    unsigned id;
-    int game_id;
+#define TICK_PERIOD 50           // in ms, period of the updates of the games
+#define KEYFRAME_MIN_PERIOD 1000 // in ms, period of the whole game boards while clients miss updates
+#define KEYFRAME_MAX_PERIOD 8000 // in ms, period of the whole game boards while no client misses updates
+#define KEYFRAME_MIN_TICKS (KEYFRAME_MIN_PERIOD / TICK_PERIOD)
+#define KEYFRAME_MAX_TICKS (KEYFRAME_MAX_PERIOD / TICK_PERIOD)
+#define KEYFRAME_REQUEST_GAP_TICKS 4 // Minimal number of ticks between two whole game boards sent on request
+
+#define NB_REACTORS 2
+#define REACTOR_TIMER_PERIOD 1000 // in ms, period of the checks of the connection deadlines
+#define READY_TIMEOUT 60          // in seconds
+#define HANDSHAKE_TIMEOUT 10      // in seconds, to send the initial header and then to be given a lobby
+#define LOBBY_TIMEOUT 120         // in seconds, how long a new lobby waits for its players
+#define LOBBY_BACKFILL_TIMEOUT 30 // in seconds, how long a lobby waits for the replacement of a player who left
+#define MIN_LOBBY_PLAYERS 2       // A lobby which times out with fewer players is closed instead of started
+#define SPARE_LOBBIES 2           // Lobbies with free places kept ready for each game mode
+#define SPARE_ENDPOINTS 4         // Game endpoints kept bound by the provisioning thread
+#define MAX_POOLED_ENDPOINTS 16   // Game endpoints kept from the finished games, the other ones are closed
+#define CONNECTION_BUFFER_SIZE 512
+#define MAX_SESSIONS (1 << 16) // Games reachable through the shared ingress, the low half of a token is its game id
+#define MAX_QUEUED_BOARDS 2    // Whole boards queued for a client during a tick in unicast, the rest is dropped
+
+/** Steps of the TCP connection of a player, from the initial header to the end of the game */
+typedef enum connection_state {
+    WAITING_INITIAL_HEADER,
+    WAITING_OTHER_PLAYERS,
+    WAITING_READY,
+    READY,
+    PLAYING,
+} connection_state;
+
+typedef struct lobby lobby;
+typedef struct reactor_context reactor_context;
+
+typedef struct client_connection {
+    int sock;
+    int id;
     int eq;
-    unsigned *ready_player_number;
-    unsigned *connected_players;
-
-    int last_num_message;
-
-    bool *finished_flag;
-    unsigned *nb_players_left;
-
-    pthread_mutex_t *lock_waiting_all_players_join;
-    pthread_mutex_t *lock_all_players_ready;
-    pthread_mutex_t *lock_waiting_the_game_finish;
-    pthread_mutex_t *lock_all_tcp_threads_closed;
-    pthread_mutex_t *lock_finished_flag;
-    pthread_mutex_t *lock_nb_players_left;
-
-    pthread_cond_t *cond_lock_waiting_all_players_join;
-    pthread_cond_t *cond_lock_all_players_ready;
-    pthread_cond_t *cond_lock_waiting_the_game_finish;
-    pthread_cond_t *cond_lock_all_tcp_threads_closed;
-
+    connection_state state; // Protected by the lock of the lobby once the connection has one
+    time_t deadline;
+    bool has_joined; // The initial header is received, only used by the reactor
+    GAME_MODE mode;
+    lobby *lobby; // Protected by the matchmaking of the mode, NULL while the connection waits for a lobby
+    struct client_connection *next_waiting;
+
+    char buffer[CONNECTION_BUFFER_SIZE]; // Bytes received but not handled yet
+    size_t buffered;
+
+    // Protected by the lock of the lobby, nothing is sent before the connection has one
+    tcp_output output;
+    bool shutdown_when_sent; // The game is over, the connection is shut down once its output is sent
+
+    reactor_context *context;
+    reactor_handler *handler;
+    struct client_connection *prev;
+    struct client_connection *next;
+    struct client_connection *next_expired;
+} client_connection;
+
+/** Players of a game and state shared by their connections, protected by lock */
+struct lobby {
+    match_entry entry; // First member, so that the matchmaking gives back the lobby, protected by its matchmaking
+    int game_id;
+    GAME_MODE mode;
     server_information *server;
-} tcp_thread_data;
 
+    client_connection *players[PLAYER_NUM];
+    settled_places settled;
+    unsigned connected_players;
+
+    bool matched;          // The lobby takes no more players
+    bool closed;           // The lobby timed out without enough players, it never starts
+    time_t match_deadline; // The lobby stops waiting for players at match_deadline
+    bool started;
+    bool finished;
+    uint32_t token; // Session token carried by the datagrams of the players
+
+    unsigned references; // Connections and game threads using the lobby
+    pthread_mutex_t lock;
+};
+
+/** Reactor thread with the connections it owns */
+struct reactor_context {
+    reactor *reactor;
+    client_connection *connections;
+    pthread_mutex_t lock_connections;
+};
+
+/** State of a running game, shared by its tick task and its reception thread */
 typedef struct udp_thread_data {
     unsigned game_id;
-    game_action **game_actions;
-    unsigned nb_game_actions;
-    unsigned size_game_actions;
-
-    bool *finished_flag;
-    unsigned *nb_stopped_udp_threads;
-
-    pthread_mutex_t lock_game_actions;
-    pthread_mutex_t lock_send_udp;
-    pthread_mutex_t *lock_finished_flag;
-    pthread_mutex_t *lock_all_tcp_threads_closed;
-    pthread_mutex_t *lock_nb_stopped_udp_threads;
-    pthread_mutex_t *lock_all_udp_threads_closed;
-    pthread_cond_t *cond_lock_all_tcp_threads_closed;
-    pthread_cond_t *cond_lock_all_udp_threads_closed;
+    GAME_MODE mode;
+    uint32_t token;
+    lobby *lobby;
+    action_ring game_actions;             // Received since the last tick, from the reception thread to the tick task
+    pthread_mutex_t lock_ingress;         // Taken by the shared ingress threads, the producers of game_actions
+    atomic_uint keyframe_requests;        // Received since the last whole game board, from the reception thread
+    atomic_uint region_keyframe_requests; // Same for the regions of the large boards
+
+    bool finished_flag;
+    unsigned references; // Tick task and reception thread, the last one frees the game
+
+    // Only used by the tick task
+    int last_num_received_messages[PLAYER_NUM];
+    uint16_t next_update_num;          // Also carried by the whole game boards, see keyframe_request
+    long last_keyframe_tick;           // -1 before the first tick
+    unsigned keyframe_ticks;           // Current period of the whole game boards
+    tick_buffers tick;                 // Preallocated so that the ticks do not allocate
+    struct sockaddr_in6 *region_addrs; // Groups of the regions, NULL if the board is not sent by regions or in unicast
+
+    // In unicast, the game messages of a player go where its first datagram comes from, which has to be sent from
+    // the host of its TCP connection, set by the reception and then pinned for the rest of the game
+    struct in6_addr client_hosts[PLAYER_NUM]; // Of the TCP connections, set at the start of the game
+    bool has_client_host[PLAYER_NUM];         // False for the places without a player
+    struct sockaddr_in6 client_addrs[PLAYER_NUM];
+    int client_socks[PLAYER_NUM]; // Socket which received the first datagram of the player, -1 before any datagram
+    pthread_mutex_t lock_client_addrs;
+    // Copied from them at the start of each tick, only used by the tick task
+    egress_receiver receivers[PLAYER_NUM];
+    egress_receiver *game_receivers[PLAYER_NUM]; // The players whose address is known
+    unsigned nb_game_receivers;
+    int receiver_regions[PLAYER_NUM][MAX_SUBSCRIBED_REGIONS]; // Around each player, for the boards sent by regions
+    unsigned nb_receiver_regions[PLAYER_NUM];
+    egress_receiver *region_receivers[PLAYER_NUM]; // Scratch of get_region_destination
+    size_t max_queued;                             // Bound of each player, in bytes
+
+    pthread_mutex_t lock_finished_flag; // Also protects references
+
+    recv_batch *batch; // Only used by the reception thread, NULL with the shared ingress
 
     server_information *server;
 } udp_thread_data;
@@ -83,28 +171,78 @@ typedef struct udp_thread_data {
 static int sock_tcp = -1;
 static uint16_t port_tcp = -1;
 
-static pthread_t game_threads[3];
+/** With the shared ingress, nb_ingress_sockets UDP sockets bound on the same port (SO_REUSEPORT) receive the
+ * datagrams of all the games, each one is routed by its session token to the game registered in sessions
+ * Otherwise each game receives on its own socket with its own reception thread
+ */
+static unsigned nb_ingress_sockets = 0;
+static unsigned nb_ingress_threads = 0;
+static int ingress_socks[MAX_INGRESS_SOCKETS];
+static pthread_t ingress_threads[MAX_INGRESS_SOCKETS];
+static uint16_t ingress_port; // In network byte order, as the ports of the games
+static atomic_bool ingress_stopped;
+static udp_thread_data *sessions[MAX_SESSIONS]; // Indexed by the low half of the tokens
+static pthread_rwlock_t lock_sessions = PTHREAD_RWLOCK_INITIALIZER;
+
+/** Lobbies of a game mode waiting for players, the lock is taken before the ones of the lobbies
+ * The players who come while no lobby has a free place wait for the provisioning thread to create one
+ */
+typedef struct matchmaking {
+    match_queue queue;
+    client_connection *first_waiting;
+    client_connection *last_waiting;
+    pthread_mutex_t lock;
+} matchmaking;
+
+static matchmaking solo_matchmaking = {.lock = PTHREAD_MUTEX_INITIALIZER};
+static matchmaking team_matchmaking = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+/** The lobbies are created by their own thread, so that binding their sockets never delays the connections */
+static pthread_t provisioning_thread;
+static pthread_mutex_t lock_provisioning = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t provisioning_needed = PTHREAD_COND_INITIALIZER;
+static bool provisioning_requested = false;
+static bool provisioning_stopped = false;
 
-static server_information *solo_waiting_server;
-static int connected_solo_players = 0;
-static tcp_thread_data *solo_tcp_threads_data_players[PLAYER_NUM];
+/** Game endpoints bound and ready, taken by the new lobbies and given back by the finished games */
+static server_information *endpoint_pool[MAX_POOLED_ENDPOINTS];
+static unsigned nb_pooled_endpoints = 0;
+static pthread_mutex_t lock_endpoint_pool = PTHREAD_MUTEX_INITIALIZER;
 
-static server_information *team_waiting_server;
-static int connected_team_players = 0;
-static tcp_thread_data *team_tcp_threads_data_players[PLAYER_NUM];
+static reactor_context reactor_contexts[NB_REACTORS];
 
-static int connection_port;
+static tick_scheduler *game_scheduler; // Drives the ticks of all the games
+
+// The datagrams of all the games are sent together at the end of each tick, only used by the scheduler thread
+static int sock_egress = -1;
+static egress_queue *game_egress;
+
+static dimension game_dimension = {GAMEBOARD_WIDTH, GAMEBOARD_HEIGHT}; // Of the new games, border included
+static game_transport transport = MULTICAST_TRANSPORT;
+
+void set_game_dimension(dimension dim) {
+    game_dimension = dim;
+}
 
-static pthread_mutex_t *lock_game_model;
+void set_shared_ingress(unsigned nb_sockets) {
+    nb_ingress_sockets = nb_sockets;
+}
 
-void init_state(uint16_t connection_port_) {
-    solo_waiting_server = NULL;
-    team_waiting_server = NULL;
+void set_game_transport(game_transport game_transport) {
+    transport = game_transport;
+}
 
-    connected_solo_players = 0;
-    connected_team_players = 0;
+void init_state() {
+    init_match_queue(&solo_matchmaking.queue);
+    init_match_queue(&team_matchmaking.queue);
+    solo_matchmaking.first_waiting = NULL;
+    solo_matchmaking.last_waiting = NULL;
+    team_matchmaking.first_waiting = NULL;
+    team_matchmaking.last_waiting = NULL;
+}
 
-    connection_port = connection_port_;
+matchmaking *get_matchmaking(GAME_MODE mode) {
+    return mode == SOLO ? &solo_matchmaking : &team_matchmaking;
 }
 
 server_information *create_server_information() {
@@ -115,7 +253,6 @@ server_information *create_server_information() {
     }
 
     server->sock_udp = -1;
-    server->sock_mult = -1;
     for (int i = 0; i < PLAYER_NUM; i++) {
         server->sock_clients[i] = -1;
     }
@@ -141,20 +278,7 @@ void close_socket_tcp() {
 void close_socket_udp(server_information *server) {
     shutdown(server->sock_udp, SHUT_RD);
     close_socket(server->sock_udp);
-}
-
-void close_socket_mult(server_information *server) {
-    shutdown(server->sock_mult, SHUT_RD);
-    close_socket(server->sock_mult);
-}
-
-void close_socket_client(server_information *server, int id) {
-    if (id >= 0 && id < PLAYER_NUM) {
-        if (server->sock_clients[id] != -1) {
-            close(server->sock_clients[id]);
-            server->sock_clients[id] = -1; // Mark socket as closed
-        }
-    }
+    server->sock_udp = -1;
 }
 
 int init_socket(int *sock, bool is_tcp) {
@@ -176,7 +300,8 @@ int init_socket(int *sock, bool is_tcp) {
         return EXIT_FAILURE;
     }
     option = 1;
-    if (setsockopt(*sock, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option)) < 0) {
+    // Only for TCP: UDP sockets sharing a port would steal the actions of each other's game
+    if (is_tcp && setsockopt(*sock, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option)) < 0) {
         perror("setsockopt reuseaddr");
         close(*sock);
         *sock = -1;
@@ -230,25 +355,10 @@ int try_to_bind_random_port_on_socket_tcp() {
     return EXIT_SUCCESS;
 }
 
-int init_socket_tcp() {
-    RETURN_FAILURE_IF_ERROR(init_socket(&sock_tcp, true));
-
-    if (try_to_bind_random_port_on_socket_tcp() != EXIT_SUCCESS) {
-        close_socket_tcp();
-        return EXIT_FAILURE;
-    }
-
-    return EXIT_SUCCESS;
-}
-
 int init_socket_udp(server_information *server) {
     return init_socket(&server->sock_udp, false);
 }
 
-int init_socket_mult(server_information *server) {
-    return init_socket(&server->sock_mult, false);
-}
-
 void print_ip_of_client(struct sockaddr_in6 client_addr) {
     char client_ip[INET6_ADDRSTRLEN];
     inet_ntop(AF_INET6, &(client_addr.sin6_addr), client_ip, INET6_ADDRSTRLEN);
@@ -273,6 +383,34 @@ int try_to_bind_port_on_socket_tcp(uint16_t connexion_port) {
     return EXIT_SUCCESS;
 }
 
+int init_socket_tcp(uint16_t connexion_port, bool shared) {
+    RETURN_FAILURE_IF_ERROR(init_socket(&sock_tcp, true));
+
+    int option = 1;
+    if (shared && setsockopt(sock_tcp, SOL_SOCKET, SO_REUSEPORT, &option, sizeof(option)) < 0) {
+        perror("setsockopt reuseport");
+        close_socket_tcp();
+        return EXIT_FAILURE;
+    }
+
+    int res;
+    if (connexion_port >= MIN_PORT && connexion_port <= MAX_PORT) {
+        res = try_to_bind_port_on_socket_tcp(connexion_port);
+        if (res != EXIT_SUCCESS) {
+            fprintf(stderr, "The connexion port not works, try another one.\n");
+        }
+    } else {
+        res = try_to_bind_random_port_on_socket_tcp();
+    }
+
+    if (res != EXIT_SUCCESS) {
+        close_socket_tcp();
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
 int try_to_bind_random_port_on_socket_udp(server_information *server) {
     int res = try_to_bind_random_port_on_socket(server->sock_udp);
     RETURN_FAILURE_IF_ERROR(res);
@@ -303,6 +441,19 @@ void free_addr_mult(server_information *server) {
     }
 }
 
+/** Sets the multicast address of addr_mult from adrmdiff */
+int set_addr_mult_group(server_information *server) {
+    char *addr_string = convert_adrmdif_into_string(server->adrmdiff);
+    int res = inet_pton(AF_INET6, addr_string, &server->addr_mult->sin6_addr);
+    free(addr_string);
+
+    if (res < 0) {
+        perror("inet_pton addr_mult");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
 int init_addr_mult(server_information *server) {
     server->addr_mult = malloc(sizeof(struct sockaddr_in6));
     RETURN_FAILURE_IF_NULL_PERROR(server->addr_mult, "malloc addr_mult");
@@ -311,13 +462,8 @@ int init_addr_mult(server_information *server) {
     server->addr_mult->sin6_family = AF_INET6;
     server->addr_mult->sin6_port = server->port_mult;
 
-    char *addr_string = convert_adrmdif_into_string(server->adrmdiff);
-    int res = inet_pton(AF_INET6, addr_string, &server->addr_mult->sin6_addr);
-    free(addr_string);
-
-    if (res < 0) {
+    if (set_addr_mult_group(server) != EXIT_SUCCESS) {
         free_addr_mult(server);
-        perror("inet_pton addr_mult");
         return EXIT_FAILURE;
     }
 
@@ -332,20 +478,15 @@ int init_addr_mult(server_information *server) {
     return EXIT_SUCCESS;
 }
 
-server_information *init_server_network(uint16_t connexion_port) {
+server_information *init_server_network() {
     server_information *server = create_server_information();
     RETURN_NULL_IF_NULL(server);
-    RETURN_NULL_IF_ERROR(init_socket_udp(server));
-    RETURN_NULL_IF_ERROR(init_socket_mult(server));
-
-    if (connexion_port >= MIN_PORT && connexion_port <= MAX_PORT) {
-        if (try_to_bind_port_on_socket_tcp(connexion_port) != EXIT_SUCCESS) {
-            fprintf(stderr, "The connexion port not works, try another one.\n");
-            goto exit_closing_sockets;
-        }
+    bool has_own_socket = nb_ingress_sockets == 0; // Otherwise its actions come on the shared ingress
+    if (has_own_socket) {
+        RETURN_NULL_IF_ERROR(init_socket_udp(server));
     }
 
-    if (try_to_bind_random_port_on_socket_udp(server) != EXIT_SUCCESS) {
+    if (has_own_socket && try_to_bind_random_port_on_socket_udp(server) != EXIT_SUCCESS) {
         goto exit_closing_sockets;
     }
     if (init_random_port_on_socket_mult(server) != EXIT_SUCCESS) {
@@ -360,226 +501,227 @@ server_information *init_server_network(uint16_t connexion_port) {
     return server;
 
 exit_closing_sockets:
-    close_socket_tcp();
     close_socket_udp(server);
-    close_socket_mult(server);
     free(server);
     return NULL;
 }
 
-int listen_players() {
-    if (listen(sock_tcp, 0) < 0) {
-        perror("listen sock_tcp");
-        return EXIT_FAILURE;
-    }
-    return EXIT_SUCCESS;
+void free_server_network(server_information *server) {
+    close_socket_udp(server);
+    free_addr_mult(server);
+    free(server);
 }
 
-void free_tcp_threads_data(tcp_thread_data **data_thread, unsigned nb_data) {
-    for (unsigned i = 0; i < nb_data; i++) {
-        if (data_thread[i] != NULL) {
-            free(data_thread[i]);
-            data_thread[i] = NULL;
-        }
+/** Gives an endpoint of the pool, or binds a new one if the pool is empty */
+server_information *take_endpoint() {
+    server_information *server = NULL;
+    pthread_mutex_lock(&lock_endpoint_pool);
+    if (nb_pooled_endpoints > 0) {
+        nb_pooled_endpoints--;
+        server = endpoint_pool[nb_pooled_endpoints];
     }
-}
-
-int init_tcp_threads_data(server_information *server, GAME_MODE mode, int game_id) {
-    unsigned *ready_player_number = malloc(sizeof(unsigned));
-    *ready_player_number = 0;
-    unsigned *connected_players = malloc(sizeof(unsigned));
-    *connected_players = 0;
-    bool *finished_flag = malloc(sizeof(bool));
-    *finished_flag = false;
-    unsigned *nb_players_left = malloc(sizeof(unsigned));
-    *nb_players_left = 0;
-    pthread_mutex_t *lock_waiting_all_players_join = malloc(sizeof(pthread_mutex_t));
-    pthread_mutex_t *lock_all_players_ready = malloc(sizeof(pthread_mutex_t));
-    pthread_mutex_t *lock_waiting_the_game_finish = malloc(sizeof(pthread_mutex_t));
-    pthread_mutex_t *lock_finished_flag = malloc(sizeof(pthread_mutex_t));
-    pthread_mutex_t *lock_nb_players_left = malloc(sizeof(pthread_mutex_t));
-    pthread_mutex_t *lock_all_tcp_threads_closed = malloc(sizeof(pthread_mutex_t));
+    pthread_mutex_unlock(&lock_endpoint_pool);
 
-    pthread_cond_t *cond_lock_waiting_all_players_join = malloc(sizeof(pthread_cond_t));
-    pthread_cond_t *cond_lock_all_players_ready = malloc(sizeof(pthread_cond_t));
-    pthread_cond_t *cond_lock_waiting_the_game_finish = malloc(sizeof(pthread_cond_t));
-    pthread_cond_t *cond_lock_all_tcp_threads_closed = malloc(sizeof(pthread_cond_t));
+    return server != NULL ? server : init_server_network();
+}
 
-    if (pthread_mutex_init(lock_waiting_the_game_finish, NULL) < 0) {
-        return EXIT_FAILURE;
-    }
-    if (pthread_mutex_init(lock_all_players_ready, NULL) < 0) {
-        return EXIT_FAILURE;
-    }
-    if (pthread_mutex_init(lock_waiting_all_players_join, NULL) < 0) {
-        return EXIT_FAILURE;
-    }
-    if (pthread_mutex_init(lock_finished_flag, NULL) < 0) {
-        return EXIT_FAILURE;
-    }
-    if (pthread_mutex_init(lock_nb_players_left, NULL) < 0) {
-        return EXIT_FAILURE;
-    }
-    if (pthread_mutex_init(lock_all_tcp_threads_closed, NULL) < 0) {
-        return EXIT_FAILURE;
-    }
-    if (pthread_cond_init(cond_lock_waiting_the_game_finish, NULL) < 0) {
-        return EXIT_FAILURE;
-    }
-    if (pthread_cond_init(cond_lock_all_players_ready, NULL) < 0) {
-        return EXIT_FAILURE;
+/** Puts the endpoint back in the pool, or frees it if the pool is full
+ * Returns true if the endpoint is kept
+ */
+bool give_back_endpoint(server_information *server, unsigned max_pooled) {
+    pthread_mutex_lock(&lock_endpoint_pool);
+    bool is_kept = nb_pooled_endpoints < max_pooled;
+    if (is_kept) {
+        endpoint_pool[nb_pooled_endpoints] = server;
+        nb_pooled_endpoints++;
     }
-    if (pthread_cond_init(cond_lock_waiting_all_players_join, NULL) < 0) {
-        return EXIT_FAILURE;
+    pthread_mutex_unlock(&lock_endpoint_pool);
+
+    if (!is_kept) {
+        free_server_network(server);
     }
-    if (pthread_cond_init(cond_lock_all_tcp_threads_closed, NULL) < 0) {
-        return EXIT_FAILURE;
+    return is_kept;
+}
+
+/** Prepares the endpoint of a finished game for another game and gives it back to the pool
+ * The datagrams left by the finished game are dropped, and the next game gets another multicast address so that
+ * the players of the finished game never receive its messages
+ */
+void recycle_endpoint(server_information *server) {
+    char datagram[GAME_ACTION_SIZE];
+    while (server->sock_udp != -1 && recv(server->sock_udp, datagram, sizeof(datagram), MSG_DONTWAIT) >= 0) {
     }
 
-    for (unsigned i = 0; i < PLAYER_NUM; i++) {
-        // TODO: refactor
-        switch (mode) {
-            case SOLO:
-                solo_tcp_threads_data_players[i] = malloc(sizeof(tcp_thread_data));
-                if (solo_tcp_threads_data_players[i] == NULL) {
-                    perror("malloc tcp_thread_data");
-                    for (unsigned j = 0; j < i; j++) {
-                        free(solo_tcp_threads_data_players[j]);
-                    }
-                    return EXIT_FAILURE;
-                }
-                memset(solo_tcp_threads_data_players[i], 0, sizeof(tcp_thread_data));
-
-                solo_tcp_threads_data_players[i]->ready_player_number = ready_player_number;
-                solo_tcp_threads_data_players[i]->connected_players = connected_players;
-                solo_tcp_threads_data_players[i]->finished_flag = finished_flag;
-                solo_tcp_threads_data_players[i]->nb_players_left = nb_players_left;
-
-                solo_tcp_threads_data_players[i]->lock_waiting_all_players_join = lock_waiting_all_players_join;
-                solo_tcp_threads_data_players[i]->lock_all_players_ready = lock_all_players_ready;
-                solo_tcp_threads_data_players[i]->lock_waiting_the_game_finish = lock_waiting_the_game_finish;
-                solo_tcp_threads_data_players[i]->lock_finished_flag = lock_finished_flag;
-                solo_tcp_threads_data_players[i]->lock_nb_players_left = lock_nb_players_left;
-                solo_tcp_threads_data_players[i]->lock_all_tcp_threads_closed = lock_all_tcp_threads_closed;
-                solo_tcp_threads_data_players[i]->cond_lock_waiting_all_players_join =
-                    cond_lock_waiting_all_players_join;
-                solo_tcp_threads_data_players[i]->cond_lock_all_players_ready = cond_lock_all_players_ready;
-                solo_tcp_threads_data_players[i]->cond_lock_waiting_the_game_finish = cond_lock_waiting_the_game_finish;
-                solo_tcp_threads_data_players[i]->cond_lock_all_tcp_threads_closed = cond_lock_all_tcp_threads_closed;
-
-                solo_tcp_threads_data_players[i]->game_id = game_id;
-                solo_tcp_threads_data_players[i]->eq = 0;
-                solo_tcp_threads_data_players[i]->server = server;
-                break;
+    for (int i = 0; i < PLAYER_NUM; i++) {
+        server->sock_clients[i] = -1; // Closed by the reactors of the connections
+    }
 
-            case TEAM:
-                team_tcp_threads_data_players[i] = malloc(sizeof(tcp_thread_data));
+    if (init_random_adrmdiff(server) != EXIT_SUCCESS || set_addr_mult_group(server) != EXIT_SUCCESS) {
+        free_server_network(server);
+        return;
+    }
+    give_back_endpoint(server, MAX_POOLED_ENDPOINTS);
+}
 
-                if (team_tcp_threads_data_players[i] == NULL) {
-                    perror("malloc tcp_thread_data");
-                    for (unsigned j = 0; j < i; j++) {
-                        free(team_tcp_threads_data_players[j]);
-                    }
-                    return EXIT_FAILURE;
-                }
+/** Binds endpoints until the pool has SPARE_ENDPOINTS
+ * Returns EXIT_FAILURE if an endpoint could not be bound
+ */
+int provision_endpoints() {
+    while (true) {
+        pthread_mutex_lock(&lock_endpoint_pool);
+        bool is_short = nb_pooled_endpoints < SPARE_ENDPOINTS;
+        pthread_mutex_unlock(&lock_endpoint_pool);
+        if (!is_short) {
+            return EXIT_SUCCESS;
+        }
 
-                memset(team_tcp_threads_data_players[i], 0, sizeof(tcp_thread_data));
-
-                team_tcp_threads_data_players[i]->ready_player_number = ready_player_number;
-                team_tcp_threads_data_players[i]->connected_players = connected_players;
-                team_tcp_threads_data_players[i]->finished_flag = finished_flag;
-                team_tcp_threads_data_players[i]->nb_players_left = nb_players_left;
-
-                team_tcp_threads_data_players[i]->lock_waiting_all_players_join = lock_waiting_all_players_join;
-                team_tcp_threads_data_players[i]->lock_all_players_ready = lock_all_players_ready;
-                team_tcp_threads_data_players[i]->lock_waiting_the_game_finish = lock_waiting_the_game_finish;
-                team_tcp_threads_data_players[i]->lock_finished_flag = lock_finished_flag;
-                team_tcp_threads_data_players[i]->lock_nb_players_left = lock_nb_players_left;
-                team_tcp_threads_data_players[i]->lock_all_tcp_threads_closed = lock_all_tcp_threads_closed;
-                team_tcp_threads_data_players[i]->cond_lock_waiting_all_players_join =
-                    cond_lock_waiting_all_players_join;
-                team_tcp_threads_data_players[i]->cond_lock_all_players_ready = cond_lock_all_players_ready;
-                team_tcp_threads_data_players[i]->cond_lock_waiting_the_game_finish = cond_lock_waiting_the_game_finish;
-                team_tcp_threads_data_players[i]->cond_lock_all_tcp_threads_closed = cond_lock_all_tcp_threads_closed;
-
-                team_tcp_threads_data_players[i]->game_id = game_id;
-                team_tcp_threads_data_players[i]->server = server;
-                break;
-            default:
-                return EXIT_FAILURE;
+        server_information *server = init_server_network();
+        RETURN_FAILURE_IF_NULL(server);
+        if (!give_back_endpoint(server, SPARE_ENDPOINTS)) {
+            return EXIT_SUCCESS; // Filled by a finished game meanwhile
         }
     }
-
-    return EXIT_SUCCESS;
 }
 
-void lock_mutex_to_wait(pthread_mutex_t *mutex, pthread_cond_t *cond) {
-    pthread_mutex_lock(mutex);
-    pthread_cond_wait(cond, mutex);
-    pthread_mutex_unlock(mutex);
+void free_endpoint_pool() {
+    pthread_mutex_lock(&lock_endpoint_pool);
+    for (unsigned i = 0; i < nb_pooled_endpoints; i++) {
+        free_server_network(endpoint_pool[i]);
+    }
+    nb_pooled_endpoints = 0;
+    pthread_mutex_unlock(&lock_endpoint_pool);
 }
 
-void unlock_mutex_for_everyone(pthread_mutex_t *mutex, pthread_cond_t *cond) {
-    pthread_mutex_lock(mutex);
-    pthread_cond_broadcast(cond);
-    pthread_mutex_unlock(mutex);
+/** Wakes up the reception thread of the game, blocked in recvmmsg, with an empty datagram on its own socket
+ * The socket is not shut down, so that the endpoint can be recycled
+ */
+void wake_up_game_reception(server_information *server) {
+    struct sockaddr_in6 self;
+    memset(&self, 0, sizeof(self));
+    self.sin6_family = AF_INET6;
+    self.sin6_addr = in6addr_loopback;
+    self.sin6_port = server->port_udp;
+    if (sendto(server->sock_udp, NULL, 0, 0, (struct sockaddr *)&self, sizeof(self)) < 0) {
+        perror("sendto wake up reception");
+    }
 }
 
-initial_connection_header *recv_initial_connection_header_of_client(int sock) {
-    return recv_initial_connection_header(sock);
+/** Listens on the TCP socket, which is non-blocking so that the accept loop never waits on a single client
+ */
+int listen_players() {
+    if (fcntl(sock_tcp, F_SETFL, fcntl(sock_tcp, F_GETFL) | O_NONBLOCK) < 0) {
+        perror("fcntl sock_tcp");
+        return EXIT_FAILURE;
+    }
+    if (listen(sock_tcp, SOMAXCONN) < 0) {
+        perror("listen sock_tcp");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
 }
 
-ready_connection_header *recv_ready_connexion_header_of_client(int sock) {
-    return recv_ready_connexion_header(sock);
+/** The lobby has to be locked */
+int send_connexion_information_of_client(lobby *l, client_connection *conn) {
+    server_information *server = l->server;
+    uint16_t port_udp = nb_ingress_sockets > 0 ? ingress_port : server->port_udp;
+    return send_connexion_information(&conn->output, l->mode, conn->id, conn->eq, ntohs(port_udp),
+                                      ntohs(server->port_mult), server->adrmdiff, l->token, transport);
 }
 
-game_action *recv_game_action_of_clients(server_information *server) {
-    return recv_game_action(server->sock_udp);
+/** Disconnects a player who does not receive his messages, his reactor closes the connection on the hang up */
+void disconnect_player(client_connection *conn) {
+    shutdown(conn->sock, SHUT_RDWR);
 }
 
-chat_message *recv_chat_message_of_client(server_information *server, int id) {
-    if (server->sock_clients[id] == -1) {
-        return NULL;
+/** Receivers of the messages of the whole game, its group or in unicast the players whose address is known */
+game_destination get_game_destination(udp_thread_data *data) {
+    game_destination dest = {.group = NULL,
+                             .receivers = data->game_receivers,
+                             .nb_receivers = data->nb_game_receivers,
+                             .max_queued = data->max_queued};
+    if (transport == MULTICAST_TRANSPORT) {
+        dest.group = data->server->addr_mult;
     }
+    return dest;
+}
 
-    return recv_chat_message(server->sock_clients[id]);
+/** Receivers of the messages of a region, its group or in unicast the players around the region
+ * The destination is only valid until the next call
+ */
+game_destination get_region_destination(udp_thread_data *data, int region) {
+    game_destination dest = {.group = NULL,
+                             .receivers = data->region_receivers,
+                             .nb_receivers = 0,
+                             .max_queued = data->max_queued};
+    if (transport == MULTICAST_TRANSPORT) {
+        dest.group = &data->region_addrs[region];
+        return dest;
+    }
+
+    for (unsigned i = 0; i < data->nb_game_receivers; i++) {
+        unsigned player = data->game_receivers[i] - data->receivers;
+        for (unsigned j = 0; j < data->nb_receiver_regions[player]; j++) {
+            if (data->receiver_regions[player][j] == region) {
+                data->region_receivers[dest.nb_receivers] = data->game_receivers[i];
+                dest.nb_receivers++;
+                break;
+            }
+        }
+    }
+    return dest;
 }
 
-int send_connexion_information_of_client(server_information *server, int id, int eq) {
-    return send_connexion_information(server->sock_clients[id], SOLO, id, eq, ntohs(server->port_udp),
-                                      ntohs(server->port_mult), server->adrmdiff);
+int send_game_board_for_clients(udp_thread_data *data, uint16_t num, board *board_) {
+    game_destination dest = get_game_destination(data);
+    return send_game_board(game_egress, &dest, num, board_);
 }
 
-int send_game_board_for_clients(server_information *server, uint16_t num, board *board_) {
-    return send_game_board(server->sock_mult, server->addr_mult, num, board_);
+/** Returns the addresses of the groups of the regions, on the port and the interface of the game group
+ */
+struct sockaddr_in6 *create_region_addrs(server_information *server, const region_grid *grid) {
+    struct sockaddr_in6 *addrs = malloc(get_region_count(grid) * sizeof(struct sockaddr_in6));
+    RETURN_NULL_IF_NULL_PERROR(addrs, "malloc region_addrs");
+
+    for (int r = 0; r < get_region_count(grid); r++) {
+        uint16_t group[8];
+        get_region_group(server->adrmdiff, r, group);
+
+        addrs[r] = *server->addr_mult;
+        for (int i = 0; i < 8; i++) {
+            addrs[r].sin6_addr.s6_addr[2 * i] = group[i] >> 8;
+            addrs[r].sin6_addr.s6_addr[2 * i + 1] = group[i] & 0xFF;
+        }
+    }
+    return addrs;
 }
 
-int send_game_update_for_clients(server_information *server, uint16_t num, tile_diff *diff, uint8_t nb) {
-    return send_game_update(server->sock_mult, server->addr_mult, num, diff, nb);
+int send_game_update_for_clients(udp_thread_data *data, char *update, size_t update_length) {
+    game_destination dest = get_game_destination(data);
+    return send_game_update(game_egress, &dest, update, update_length);
 }
 
-int send_chat_message_to_client(server_information *server, int id, chat_message_type type, int sender_id, int eq,
-                                uint8_t message_length, char *message) {
-    return send_chat_message(server->sock_clients[id], type, sender_id, eq, message_length, message);
+/** The lobby of the player has to be locked */
+void send_chat_message_to_client(client_connection *conn, int sender_id, const chat_message_view *msg) {
+    if (send_chat_message(&conn->output, msg->type, sender_id, msg->eq, msg->message_length, msg->message) !=
+        EXIT_SUCCESS) {
+        disconnect_player(conn);
+    }
 }
 
-void handle_chat_message_global(server_information *server, int sender_id, chat_message *msg) {
+void handle_chat_message_global(lobby *l, int sender_id, const chat_message_view *msg) {
     for (int i = 0; i < PLAYER_NUM; i++) {
         if (i == sender_id) {
             continue; // Don't send the message to the sender
         }
-        if (server->sock_clients[i] == -1) {
+        if (l->players[i] == NULL) {
             continue; // Don't send the message to the client if it is not connected
         }
 
-        if (send_chat_message_to_client(server, i, msg->type, sender_id, msg->eq, msg->message_length, msg->message) <
-            0) {
-            perror("send_chat_message_to_client");
-        }
+        send_chat_message_to_client(l->players[i], sender_id, msg);
     }
 }
 
-void handle_chat_message_team(server_information *server, int sender_id, chat_message *msg) {
+void handle_chat_message_team(lobby *l, int sender_id, const chat_message_view *msg) {
     for (int i = 0; i < PLAYER_NUM; i++) {
         if (i == sender_id) {
             continue; // Don't send the message to the sender or to the other team
@@ -593,55 +735,45 @@ void handle_chat_message_team(server_information *server, int sender_id, chat_me
             continue; // If the sender is in the second team, don't send the message to the first team
         }
 
-        if (server->sock_clients[i] == -1) {
+        if (l->players[i] == NULL) {
             continue; // Don't send the message to the client if it is not connected
         }
 
-        if (send_chat_message_to_client(server, i, msg->type, sender_id, msg->eq, msg->message_length, msg->message) <
-            0) {
-            perror("send_chat_message_to_client");
-        }
+        send_chat_message_to_client(l->players[i], sender_id, msg);
     }
 }
 
-void handle_chat_message(server_information *server, int sender_id, chat_message *msg) {
-    if (get_game_mode(TMP_GAME_ID) == SOLO) {
-        handle_chat_message_global(server, sender_id, msg);
-    } else if (get_game_mode(TMP_GAME_ID) == TEAM) {
+/** The lobby of the sender has to be locked */
+void handle_chat_message(lobby *l, int sender_id, const chat_message_view *msg) {
+    if (l->mode == SOLO) {
+        handle_chat_message_global(l, sender_id, msg);
+    } else if (l->mode == TEAM) {
         if (msg->type == GLOBAL_M) {
-            handle_chat_message_global(server, sender_id, msg);
+            handle_chat_message_global(l, sender_id, msg);
         } else if (msg->type == TEAM_M) {
-            handle_chat_message_team(server, sender_id, msg);
+            handle_chat_message_team(l, sender_id, msg);
         }
     } else {
         perror("Unknown game mode");
     }
 }
 
-void handle_game_over(server_information *server, int game_id) {
-    GAME_MODE mode;
-    pthread_mutex_lock(lock_game_model);
-    mode = get_game_mode(game_id);
-    pthread_mutex_unlock(lock_game_model);
-
-    if (mode == SOLO) {
-        pthread_mutex_lock(lock_game_model);
-        int winner_player = get_winner_solo(game_id);
-        pthread_mutex_unlock(lock_game_model);
+/** The lobby has to be locked */
+void handle_game_over(lobby *l) {
+    if (l->mode == SOLO) {
+        int winner_player = get_winner_solo(l->game_id);
         for (int i = 0; i < PLAYER_NUM; i++) {
-            if (server->sock_clients[i] != -1) {
-                if (send_game_over(server->sock_clients[i], SOLO, winner_player, 0) < 0) {
+            if (l->players[i] != NULL) {
+                if (send_game_over(&l->players[i]->output, SOLO, winner_player, 0) != EXIT_SUCCESS) {
                     perror("send_game_over");
                 }
             }
         }
-    } else if (mode == TEAM) {
-        pthread_mutex_lock(lock_game_model);
-        int winner_team = get_winner_team(game_id);
-        pthread_mutex_unlock(lock_game_model);
+    } else if (l->mode == TEAM) {
+        int winner_team = get_winner_team(l->game_id);
         for (int i = 0; i < PLAYER_NUM; i++) {
-            if (server->sock_clients[i] != -1) {
-                if (send_game_over(server->sock_clients[i], TEAM, 0, winner_team) < 0) {
+            if (l->players[i] != NULL) {
+                if (send_game_over(&l->players[i]->output, TEAM, 0, winner_team) != EXIT_SUCCESS) {
                     perror("send_game_over");
                 }
             }
@@ -651,822 +783,1255 @@ void handle_game_over(server_information *server, int game_id) {
     }
 }
 
-struct pollfd *init_polls_connexion(int sock) {
-    struct pollfd *polls = malloc(INITIAL_POLL_FD_SIZE * sizeof(struct pollfd));
-    RETURN_NULL_IF_NULL_PERROR(polls, "malloc polls");
-    polls[0].fd = sock;
-    polls[0].events = POLL_IN;
-    return polls;
+int init_game_model(GAME_MODE mode) {
+    int game_id = init_model(game_dimension, mode);
+
+    return game_id;
 }
 
-struct pollfd *add_polls_to_poll(struct pollfd *polls, unsigned *nb, unsigned *s, int sock) {
-    if (*nb == *s) {
-        struct pollfd *n = (struct pollfd *)realloc(polls, 4 * (*s) * sizeof(struct pollfd));
-        *s *= 4;
-        *nb += 1;
-        return n;
-    } else {
-        polls[*nb].fd = sock;
-        polls[*nb].events = POLL_IN;
-        *nb += 1;
-        return polls;
+lobby *create_lobby(GAME_MODE mode) {
+    lobby *l = malloc(sizeof(lobby));
+    RETURN_NULL_IF_NULL_PERROR(l, "malloc lobby");
+    memset(l, 0, sizeof(lobby));
+
+    if (pthread_mutex_init(&l->lock, NULL) != 0) {
+        free(l);
+        return NULL;
     }
-}
 
-void remove_polls_to_poll(struct pollfd *polls, unsigned *nb, unsigned i) {
-    if (i >= *nb) {
-        return;
+    l->mode = mode;
+    l->references = 1; // Reference of the matchmaking, then of the game threads
+    init_match_entry(&l->entry);
+    init_settled_places(&l->settled);
+    l->match_deadline = time(NULL) + LOBBY_TIMEOUT;
+    l->game_id = init_game_model(mode);
+    if (l->game_id == -1) {
+        goto exit_freeing_lobby;
     }
-    polls[i].fd = polls[0].fd;
-    *nb -= 1;
-}
+    if (nb_ingress_sockets > 0 && l->game_id >= MAX_SESSIONS) {
+        remove_game(l->game_id);
+        goto exit_freeing_lobby;
+    }
+    l->token = ((uint32_t)random() << 16) | (uint32_t)l->game_id;
 
-int try_to_init_socket_of_client() {
-    struct sockaddr_in6 client_addr;
-    int client_addr_len = sizeof(client_addr);
-    int res = accept(sock_tcp, (struct sockaddr *)&client_addr, (socklen_t *)&client_addr_len);
-    if (res < 0) {
-        perror("client acceptance");
-        return EXIT_FAILURE;
+    l->server = take_endpoint();
+    if (l->server == NULL) {
+        remove_game(l->game_id);
+        goto exit_freeing_lobby;
     }
 
-    print_ip_of_client(client_addr);
-    return res;
+    return l;
+
+exit_freeing_lobby:
+    pthread_mutex_destroy(&l->lock);
+    free(l);
+    return NULL;
 }
 
-int init_game_model(GAME_MODE mode) {
-    dimension dim;
-    dim.width = GAMEBOARD_WIDTH;
-    dim.height = GAMEBOARD_HEIGHT;
+void release_lobby(lobby *l) {
+    pthread_mutex_lock(&l->lock);
+    l->references--;
+    bool is_unused = l->references == 0;
+    pthread_mutex_unlock(&l->lock);
 
-    pthread_mutex_lock(lock_game_model);
-    int game_id = init_model(dim, mode);
-    pthread_mutex_unlock(lock_game_model);
+    if (!is_unused) {
+        return;
+    }
 
-    return game_id;
+    if (!l->started) {
+        remove_game(l->game_id); // The game threads remove the games which have started
+    }
+    recycle_endpoint(l->server);
+    pthread_mutex_destroy(&l->lock);
+    free(l);
 }
 
-int add_game_action_to_thread_data(udp_thread_data *data, game_action *action) {
-    if (data->size_game_actions == 0) {
-        data->size_game_actions = INITIAL_GAME_ACTIONS_SIZE;
-        data->game_actions = malloc(sizeof(game_action *) * data->size_game_actions);
+int init_game_threads(lobby *l);
+
+/** The lobby has to be locked */
+void start_game(lobby *l) {
+    l->started = true;
+
+    for (int i = 0; i < PLAYER_NUM; i++) {
+        if (l->players[i] != NULL) {
+            l->players[i]->state = PLAYING;
+        }
     }
-    if (data->nb_game_actions + 1 >= data->size_game_actions) {
-        data->game_actions = realloc(data->game_actions, data->size_game_actions * sizeof(game_action *) * 2);
-        RETURN_FAILURE_IF_NULL(data->game_actions);
-        data->size_game_actions *= 2;
+
+    if (init_game_threads(l) != EXIT_SUCCESS) {
+        fprintf(stderr, "The threads of the game %d could not be started.\n", l->game_id);
     }
-    data->game_actions[data->nb_game_actions] = action;
-    data->nb_game_actions++;
-    return EXIT_SUCCESS;
 }
 
-int empty_game_actions(udp_thread_data *data) {
-    for (unsigned i = 0; i < data->nb_game_actions; i++) {
-        free(data->game_actions[i]);
-        data->game_actions[i] = NULL;
+/** The lobby has to be locked */
+void try_to_start_game(lobby *l) {
+    if (!l->started && l->matched && are_places_settled(&l->settled)) {
+        start_game(l);
     }
-    data->nb_game_actions = 0;
-    return EXIT_SUCCESS;
 }
 
-void free_game_actions(game_action **game_actions, size_t nb_game_actions) {
-    for (unsigned i = 0; i < nb_game_actions; i++) {
-        free(game_actions[i]);
+/** The lobby has to be locked */
+void settle_player(lobby *l, int id) {
+    if (settle_place(&l->settled, id)) {
+        try_to_start_game(l);
     }
-    free(game_actions);
 }
 
-void *serv_client_recv_game_action(void *arg_udp_thread_data) {
-    udp_thread_data *data = (udp_thread_data *)arg_udp_thread_data;
-    while (true) {
-        pthread_mutex_lock(data->lock_finished_flag);
-        if (*data->finished_flag) {
-            pthread_mutex_unlock(data->lock_finished_flag);
-            break;
+/** Sends the game informations to the players who do not have them once the lobby is matched,
+ * the lobby has to be locked
+ */
+void fill_lobby(lobby *l) {
+    time_t deadline = time(NULL) + READY_TIMEOUT;
+    for (int i = 0; i < PLAYER_NUM; i++) {
+        client_connection *conn = l->players[i];
+        if (conn == NULL || conn->state != WAITING_OTHER_PLAYERS) {
+            continue; // Absent places are settled, and the players who stayed already have the informations
         }
-        pthread_mutex_unlock(data->lock_finished_flag);
-
-        game_action *action = recv_game_action_of_clients(data->server);
-        pthread_mutex_lock(lock_game_model);
-        GAME_MODE game_mode = get_game_mode(data->game_id);
-        pthread_mutex_unlock(lock_game_model);
-        if (action != NULL && action->game_mode == game_mode) {
-            pthread_mutex_lock(&data->lock_game_actions);
-            add_game_action_to_thread_data(data, action);
-            pthread_mutex_unlock(&data->lock_game_actions);
+        conn->state = WAITING_READY;
+        conn->deadline = deadline;
+        if (send_connexion_information_of_client(l, conn) != EXIT_SUCCESS) {
+            disconnect_player(conn);
         }
     }
-
-    sleep(2); // Wait for the other thread to finish
-
-    pthread_mutex_lock(data->lock_nb_stopped_udp_threads);
-    *data->nb_stopped_udp_threads += 1;
-    int nb_stopped_udp_threads = *data->nb_stopped_udp_threads;
-    pthread_mutex_unlock(data->lock_nb_stopped_udp_threads);
-
-    if (nb_stopped_udp_threads == 2) {
-        unlock_mutex_for_everyone(data->lock_all_udp_threads_closed, data->cond_lock_all_udp_threads_closed);
-    }
-
-    return NULL;
+    try_to_start_game(l);
 }
 
-void increment_last_num_message(int *last_num_message) {
-    *last_num_message = *last_num_message + 1 % LIMIT_LAST_NUM_MESSAGE_MULT;
-}
-
-void *serve_clients_send_mult_sec(void *arg_udp_thread_data) {
-    udp_thread_data *data = (udp_thread_data *)arg_udp_thread_data;
-
-    int last_num_sec_message = 1;
-    while (true) {
-        sleep(1);
-        pthread_mutex_lock(lock_game_model);
-        update_bombs(data->game_id);
-        pthread_mutex_unlock(lock_game_model);
-
-        pthread_mutex_lock(lock_game_model);
-        board *game_board = get_game_board(data->game_id);
-        pthread_mutex_unlock(lock_game_model);
-        RETURN_NULL_IF_NULL(game_board);
-
-        pthread_mutex_lock(&data->lock_send_udp);
-        send_game_board_for_clients(data->server, last_num_sec_message, game_board);
-        pthread_mutex_unlock(&data->lock_send_udp);
-        increment_last_num_message(&last_num_sec_message);
-        free(game_board);
-        // TODO manage errors
-
-        pthread_mutex_lock(lock_game_model);
-        bool game_over = is_game_over(data->game_id);
-        pthread_mutex_unlock(lock_game_model);
-
-        if (game_over) {
-            pthread_mutex_lock(data->lock_finished_flag);
-            *data->finished_flag = true;
-            pthread_mutex_unlock(data->lock_finished_flag);
-
-            // Wait for the TCP threads to finish
-            lock_mutex_to_wait(data->lock_all_tcp_threads_closed, data->cond_lock_all_tcp_threads_closed);
-
-            // Wait for the UDP threads to finish
-            lock_mutex_to_wait(data->lock_all_udp_threads_closed, data->cond_lock_all_udp_threads_closed);
-
-            pthread_mutex_lock(&data->lock_game_actions);
-            free_game_actions(data->game_actions, data->nb_game_actions);
-            pthread_mutex_unlock(&data->lock_game_actions);
-
-            pthread_mutex_lock(lock_game_model);
-            remove_game(data->game_id);
-            pthread_mutex_unlock(lock_game_model);
-
-            pthread_mutex_destroy(data->lock_finished_flag);
-            free(data->lock_finished_flag);
-
-            pthread_mutex_destroy(&data->lock_send_udp);
-
-            pthread_mutex_destroy(&data->lock_game_actions);
-
-            pthread_mutex_destroy(data->lock_nb_stopped_udp_threads);
-            free(data->lock_nb_stopped_udp_threads);
-
-            pthread_mutex_destroy(data->lock_all_tcp_threads_closed);
-            free(data->lock_all_tcp_threads_closed);
-
-            pthread_cond_destroy(data->cond_lock_all_tcp_threads_closed);
-            free(data->cond_lock_all_tcp_threads_closed);
-
-            pthread_mutex_destroy(data->lock_all_udp_threads_closed);
-            free(data->lock_all_udp_threads_closed);
-
-            pthread_cond_destroy(data->cond_lock_all_udp_threads_closed);
-            free(data->cond_lock_all_udp_threads_closed);
-
-            break;
+/** Finishes the game for the players still connected, their connections will be closed by their reactor once the
+ * end of the game is sent
+ */
+void finish_lobby(lobby *l) {
+    pthread_mutex_lock(&l->lock);
+    l->finished = true;
+    handle_game_over(l);
+    for (int i = 0; i < PLAYER_NUM; i++) {
+        client_connection *conn = l->players[i];
+        if (conn == NULL) {
+            continue;
+        }
+        if (has_pending_tcp_output(&conn->output)) {
+            conn->shutdown_when_sent = true; // By the reactor, once the socket is writable again
+        } else {
+            disconnect_player(conn);
         }
     }
-    free(data);
+    pthread_mutex_unlock(&l->lock);
+}
 
-    return NULL;
+void request_provisioning() {
+    pthread_mutex_lock(&lock_provisioning);
+    provisioning_requested = true;
+    pthread_cond_signal(&provisioning_needed);
+    pthread_mutex_unlock(&lock_provisioning);
 }
 
-/** The message is considered as a next message if it is between the last message
- * and a fairly large part after the latter (half the limit) modulo limit
+/** Gives the player a place in the oldest lobby of the mode which waits for players, the matchmaking has to be
+ * locked
+ * Returns false if no lobby has a free place
  */
-bool is_next_message(int last_num_message, int num_message, int limit) {
-    int just_after = (last_num_message + 1) % limit;
-    int limit_next_message = (last_num_message + 1 + (limit / 2)) % limit;
+bool place_player(matchmaking *m, client_connection *conn) {
+    int id;
+    match_entry *entry = take_place(&m->queue, &id);
+    if (entry == NULL) {
+        return false;
+    }
+    lobby *l = (lobby *)entry; // The entry is the first member of the lobby
 
-    if (just_after < limit_next_message) {
-        return num_message >= just_after && num_message < limit_next_message;
+    pthread_mutex_lock(&l->lock);
+    if (l->connected_players == 0) {
+        l->match_deadline = time(NULL) + LOBBY_TIMEOUT; // The lobby was spare, or left by all its players
+    }
+    conn->id = id;
+    if (conn->mode == TEAM && (conn->id == 1 || conn->id == 2)) { // 0 and 3 are in the same team
+        conn->eq = 1;
     } else {
-        return (num_message >= just_after && num_message < limit) || (num_message <= limit_next_message);
+        conn->eq = 0;
+    }
+    conn->lobby = l;
+    conn->state = WAITING_OTHER_PLAYERS;
+    l->references++;
+    l->players[conn->id] = conn;
+    l->server->sock_clients[conn->id] = conn->sock;
+    l->connected_players++;
+
+    if (!entry->queued) { // The reference of the matchmaking goes to the game threads once the game starts
+        l->matched = true;
+        fill_lobby(l);
+    }
+    pthread_mutex_unlock(&l->lock);
+    return true;
+}
+
+/** Places the player in a lobby, or makes him wait for the next lobby created if none has a free place */
+void join_lobby(client_connection *conn, GAME_MODE mode) {
+    matchmaking *m = get_matchmaking(mode);
+    conn->mode = mode;
+    conn->has_joined = true;
+
+    pthread_mutex_lock(&m->lock);
+    bool placed = m->first_waiting == NULL && place_player(m, conn); // The players waiting are placed first
+    if (!placed) {
+        conn->next_waiting = NULL;
+        if (m->last_waiting != NULL) {
+            m->last_waiting->next_waiting = conn;
+        } else {
+            m->first_waiting = conn;
+        }
+        m->last_waiting = conn;
     }
-}
+    bool is_short = m->queue.size < SPARE_LOBBIES;
+    pthread_mutex_unlock(&m->lock);
 
-void game_action_swap(game_action **game_actions, unsigned i, unsigned j) {
-    game_action *current_action = game_actions[j];
-    game_actions[j] = game_actions[i];
-    game_actions[i] = current_action;
+    if (is_short) {
+        request_provisioning();
+    }
 }
 
-unsigned game_action_partition(game_action **game_actions, int start, int end, int last_num_message[PLAYER_NUM]) {
-    game_action *pivot = game_actions[end];
-    unsigned j = start;
-
-    for (int i = start; i < end - 1; i++) {
-        if (game_actions[i]->id != pivot->id) {
+/** Removes a player waiting for a lobby, the matchmaking has to be locked */
+void remove_waiting_player(matchmaking *m, client_connection *conn) {
+    client_connection *prev = NULL;
+    for (client_connection *c = m->first_waiting; c != NULL; prev = c, c = c->next_waiting) {
+        if (c != conn) {
             continue;
         }
-        if (!is_next_message(last_num_message[pivot->id], pivot->message_number, LIMIT_LAST_NUM_MESSAGE_CLIENT) &&
-            is_next_message(last_num_message[game_actions[i]->id], game_actions[i]->message_number,
-                            LIMIT_LAST_NUM_MESSAGE_CLIENT)) {
-            continue;
+        if (prev != NULL) {
+            prev->next_waiting = c->next_waiting;
+        } else {
+            m->first_waiting = c->next_waiting;
         }
-        if (abs(last_num_message[pivot->id] - pivot->message_number) <=
-            abs(last_num_message[game_actions[i]->id] - game_actions[i]->message_number)) {
-            continue;
+        if (m->last_waiting == c) {
+            m->last_waiting = prev;
         }
-        game_action_swap(game_actions, i, j);
-        j++;
+        return;
     }
-    game_action_swap(game_actions, j, end);
-
-    return j;
 }
 
-void game_action_quick_sort(game_action **game_actions, int start, int end, int last_num_message[PLAYER_NUM]) {
-    if (start >= end) {
-        return;
-    }
-    unsigned pivot = game_action_partition(game_actions, start, end, last_num_message);
+/** Creates the lobbies of a mode until SPARE_LOBBIES have free places and no player waits for one
+ * Returns EXIT_FAILURE if a lobby could not be created
+ */
+int provision_lobbies(GAME_MODE mode) {
+    matchmaking *m = get_matchmaking(mode);
+    while (true) {
+        pthread_mutex_lock(&m->lock);
+        bool is_short = m->queue.size < SPARE_LOBBIES || m->first_waiting != NULL;
+        pthread_mutex_unlock(&m->lock);
+        if (!is_short) {
+            return EXIT_SUCCESS;
+        }
 
-    game_action_quick_sort(game_actions, start, pivot - 1, last_num_message);
-    game_action_quick_sort(game_actions, pivot + 1, end, last_num_message);
-}
+        lobby *created = create_lobby(mode); // Without any lock, it binds the sockets of the game
+        RETURN_FAILURE_IF_NULL(created);
 
-void game_actions_sort(game_action **game_actions, size_t nb_game_actions, int last_num_message[PLAYER_NUM]) {
-    game_action_quick_sort(game_actions, 0, nb_game_actions - 1, last_num_message);
+        pthread_mutex_lock(&m->lock);
+        enqueue_lobby(&m->queue, &created->entry);
+        while (m->first_waiting != NULL && place_player(m, m->first_waiting)) {
+            m->first_waiting = m->first_waiting->next_waiting;
+        }
+        if (m->first_waiting == NULL) {
+            m->last_waiting = NULL;
+        }
+        pthread_mutex_unlock(&m->lock);
+    }
 }
 
-player_action *merge_player_moves_and_place_bomb(player_action *player_moves, unsigned nb_player_moves,
-                                                 player_action *player_place_bomb, unsigned nb_place_bomb,
-                                                 unsigned *nb_player_actions) {
-    if (nb_player_actions == 0 && nb_place_bomb == 0) {
-        return NULL;
+void *provision_lobbies_thread(void *arg) {
+    (void)arg;
+    while (true) {
+        pthread_mutex_lock(&lock_provisioning);
+        while (!provisioning_requested && !provisioning_stopped) {
+            pthread_cond_wait(&provisioning_needed, &lock_provisioning);
+        }
+        provisioning_requested = false;
+        bool stopped = provisioning_stopped;
+        pthread_mutex_unlock(&lock_provisioning);
+        if (stopped) {
+            return NULL;
+        }
+
+        if (provision_lobbies(SOLO) != EXIT_SUCCESS || provision_lobbies(TEAM) != EXIT_SUCCESS) {
+            fprintf(stderr, "A lobby could not be created, the players wait for the next try.\n");
+            sleep(1);
+            request_provisioning();
+        }
+        if (provision_endpoints() != EXIT_SUCCESS) {
+            fprintf(stderr, "A game endpoint could not be bound, the pool is refilled later.\n");
+        }
     }
-    player_action *res = malloc(sizeof(player_action) * (nb_player_moves + nb_place_bomb));
-    RETURN_NULL_IF_NULL_PERROR(res, "malloc player_action");
+}
 
-    memcpy(res, player_moves, sizeof(player_action) * nb_player_moves);
-    memcpy(res + sizeof(player_action) * nb_player_moves, player_place_bomb, sizeof(player_action) * nb_place_bomb);
+int start_provisioning() {
+    provisioning_requested = true; // The spare lobbies of each mode
+    provisioning_stopped = false;
+    if (pthread_create(&provisioning_thread, NULL, provision_lobbies_thread, NULL) != 0) {
+        perror("pthread_create provisioning");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
 
-    *nb_player_actions = nb_player_moves + nb_place_bomb;
-    return res;
+void stop_provisioning() {
+    pthread_mutex_lock(&lock_provisioning);
+    provisioning_stopped = true;
+    pthread_cond_signal(&provisioning_needed);
+    pthread_mutex_unlock(&lock_provisioning);
+    pthread_join(provisioning_thread, NULL);
 }
 
-player_action *get_player_actions(game_action **game_actions, size_t nb_game_actions,
-                                  int last_num_received_message[PLAYER_NUM], unsigned *nb_player_actions) {
-    if (game_actions == NULL) {
-        return NULL;
+/** Stops waiting for players once the deadline of the lobby is over: the lobby starts with the players already
+ * there, the absent ones are dead, or closes if there are fewer than MIN_LOBBY_PLAYERS
+ * Returns true if the lobby is closed, its remaining player has then to be disconnected
+ */
+bool expire_lobby(lobby *l) {
+    matchmaking *m = get_matchmaking(l->mode);
+    bool closed = false;
+
+    pthread_mutex_lock(&m->lock);
+    pthread_mutex_lock(&l->lock);
+    if (!l->matched && !l->closed && l->match_deadline <= time(NULL)) {
+        close_places(&m->queue, &l->entry);
+        if (l->connected_players < MIN_LOBBY_PLAYERS) {
+            l->closed = true;
+            closed = true;
+        } else {
+            l->matched = true;
+            for (int i = 0; i < PLAYER_NUM; i++) {
+                // The places already absent at a previous expiry are settled, and their players dead, once
+                if (l->players[i] == NULL && settle_place(&l->settled, i)) {
+                    set_player_dead(l->game_id, i);
+                }
+            }
+            fill_lobby(l);
+        }
     }
-    player_action *player_moves = malloc(sizeof(player_action) * PLAYER_NUM);
-    RETURN_NULL_IF_NULL_PERROR(player_moves, "malloc player_moves");
-    player_action *player_place_bomb = malloc(sizeof(player_action) * PLAYER_NUM);
-    RETURN_NULL_IF_NULL_PERROR(player_place_bomb, "malloc player_place_bomb");
+    pthread_mutex_unlock(&l->lock);
+    pthread_mutex_unlock(&m->lock);
 
-    unsigned nb_player_moves = 0;
-    unsigned nb_place_bomb = 0;
+    if (closed) {
+        release_lobby(l); // Reference of the matchmaking
+    }
+    return closed;
+}
 
-    bool already_move[PLAYER_NUM];
-    bool already_place_bomb[PLAYER_NUM];
-    for (unsigned i = 0; i < PLAYER_NUM; i++) {
-        already_move[i] = false;
-        already_place_bomb[i] = false;
+void close_connection(client_connection *conn) {
+    reactor_context *context = conn->context;
+
+    pthread_mutex_lock(&context->lock_connections);
+    reactor_remove(context->reactor, conn->handler);
+    if (conn->prev != NULL) {
+        conn->prev->next = conn->next;
+    } else {
+        context->connections = conn->next;
+    }
+    if (conn->next != NULL) {
+        conn->next->prev = conn->prev;
     }
+    pthread_mutex_unlock(&context->lock_connections);
 
-    for (int i = nb_game_actions - 1; i >= 0; i--) {
-        // Other actions were sent before those kept
-        if (nb_player_moves == PLAYER_NUM && nb_place_bomb == PLAYER_NUM) {
-            break;
+    if (!conn->has_joined) {
+        close(conn->sock);
+        free(conn);
+        return;
+    }
+
+    matchmaking *m = get_matchmaking(conn->mode);
+    pthread_mutex_lock(&m->lock);
+    lobby *l = conn->lobby;
+    if (l == NULL) {
+        remove_waiting_player(m, conn);
+        pthread_mutex_unlock(&m->lock);
+        close(conn->sock);
+        free(conn);
+        return;
+    }
+    pthread_mutex_lock(&l->lock);
+    l->players[conn->id] = NULL;
+    l->server->sock_clients[conn->id] = -1;
+    l->connected_players--;
+    close(conn->sock);
+    if (!l->started && !l->closed) {
+        // The place goes to another player, a lobby which was matched waits for him
+        unsettle_place(&l->settled, conn->id);
+        if (!l->entry.queued) {
+            l->matched = false;
+            l->match_deadline = time(NULL) + LOBBY_BACKFILL_TIMEOUT;
         }
-        // Message ignored
-        if (!is_next_message(last_num_received_message[game_actions[i]->id], game_actions[i]->message_number,
-                             LIMIT_LAST_NUM_MESSAGE_CLIENT)) {
-            continue;
+        give_back_place(&m->queue, &l->entry, conn->id);
+    } else if (l->started) {
+        if (!l->finished) {
+            set_player_dead(l->game_id, conn->id);
         }
-        // Keep the action if its a move and there is no move kept for this player
-        if (is_move(game_actions[i]->action) && !already_move[game_actions[i]->id]) {
-            player_moves[nb_player_moves].id = game_actions[i]->id;
-            player_moves[nb_player_moves].action = game_actions[i]->action;
-            already_move[game_actions[i]->id] = true;
+        settle_player(l, conn->id);
+    }
+    pthread_mutex_unlock(&l->lock);
+    pthread_mutex_unlock(&m->lock);
 
-            // To keep the last message number
-            if (!already_place_bomb[game_actions[i]->id]) {
-                last_num_received_message[game_actions[i]->id] = game_actions[i]->message_number;
-            }
-            nb_player_moves++;
-            continue;
-        }
-        // Keep the action if its a place bomb and there is no bomb placing move kept for this player
-        if (game_actions[i]->action == GAME_PLACE_BOMB && !already_place_bomb[game_actions[i]->id]) {
-            player_place_bomb[nb_place_bomb].id = game_actions[i]->id;
-            player_place_bomb[nb_place_bomb].action = game_actions[i]->action;
-            already_place_bomb[game_actions[i]->id] = true;
+    release_lobby(l);
+    free(conn);
+}
 
-            // To keep the last message number
-            if (!already_move[game_actions[i]->id]) {
-                last_num_received_message[game_actions[i]->id] = game_actions[i]->message_number;
-            }
-            nb_place_bomb++;
+/** Handles the first complete message of the buffer depending on the state of the connection
+ * Changes consumed with the size of the handled message, 0 if the message is not complete
+ */
+int handle_connection_message(client_connection *conn, size_t *consumed) {
+    *consumed = 0;
+
+    if (!conn->has_joined) {
+        if (conn->buffered < sizeof(connection_header_raw)) {
+            return EXIT_SUCCESS;
         }
-    }
+        connection_header_raw raw;
+        memcpy(&raw, conn->buffer, sizeof(connection_header_raw));
+        initial_connection_header head;
+        RETURN_FAILURE_IF_ERROR(deserialize_initial_connection_into(&raw, &head));
 
-    if (nb_player_moves == 0 && nb_place_bomb == 0) {
-        return NULL;
+        *consumed = sizeof(connection_header_raw);
+        join_lobby(conn, head.game_mode);
+        return EXIT_SUCCESS;
     }
 
-    if (nb_player_moves == 0) {
-        free(player_moves);
-        *nb_player_actions = nb_place_bomb;
-        return player_place_bomb;
+    matchmaking *m = get_matchmaking(conn->mode);
+    pthread_mutex_lock(&m->lock);
+    lobby *l = conn->lobby; // It does not change once set
+    pthread_mutex_unlock(&m->lock);
+    if (l == NULL) {
+        return EXIT_SUCCESS; // Nothing is expected from the client until the lobby is full
     }
 
-    if (nb_place_bomb == 0) {
-        free(player_place_bomb);
-        *nb_player_actions = nb_player_moves;
-        return player_moves;
+    int res = EXIT_SUCCESS;
+    pthread_mutex_lock(&l->lock);
+    switch (conn->state) {
+        case WAITING_READY:
+            if (conn->buffered < sizeof(connection_header_raw)) {
+                break;
+            }
+            connection_header_raw raw;
+            memcpy(&raw, conn->buffer, sizeof(connection_header_raw));
+            ready_connection_header ready_informations;
+            if (deserialize_ready_connection_into(&raw, &ready_informations) != EXIT_SUCCESS ||
+                !is_ready_connection_of(&ready_informations, conn->mode, conn->id, conn->eq)) {
+                res = EXIT_FAILURE; // Not the header of this player, the connection is closed
+                break;
+            }
+
+            *consumed = sizeof(connection_header_raw);
+            conn->state = READY;
+            settle_player(l, conn->id);
+            break;
+        case READY:
+        case PLAYING:
+            // 2 bytes for the header and 1 for the message length
+            if (conn->buffered < CHAT_MESSAGE_SIZE(0) ||
+                conn->buffered < CHAT_MESSAGE_SIZE((uint8_t)conn->buffer[2])) {
+                break;
+            }
+            chat_message_view msg;
+            if (client_deserialize_chat_message_view(conn->buffer, conn->buffered, &msg) != EXIT_SUCCESS) {
+                res = EXIT_FAILURE;
+                break;
+            }
+            *consumed = CHAT_MESSAGE_SIZE(msg.message_length);
+            handle_chat_message(l, conn->id, &msg);
+            break;
+        default: // Nothing is expected from the client until the lobby is full
+            break;
     }
+    pthread_mutex_unlock(&l->lock);
 
-    player_action *res = merge_player_moves_and_place_bomb(player_moves, nb_player_moves, player_place_bomb,
-                                                           nb_place_bomb, nb_player_actions);
-    free(player_moves);
-    free(player_place_bomb);
     return res;
 }
 
-game_action **copy_game_actions(game_action **game_actions, size_t nb_game_actions) {
-    if (nb_game_actions == 0) {
-        return NULL;
+int handle_connection_buffer(client_connection *conn) {
+    while (conn->buffered > 0) {
+        size_t consumed;
+        RETURN_FAILURE_IF_ERROR(handle_connection_message(conn, &consumed));
+        if (consumed == 0) {
+            break;
+        }
+        conn->buffered -= consumed;
+        memmove(conn->buffer, conn->buffer + consumed, conn->buffered);
     }
-    game_action **res = malloc(nb_game_actions * (sizeof(game_action *)));
-    RETURN_NULL_IF_NULL(res);
+    return EXIT_SUCCESS;
+}
 
-    for (unsigned i = 0; i < nb_game_actions; i++) {
-        res[i] = malloc(sizeof(game_action));
-        memcpy(res[i], game_actions[i], sizeof(game_action));
+/** Reads everything available on the socket, as required by the edge-triggered mode
+ */
+int read_connection(client_connection *conn) {
+    while (true) {
+        if (conn->buffered == CONNECTION_BUFFER_SIZE) {
+            return EXIT_FAILURE; // No message can be that long
+        }
+        ssize_t res = recv(conn->sock, conn->buffer + conn->buffered, CONNECTION_BUFFER_SIZE - conn->buffered, 0);
+        if (res < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return EXIT_SUCCESS;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("recv client connection");
+            return EXIT_FAILURE;
+        }
+        if (res == 0) {
+            handle_connection_buffer(conn);
+            return EXIT_FAILURE; // The client has left
+        }
+        conn->buffered += res;
+        RETURN_FAILURE_IF_ERROR(handle_connection_buffer(conn));
     }
-    return res;
 }
 
-void *serve_clients_send_mult_freq(void *arg_udp_thread_data) {
-    udp_thread_data *data = (udp_thread_data *)arg_udp_thread_data;
-    int last_num_received_messages[PLAYER_NUM];
-    for (unsigned i = 0; i < PLAYER_NUM; i++) {
-        last_num_received_messages[i] = LIMIT_LAST_NUM_MESSAGE_CLIENT - 1;
+/** Sends what is left of the output once the socket is writable again, and shuts the connection down if the game
+ * is over and everything is sent
+ */
+int write_connection(client_connection *conn) {
+    if (!conn->has_joined) {
+        return EXIT_SUCCESS;
+    }
+    matchmaking *m = get_matchmaking(conn->mode);
+    pthread_mutex_lock(&m->lock);
+    lobby *l = conn->lobby; // It does not change once set
+    pthread_mutex_unlock(&m->lock);
+    if (l == NULL) {
+        return EXIT_SUCCESS; // Nothing is sent before the connection has a lobby
     }
 
-    int last_num_freq_message = 0;
-    while (true) {
-        usleep(FREQ);
+    pthread_mutex_lock(&l->lock);
+    int res = flush_tcp_output(&conn->output);
+    if (res == EXIT_SUCCESS && conn->shutdown_when_sent && !has_pending_tcp_output(&conn->output)) {
+        disconnect_player(conn);
+    }
+    pthread_mutex_unlock(&l->lock);
+    return res;
+}
 
-        // Check if the game is over
-        pthread_mutex_lock(data->lock_finished_flag);
-        if (*data->finished_flag) {
-            pthread_mutex_unlock(data->lock_finished_flag);
-            break;
+void handle_connection_event(int fd, uint32_t events, void *data) {
+    (void)fd;
+    client_connection *conn = (client_connection *)data;
+
+    if (events & EPOLLIN) {
+        if (read_connection(conn) != EXIT_SUCCESS) {
+            close_connection(conn);
+            return;
         }
-        pthread_mutex_unlock(data->lock_finished_flag);
+    }
+    if (events & EPOLLOUT) {
+        if (write_connection(conn) != EXIT_SUCCESS) {
+            close_connection(conn);
+            return;
+        }
+    }
+    if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+        close_connection(conn);
+    }
+}
 
-        // Copy game actions
-        pthread_mutex_lock(&data->lock_game_actions);
-        size_t nb_game_actions = data->nb_game_actions;
-        if (nb_game_actions == 0) {
-            pthread_mutex_unlock(&data->lock_game_actions);
+/** Closes the connections of the players who have not sent their initial header, or have not been given a lobby,
+ * or have not sent their ready header in time, their places go to other players,
+ * and stops the lobbies which have waited too long for their players
+ */
+void check_connection_deadlines(void *data) {
+    reactor_context *context = (reactor_context *)data;
+    time_t now = time(NULL);
+    client_connection *expired = NULL;
+    client_connection *waiting_too_long = NULL; // Players of lobbies past their deadline
+
+    pthread_mutex_lock(&context->lock_connections);
+    for (client_connection *conn = context->connections; conn != NULL; conn = conn->next) {
+        if (!conn->has_joined) {
+            if (conn->deadline <= now) {
+                conn->next_expired = expired;
+                expired = conn;
+            }
             continue;
         }
-        game_action **game_actions = copy_game_actions(data->game_actions, nb_game_actions);
-        RETURN_NULL_IF_NULL(game_actions);
-        empty_game_actions(data);
-        pthread_mutex_unlock(&data->lock_game_actions);
-
-        game_actions_sort(game_actions, data->nb_game_actions, last_num_received_messages);
 
-        // Get player actions
-        unsigned nb_player_actions;
-        player_action *player_actions =
-            get_player_actions(game_actions, nb_game_actions, last_num_received_messages, &nb_player_actions);
-        if (player_actions == NULL) {
+        matchmaking *m = get_matchmaking(conn->mode);
+        pthread_mutex_lock(&m->lock);
+        lobby *l = conn->lobby;
+        if (l == NULL) {
+            if (conn->deadline <= now) {
+                conn->next_expired = expired;
+                expired = conn;
+            }
+            pthread_mutex_unlock(&m->lock);
             continue;
         }
-        // Update the board with player actions and get the tile differences
-        unsigned size_tile_diff = 0;
+        pthread_mutex_lock(&l->lock);
+        pthread_mutex_unlock(&m->lock);
+        if (conn->state == WAITING_READY && conn->deadline <= now) {
+            conn->next_expired = expired;
+            expired = conn;
+        } else if (!l->matched && !l->closed && l->match_deadline <= now) {
+            conn->next_expired = waiting_too_long;
+            waiting_too_long = conn;
+        }
+        pthread_mutex_unlock(&l->lock);
+    }
+    pthread_mutex_unlock(&context->lock_connections);
 
-        pthread_mutex_lock(lock_game_model);
-        tile_diff *diffs = update_game_board(data->game_id, player_actions, nb_player_actions, &size_tile_diff);
-        pthread_mutex_unlock(lock_game_model);
-        RETURN_NULL_IF_NULL(diffs);
+    // Only the reactor of a connection closes it, the connections of the lists stay valid
+    while (expired != NULL) {
+        client_connection *next = expired->next_expired;
+        close_connection(expired);
+        expired = next;
+    }
+    while (waiting_too_long != NULL) {
+        client_connection *next = waiting_too_long->next_expired;
+        if (expire_lobby(waiting_too_long->lobby)) {
+            close_connection(waiting_too_long);
+        }
+        waiting_too_long = next;
+    }
+}
 
-        if (size_tile_diff == 0) {
-            continue;
+int init_reactors() {
+    for (unsigned i = 0; i < NB_REACTORS; i++) {
+        reactor_contexts[i].connections = NULL;
+        if (pthread_mutex_init(&reactor_contexts[i].lock_connections, NULL) != 0) {
+            return EXIT_FAILURE;
         }
+        reactor_contexts[i].reactor = create_reactor();
+        RETURN_FAILURE_IF_NULL(reactor_contexts[i].reactor);
+        RETURN_FAILURE_IF_ERROR(start_reactor(reactor_contexts[i].reactor, REACTOR_TIMER_PERIOD,
+                                              check_connection_deadlines, &reactor_contexts[i]));
+    }
+    return EXIT_SUCCESS;
+}
 
-        // Send the differences
-        pthread_mutex_lock(&data->lock_send_udp);
-        send_game_update_for_clients(data->server, last_num_freq_message, diffs, size_tile_diff);
-        pthread_mutex_unlock(&data->lock_send_udp);
+void free_reactors() {
+    for (unsigned i = 0; i < NB_REACTORS; i++) {
+        free_reactor(reactor_contexts[i].reactor);
+        reactor_contexts[i].reactor = NULL;
+    }
+}
 
-        // Last free
-        free(diffs);
-        free_game_actions(game_actions, nb_game_actions);
+int add_connection_to_reactor(int sock, reactor_context *context) {
+    client_connection *conn = malloc(sizeof(client_connection));
+    RETURN_FAILURE_IF_NULL_PERROR(conn, "malloc client_connection");
+    memset(conn, 0, sizeof(client_connection));
+    conn->sock = sock;
+    init_tcp_output(&conn->output, sock);
+    conn->state = WAITING_INITIAL_HEADER;
+    conn->deadline = time(NULL) + HANDSHAKE_TIMEOUT;
+    conn->context = context;
 
-        // Prepare new message
-        increment_last_num_message(&last_num_freq_message);
+    // The connection is in the list before any event, so that close_connection can remove it
+    pthread_mutex_lock(&context->lock_connections);
+    conn->next = context->connections;
+    if (context->connections != NULL) {
+        context->connections->prev = conn;
     }
+    context->connections = conn;
+    conn->handler = reactor_add(context->reactor, sock, EPOLLIN | EPOLLOUT | EPOLLRDHUP, handle_connection_event, conn);
+    if (conn->handler == NULL) {
+        context->connections = conn->next;
+        if (conn->next != NULL) {
+            conn->next->prev = NULL;
+        }
+        pthread_mutex_unlock(&context->lock_connections);
+        free(conn);
+        return EXIT_FAILURE;
+    }
+    pthread_mutex_unlock(&context->lock_connections);
 
-    sleep(2); // Wait for the other thread to finish
-
-    pthread_mutex_lock(data->lock_nb_stopped_udp_threads);
-    *data->nb_stopped_udp_threads += 1;
-    int nb_stopped_udp_threads = *data->nb_stopped_udp_threads;
-    pthread_mutex_unlock(data->lock_nb_stopped_udp_threads);
+    return EXIT_SUCCESS;
+}
 
-    if (nb_stopped_udp_threads == 2) {
-        unlock_mutex_for_everyone(data->lock_all_udp_threads_closed, data->cond_lock_all_udp_threads_closed);
-    }
+/** Makes the game reachable by the shared ingress threads */
+void register_session(udp_thread_data *data) {
+    pthread_rwlock_wrlock(&lock_sessions);
+    sessions[data->token % MAX_SESSIONS] = data;
+    pthread_rwlock_unlock(&lock_sessions);
+}
 
-    return NULL;
+/** Once it returns, no shared ingress thread uses the game anymore */
+void unregister_session(udp_thread_data *data) {
+    pthread_rwlock_wrlock(&lock_sessions);
+    sessions[data->token % MAX_SESSIONS] = NULL;
+    pthread_rwlock_unlock(&lock_sessions);
 }
 
-int init_game_threads(server_information *server, bool *finished_flag, pthread_mutex_t *lock_finished_flag,
-                      pthread_mutex_t *lock_all_tcp_threads_closed, pthread_cond_t *cond_lock_all_tcp_threads_closed,
-                      unsigned game_id) {
-    udp_thread_data *udp_thread_data_game = malloc(sizeof(udp_thread_data));
-    RETURN_FAILURE_IF_NULL(udp_thread_data_game);
-    udp_thread_data_game->finished_flag = finished_flag;
-    udp_thread_data_game->game_id = game_id;
-    udp_thread_data_game->game_actions = NULL;
-    udp_thread_data_game->size_game_actions = 0;
-    udp_thread_data_game->nb_game_actions = 0;
-    udp_thread_data_game->nb_stopped_udp_threads = malloc(sizeof(unsigned));
-    RETURN_FAILURE_IF_NULL(udp_thread_data_game->nb_stopped_udp_threads);
-    *udp_thread_data_game->nb_stopped_udp_threads = 0;
-
-    udp_thread_data_game->server = server;
-
-    udp_thread_data_game->lock_finished_flag = lock_finished_flag;
-    udp_thread_data_game->lock_all_tcp_threads_closed = lock_all_tcp_threads_closed;
-    udp_thread_data_game->lock_nb_stopped_udp_threads = malloc(sizeof(pthread_mutex_t));
-    RETURN_FAILURE_IF_NULL(udp_thread_data_game->lock_nb_stopped_udp_threads);
-    udp_thread_data_game->lock_all_udp_threads_closed = malloc(sizeof(pthread_mutex_t));
-    RETURN_FAILURE_IF_NULL(udp_thread_data_game->lock_all_udp_threads_closed);
-    udp_thread_data_game->cond_lock_all_tcp_threads_closed = cond_lock_all_tcp_threads_closed;
-    udp_thread_data_game->cond_lock_all_udp_threads_closed = malloc(sizeof(pthread_cond_t));
-    RETURN_FAILURE_IF_NULL(udp_thread_data_game->cond_lock_all_udp_threads_closed);
-
-    if (pthread_mutex_init(&udp_thread_data_game->lock_game_actions, NULL) < 0) {
-        goto EXIT_FREEING_DATA;
-    }
-    if (pthread_mutex_init(&udp_thread_data_game->lock_send_udp, NULL) < 0) {
-        goto EXIT_FREEING_DATA;
-    }
-    if (pthread_mutex_init(udp_thread_data_game->lock_nb_stopped_udp_threads, NULL) < 0) {
-        goto EXIT_FREEING_DATA;
-    }
-    if (pthread_mutex_init(udp_thread_data_game->lock_all_udp_threads_closed, NULL) < 0) {
-        goto EXIT_FREEING_DATA;
-    }
-    if (pthread_cond_init(udp_thread_data_game->cond_lock_all_udp_threads_closed, NULL) < 0) {
-        goto EXIT_FREEING_DATA;
-    }
+/** Frees the game when its tick task and its reception thread are both over */
+void release_game_data(udp_thread_data *data) {
+    pthread_mutex_lock(&data->lock_finished_flag);
+    data->references--;
+    bool is_unused = data->references == 0;
+    pthread_mutex_unlock(&data->lock_finished_flag);
 
-    if (pthread_create(&game_threads[0], NULL, serv_client_recv_game_action, udp_thread_data_game) < 0) {
-        goto EXIT_FREEING_DATA;
-    }
-    if (pthread_create(&game_threads[1], NULL, serve_clients_send_mult_sec, udp_thread_data_game) < 0) {
-        goto EXIT_FREEING_DATA;
+    if (!is_unused) {
+        return;
     }
-    if (pthread_create(&game_threads[2], NULL, serve_clients_send_mult_freq, udp_thread_data_game) < 0) {
-        goto EXIT_FREEING_DATA;
+
+    if (data->batch == NULL) {
+        unregister_session(data);
     }
+    free_recv_batch(data->batch);
+    free(data->region_addrs);
+    remove_game(data->game_id);
 
-    return EXIT_SUCCESS;
+    pthread_mutex_destroy(&data->lock_client_addrs);
+    pthread_mutex_destroy(&data->lock_ingress);
+    pthread_mutex_destroy(&data->lock_finished_flag);
 
-EXIT_FREEING_DATA:
-    free(udp_thread_data_game);
-    return EXIT_FAILURE;
+    release_lobby(data->lobby);
+    free(data);
 }
 
-void wait_all_clients_connected(pthread_mutex_t *lock, pthread_cond_t *cond, bool is_everyone_connected,
-                                unsigned *nb_connected) {
-    if (!is_everyone_connected) {
-        pthread_cond_wait(cond, lock);
+/** In unicast, the endpoint of a player is pinned by its first datagram sent from the host of its TCP connection,
+ * the token of the game is not enough to redirect the game messages of the player elsewhere
+ * Returns false if the datagram does not come from the endpoint of the player
+ */
+bool pin_client_endpoint(udp_thread_data *data, const client_datagram *datagram, int sock) {
+    const struct sockaddr_in6 *source = &datagram->source;
+    bool is_pinned = false;
+    pthread_mutex_lock(&data->lock_client_addrs);
+    if (data->client_socks[datagram->id] == -1) {
+        if (data->has_client_host[datagram->id] &&
+            memcmp(&source->sin6_addr, &data->client_hosts[datagram->id], sizeof(source->sin6_addr)) == 0) {
+            data->client_addrs[datagram->id] = *source;
+            data->client_socks[datagram->id] = sock;
+            is_pinned = true;
+        }
     } else {
-        free(nb_connected);
-        pthread_cond_broadcast(cond);
+        const struct sockaddr_in6 *pinned = &data->client_addrs[datagram->id];
+        is_pinned = data->client_socks[datagram->id] == sock && pinned->sin6_port == source->sin6_port &&
+                    memcmp(&pinned->sin6_addr, &source->sin6_addr, sizeof(source->sin6_addr)) == 0;
     }
-    pthread_mutex_unlock(lock);
+    pthread_mutex_unlock(&data->lock_client_addrs);
+    return is_pinned;
 }
 
-void wait_all_clients_not_ready(server_information *server, bool *finished_flag, pthread_mutex_t *lock_finished_flag,
-                                pthread_mutex_t *lock_all_tcp_threads_closed,
-                                pthread_cond_t *cond_lock_all_tcp_threads_closed, pthread_mutex_t *lock,
-                                pthread_cond_t *cond, bool is_ready, unsigned *nb_ready, int game_id) {
-    if (!is_ready) {
-        pthread_cond_wait(cond, lock);
-    } else {
-        pthread_mutex_lock(lock_game_model);
-        board *game_board = get_game_board(game_id);
-        pthread_mutex_unlock(lock_game_model);
-        send_game_board_for_clients(server, 0, game_board); // Initial game_board send
-        free_board(game_board);
-        init_game_threads(server, finished_flag, lock_finished_flag, lock_all_tcp_threads_closed,
-                          cond_lock_all_tcp_threads_closed, game_id); // TODO MANAGE ERRORS
+/** Hands a datagram of the players of the game, received on sock, to its tick task
+ * The actions which do not fit in the ring are dropped rather than waiting for the tick
+ */
+void dispatch_client_datagram(udp_thread_data *data, const client_datagram *datagram, int sock) {
+    if (transport == UNICAST_TRANSPORT && !pin_client_endpoint(data, datagram, sock)) {
+        return;
+    }
 
-        free(nb_ready);
-        pthread_cond_broadcast(cond);
+    switch (datagram->type) {
+        case ACTION_DATAGRAM:
+            if (datagram->action.game_mode == data->mode) {
+                push_actions(&data->game_actions, &datagram->action, 1);
+            }
+            break;
+        case BOARD_REQUEST_DATAGRAM:
+            atomic_fetch_add(&data->keyframe_requests, 1);
+            break;
+        case REGION_REQUEST_DATAGRAM:
+            atomic_fetch_add(&data->region_keyframe_requests, 1);
+            break;
     }
-    pthread_mutex_unlock(lock);
 }
 
-void handle_tcp_communication(tcp_thread_data *tcp_data) {
-    int client_sock = tcp_data->server->sock_clients[tcp_data->id];
-    char buffer[1];
-    fd_set read_fds;
-    struct timeval tv;
-    int retval;
-
+void *serv_client_recv_game_action(void *arg_udp_thread_data) {
+    udp_thread_data *data = (udp_thread_data *)arg_udp_thread_data;
+    client_datagram datagrams[RECV_BATCH_SIZE];
     while (true) {
-        if (client_sock == -1) {
+        pthread_mutex_lock(&data->lock_finished_flag);
+        if (data->finished_flag) {
+            pthread_mutex_unlock(&data->lock_finished_flag);
             break;
         }
-        pthread_mutex_lock(tcp_data->lock_finished_flag);
-        if (*tcp_data->finished_flag) {
-            pthread_mutex_unlock(tcp_data->lock_finished_flag);
-            break;
-        }
-        pthread_mutex_unlock(tcp_data->lock_finished_flag);
+        pthread_mutex_unlock(&data->lock_finished_flag);
 
-        if (recv(client_sock, buffer, 1, MSG_PEEK | MSG_DONTWAIT) == 0) {
-            pthread_mutex_lock(lock_game_model);
-            set_player_dead(tcp_data->game_id, tcp_data->id);
-            pthread_mutex_unlock(lock_game_model);
-            break;
+        int nb_received = recv_client_datagrams(data->server->sock_udp, data->batch, datagrams);
+        for (int i = 0; i < nb_received; i++) {
+            if (datagrams[i].token == data->token) { // The other ones are left by a previous game of the socket
+                dispatch_client_datagram(data, &datagrams[i], data->server->sock_udp);
+            }
         }
+    }
 
-        FD_ZERO(&read_fds);
-        FD_SET(client_sock, &read_fds);
+    release_game_data(data);
+    return NULL;
+}
 
-        tv.tv_sec = 1;
-        tv.tv_usec = 0;
+/** Receives the datagrams of all the games on a shared ingress socket and routes them by their session token */
+void *receive_shared_ingress(void *arg) {
+    int sock = *(int *)arg;
+    recv_batch *batch = create_recv_batch();
+    RETURN_NULL_IF_NULL(batch);
 
-        retval = select(client_sock + 1, &read_fds, NULL, NULL, &tv);
+    client_datagram datagrams[RECV_BATCH_SIZE];
+    while (!atomic_load(&ingress_stopped)) {
+        int nb_received = recv_client_datagrams(sock, batch, datagrams);
 
-        if (retval == -1) {
-            perror("select");
-            break;
-        } else if (retval > 0) {
-            if (FD_ISSET(client_sock, &read_fds)) {
-                chat_message *msg = recv_chat_message_of_client(tcp_data->server, tcp_data->id);
-
-                if (msg != NULL) {
-                    // Check if sending a message to the client is possible
-                    if (send(client_sock, buffer, 0, MSG_NOSIGNAL) < 0) {
-                        pthread_mutex_lock(lock_game_model);
-                        set_player_dead(tcp_data->game_id, tcp_data->id);
-                        pthread_mutex_unlock(lock_game_model);
-                        break;
-                    }
-
-                    handle_chat_message(tcp_data->server, tcp_data->id, msg);
-                    free(msg->message);
-                    free(msg);
-                } else {
-                    pthread_mutex_lock(lock_game_model);
-                    set_player_dead(tcp_data->game_id, tcp_data->id);
-                    pthread_mutex_unlock(lock_game_model);
-                    break;
-                }
+        pthread_rwlock_rdlock(&lock_sessions);
+        for (int i = 0; i < nb_received; i++) {
+            udp_thread_data *data = sessions[datagrams[i].token % MAX_SESSIONS];
+            if (data == NULL || data->token != datagrams[i].token) {
+                continue; // Game over, or forged token
             }
+            pthread_mutex_lock(&data->lock_ingress);
+            dispatch_client_datagram(data, &datagrams[i], sock);
+            pthread_mutex_unlock(&data->lock_ingress);
         }
+        pthread_rwlock_unlock(&lock_sessions);
     }
 
-    pthread_mutex_lock(tcp_data->lock_nb_players_left);
-    if (*tcp_data->nb_players_left == PLAYER_NUM - 1) {
+    free_recv_batch(batch);
+    return NULL;
+}
 
-        handle_game_over(tcp_data->server, tcp_data->game_id);
+/** Binds the shared ingress sockets on the same random port and starts their threads, if the ingress is shared */
+int start_shared_ingress() {
+    atomic_init(&ingress_stopped, false);
+    nb_ingress_threads = 0;
+    for (unsigned i = 0; i < nb_ingress_sockets; i++) {
+        ingress_socks[i] = -1;
+    }
 
-        // Last player left
-        if (tcp_data->nb_players_left != NULL) {
-            free(tcp_data->nb_players_left);
-            tcp_data->nb_players_left = NULL;
-        }
+    struct sockaddr_in6 adrsock;
+    memset(&adrsock, 0, sizeof(adrsock));
+    adrsock.sin6_family = AF_INET6;
+    adrsock.sin6_addr = in6addr_any;
 
-        if (tcp_data->lock_waiting_all_players_join != NULL) {
-            pthread_mutex_unlock(tcp_data->lock_waiting_all_players_join);
-            pthread_mutex_destroy(tcp_data->lock_waiting_all_players_join);
-            free(tcp_data->lock_waiting_all_players_join);
-            tcp_data->lock_waiting_all_players_join = NULL;
+    int option = 1;
+    for (unsigned i = 0; i < nb_ingress_sockets; i++) {
+        RETURN_FAILURE_IF_ERROR(init_socket(&ingress_socks[i], false));
+        if (setsockopt(ingress_socks[i], SOL_SOCKET, SO_REUSEPORT, &option, sizeof(option)) < 0) {
+            perror("setsockopt reuseport ingress");
+            return EXIT_FAILURE;
         }
 
-        if (tcp_data->lock_all_players_ready != NULL) {
-            pthread_mutex_unlock(tcp_data->lock_all_players_ready);
-            pthread_mutex_destroy(tcp_data->lock_all_players_ready);
-            free(tcp_data->lock_all_players_ready);
-            tcp_data->lock_all_players_ready = NULL;
+        if (i == 0) {
+            int port = try_to_bind_random_port_on_socket(ingress_socks[i]);
+            RETURN_FAILURE_IF_ERROR(port);
+            ingress_port = port;
+        } else if (try_to_bind_port_on_socket(ingress_socks[i], adrsock, ingress_port) != EXIT_SUCCESS) {
+            return EXIT_FAILURE;
         }
 
-        if (tcp_data->lock_waiting_the_game_finish != NULL) {
-            pthread_mutex_unlock(tcp_data->lock_waiting_the_game_finish);
-            pthread_mutex_destroy(tcp_data->lock_waiting_the_game_finish);
-            free(tcp_data->lock_waiting_the_game_finish);
-            tcp_data->lock_waiting_the_game_finish = NULL;
+        if (pthread_create(&ingress_threads[i], NULL, receive_shared_ingress, &ingress_socks[i]) != 0) {
+            perror("pthread_create ingress");
+            return EXIT_FAILURE;
         }
+        nb_ingress_threads++;
+    }
+    return EXIT_SUCCESS;
+}
 
-        if (tcp_data->lock_nb_players_left != NULL) {
-            pthread_mutex_unlock(tcp_data->lock_nb_players_left);
-            pthread_mutex_destroy(tcp_data->lock_nb_players_left);
-            free(tcp_data->lock_nb_players_left);
-            tcp_data->lock_nb_players_left = NULL;
-        }
+/** Also releases the ingress partially started by a failed start_shared_ingress */
+void stop_shared_ingress() {
+    atomic_store(&ingress_stopped, true);
+    for (unsigned i = 0; i < nb_ingress_threads; i++) {
+        shutdown(ingress_socks[i], SHUT_RD); // Unblocks its thread
+    }
+    for (unsigned i = 0; i < nb_ingress_threads; i++) {
+        pthread_join(ingress_threads[i], NULL);
+    }
+    for (unsigned i = 0; i < nb_ingress_sockets; i++) {
+        close_socket(ingress_socks[i]);
+        ingress_socks[i] = -1;
+    }
+    nb_ingress_threads = 0;
+}
 
-        // Close all sockets
-        for (int i = 0; i < PLAYER_NUM; i++) {
-            close_socket_client(tcp_data->server, i);
+void send_game_snapshot(udp_thread_data *data) {
+    board *game_board = get_game_board(data->game_id);
+    RETURN_IF_NULL(game_board);
+
+    send_game_board_for_clients(data, data->next_update_num, game_board);
+    free_board(game_board);
+}
+
+/** Sends the whole regions listed, or all the regions if regions is NULL, each one to its receivers */
+void send_region_keyframes(udp_thread_data *data, const int *regions, unsigned nb_regions) {
+    board *game_board = get_game_board(data->game_id);
+    RETURN_IF_NULL(game_board);
+
+    if (regions == NULL) {
+        nb_regions = get_region_count(&data->tick.regions);
+    }
+    for (unsigned i = 0; i < nb_regions; i++) {
+        int region = regions == NULL ? (int)i : regions[i];
+        game_destination dest = get_region_destination(data, region);
+        send_game_region(game_egress, &dest, data->tick.region_nums[region], game_board, region);
+    }
+    free_board(game_board);
+}
+
+/** Sends the whole board, or all its regions if it is sent by regions */
+void send_keyframes(udp_thread_data *data) {
+    if (data->tick.by_regions) {
+        send_region_keyframes(data, NULL, 0);
+    } else {
+        send_game_snapshot(data);
+    }
+}
+
+/** Ends the game from its tick task, the reception thread, if any, is unblocked and exits by itself */
+void end_game(udp_thread_data *data) {
+    finish_lobby(data->lobby);
+
+    pthread_mutex_lock(&data->lock_finished_flag);
+    data->finished_flag = true;
+    pthread_mutex_unlock(&data->lock_finished_flag);
+
+    if (data->batch != NULL) {
+        wake_up_game_reception(data->server);
+    }
+    // The last datagrams may be sent on the socket of the game, which is recycled with the game
+    flush_egress_queue(game_egress);
+    release_game_data(data);
+}
+
+/** Applies the actions received since the last tick and sends the differences
+ * Returns true if a whole game board has been sent instead
+ */
+bool update_game_and_send_diffs(udp_thread_data *data) {
+    int nb_fragments = prepare_game_update(data->game_id, &data->game_actions, data->last_num_received_messages,
+                                           data->next_update_num, &data->tick);
+    if (nb_fragments == UPDATE_AS_KEYFRAME) {
+        // The whole board carries the number of the update, which is not used
+        send_keyframes(data);
+        return true;
+    }
+    if (data->tick.by_regions) {
+        for (int i = 0; i < nb_fragments; i++) {
+            region_datagram *datagram = &data->tick.region_datagrams[i];
+            game_destination dest = get_region_destination(data, datagram->region);
+            send_game_update(game_egress, &dest, data->tick.region_updates + datagram->offset, datagram->size);
         }
+        send_region_keyframes(data, data->tick.keyframe_regions, data->tick.nb_keyframe_regions);
+        return false;
+    }
+    if (nb_fragments <= 0) {
+        return false;
+    }
 
-        close_socket_udp(tcp_data->server);
-        close_socket_mult(tcp_data->server);
+    // Send the differences, a datagram per fragment
+    for (int i = 0; i < nb_fragments; i++) {
+        send_game_update_for_clients(data, data->tick.fragments[i], data->tick.fragment_sizes[i]);
+    }
 
-        unlock_mutex_for_everyone(tcp_data->lock_all_tcp_threads_closed, tcp_data->cond_lock_all_tcp_threads_closed);
+    // Prepare new message, the number wraps around with the 16 bits of the field
+    data->next_update_num++;
+    return false;
+}
 
+/** Sends a whole game board when its period is over, or soon after a client asks for one
+ * The period goes back to the minimum when a client asks for a board and doubles while no client does
+ * The boards sent by regions send all their regions instead, and the whole board only to the clients without one
+ */
+void send_keyframe_if_due(udp_thread_data *data, unsigned long tick) {
+    long elapsed = tick - data->last_keyframe_tick;
+    unsigned board_requests = atomic_load(&data->keyframe_requests);
+    unsigned region_requests = atomic_load(&data->region_keyframe_requests);
+    unsigned requests = board_requests + region_requests;
+    if (elapsed < data->keyframe_ticks && (requests == 0 || elapsed < KEYFRAME_REQUEST_GAP_TICKS)) {
         return;
-    } else {
-        (*tcp_data->nb_players_left)++;
-    }
-    pthread_mutex_unlock(tcp_data->lock_nb_players_left);
-}
-
-void *serve_client_tcp(void *arg_tcp_thread_data) {
-    tcp_thread_data *tcp_data = (tcp_thread_data *)arg_tcp_thread_data;
-    pthread_mutex_lock(tcp_data->lock_waiting_all_players_join);
-    *(tcp_data->connected_players) += 1;
-    bool is_everyone_connected = *tcp_data->connected_players == PLAYER_NUM;
-    wait_all_clients_connected(tcp_data->lock_waiting_all_players_join, tcp_data->cond_lock_waiting_all_players_join,
-                               is_everyone_connected, tcp_data->connected_players);
-    send_connexion_information_of_client(tcp_data->server, tcp_data->id, tcp_data->eq);
-
-    // TODO verify ready_informations
-    struct pollfd p[1];
-    p[0].fd = tcp_data->server->sock_clients[tcp_data->id];
-    p[0].events = POLL_IN;
-    int timeout_ml = 60000;
-
-    int res = poll(p, 1, timeout_ml); // if -1
-    if (res <= 0 || !(p[0].revents & POLL_IN)) {
-        pthread_mutex_lock(lock_game_model);
-        set_player_dead(tcp_data->game_id, tcp_data->id);
-        pthread_mutex_unlock(lock_game_model);
-        shutdown(tcp_data->server->sock_clients[tcp_data->id], SHUT_RD);
-        close(tcp_data->server->sock_clients[tcp_data->id]);
-        tcp_data->server->sock_clients[tcp_data->id] = -1;
-    } else {
-        ready_connection_header *ready_informations =
-            recv_ready_connexion_header_of_client(tcp_data->server->sock_clients[tcp_data->id]);
-        free(ready_informations);
     }
-    pthread_mutex_lock(tcp_data->lock_all_players_ready);
-    *(tcp_data->ready_player_number) += 1;
-    bool is_ready = *tcp_data->ready_player_number == PLAYER_NUM;
-    wait_all_clients_not_ready(tcp_data->server, tcp_data->finished_flag, tcp_data->lock_finished_flag,
-                               tcp_data->lock_all_tcp_threads_closed, tcp_data->cond_lock_all_tcp_threads_closed,
-                               tcp_data->lock_all_players_ready, tcp_data->cond_lock_all_players_ready, is_ready,
-                               tcp_data->ready_player_number, tcp_data->game_id);
 
-    handle_tcp_communication(tcp_data);
+    if (requests > 0) {
+        atomic_fetch_sub(&data->keyframe_requests, board_requests);
+        atomic_fetch_sub(&data->region_keyframe_requests, region_requests);
+        data->keyframe_ticks = KEYFRAME_MIN_TICKS;
+    } else if (data->keyframe_ticks * 2 <= KEYFRAME_MAX_TICKS) {
+        data->keyframe_ticks *= 2;
+    } else {
+        data->keyframe_ticks = KEYFRAME_MAX_TICKS;
+    }
 
-    free(tcp_data);
+    data->last_keyframe_tick = tick;
+    if (data->tick.by_regions && board_requests > 0) {
+        send_game_snapshot(data);
+    }
+    send_keyframes(data);
+}
 
-    sleep(3); // Just in case
+/** Takes the addresses of the players given by the reception since the last tick, in unicast, and the regions
+ * around the players if the board is sent by regions
+ * The bound of each player only counts the datagrams queued during the tick
+ */
+void prepare_receivers(udp_thread_data *data) {
+    data->nb_game_receivers = 0;
+    pthread_mutex_lock(&data->lock_client_addrs);
+    for (unsigned i = 0; i < PLAYER_NUM; i++) {
+        if (data->client_socks[i] == -1) {
+            continue; // No datagram from the player yet
+        }
+        data->receivers[i].addr = data->client_addrs[i];
+        data->receivers[i].sock = data->client_socks[i];
+        data->receivers[i].queued = 0;
+        data->game_receivers[data->nb_game_receivers] = &data->receivers[i];
+        data->nb_game_receivers++;
+    }
+    pthread_mutex_unlock(&data->lock_client_addrs);
 
-    return NULL;
+    coord positions[PLAYER_NUM];
+    if (!data->tick.by_regions || get_player_positions(data->game_id, positions) != EXIT_SUCCESS) {
+        return;
+    }
+    for (unsigned i = 0; i < PLAYER_NUM; i++) {
+        data->nb_receiver_regions[i] =
+            get_regions_around(&data->tick.regions, positions[i].x, positions[i].y, data->receiver_regions[i]);
+    }
 }
 
-int connect_one_player_to_game(int sock) {
-    initial_connection_header *head = recv_initial_connection_header_of_client(sock);
+/** Tick task of a game, the differences are sent at each tick and the whole board from time to time */
+bool game_tick(void *arg_udp_thread_data, unsigned long tick) {
+    udp_thread_data *data = (udp_thread_data *)arg_udp_thread_data;
 
-    // TODO: refactor
-    if (head->game_mode == SOLO) {
-        if (connected_solo_players == 0) {
-            int game_id = init_game_model(SOLO);
-            if (game_id == -1) {
-                return EXIT_FAILURE;
-            }
-            solo_waiting_server = init_server_network(connection_port);
-            RETURN_FAILURE_IF_NULL(solo_waiting_server);
-            init_tcp_threads_data(solo_waiting_server, SOLO, game_id);
-        }
-        solo_waiting_server->sock_clients[connected_solo_players] = sock;
-        solo_tcp_threads_data_players[connected_solo_players]->id = connected_solo_players;
-        *(solo_tcp_threads_data_players[connected_solo_players]->connected_players) = connected_solo_players;
-        connected_solo_players++;
-
-        pthread_t t;
-        if (pthread_create(&t, NULL, serve_client_tcp, solo_tcp_threads_data_players[connected_solo_players - 1]) < 0) {
-            perror("thread creation");
-            return EXIT_FAILURE;
+    if (transport == UNICAST_TRANSPORT) {
+        prepare_receivers(data);
+    }
+
+    if (data->last_keyframe_tick == -1) {
+        send_game_snapshot(data); // The initial game board, with the number of the first update
+        data->last_keyframe_tick = tick;
+    }
+
+    if (update_game_and_send_diffs(data)) {
+        data->last_keyframe_tick = tick;
+    }
+
+    if (is_game_over(data->game_id)) {
+        send_keyframes(data);
+        end_game(data);
+        return false;
+    }
+
+    send_keyframe_if_due(data, tick);
+    return true;
+}
+
+/** Takes the host of the TCP connection of each player, the only one from which its endpoint can be pinned
+ * The lobby has to be locked
+ */
+void init_client_hosts(udp_thread_data *data, lobby *l) {
+    for (unsigned i = 0; i < PLAYER_NUM; i++) {
+        data->has_client_host[i] = false;
+        if (l->players[i] == NULL) {
+            continue;
         }
+        struct sockaddr_in6 peer;
+        socklen_t peer_len = sizeof(peer);
+        if (getpeername(l->players[i]->sock, (struct sockaddr *)&peer, &peer_len) < 0) {
+            perror("getpeername");
+            continue;
+        }
+        data->client_hosts[i] = peer.sin6_addr;
+        data->has_client_host[i] = true;
+    }
+}
 
-    } else if (head->game_mode == TEAM) {
-        if (connected_team_players == 0) {
-            int game_id = init_game_model(TEAM);
-            if (game_id == -1) {
-                return EXIT_FAILURE;
-            }
-            team_waiting_server = init_server_network(connection_port);
-            RETURN_FAILURE_IF_NULL(team_waiting_server);
-            if (game_id == 0 || game_id == 3) { // 0 and 3 are in the same team
-                init_tcp_threads_data(team_waiting_server, TEAM, 0);
-            } else {
-                init_tcp_threads_data(team_waiting_server, TEAM, 1);
-            }
+/** Starts the reception thread of the game, or registers it to the shared ingress, and schedules its ticks
+ * The lobby has to be locked
+ */
+int init_game_threads(lobby *l) {
+    udp_thread_data *udp_thread_data_game = malloc(sizeof(udp_thread_data));
+    RETURN_FAILURE_IF_NULL(udp_thread_data_game);
+    bool is_shared = nb_ingress_sockets > 0;
+    udp_thread_data_game->finished_flag = false;
+    udp_thread_data_game->references = is_shared ? 1 : 2;
+    udp_thread_data_game->game_id = l->game_id;
+    udp_thread_data_game->mode = l->mode;
+    udp_thread_data_game->token = l->token;
+    udp_thread_data_game->lobby = l;
+    init_action_ring(&udp_thread_data_game->game_actions);
+    udp_thread_data_game->server = l->server;
+    for (unsigned i = 0; i < PLAYER_NUM; i++) {
+        udp_thread_data_game->last_num_received_messages[i] = LIMIT_LAST_NUM_MESSAGE_CLIENT - 1;
+    }
+    atomic_init(&udp_thread_data_game->keyframe_requests, 0);
+    atomic_init(&udp_thread_data_game->region_keyframe_requests, 0);
+    udp_thread_data_game->region_addrs = NULL;
+    for (unsigned i = 0; i < PLAYER_NUM; i++) {
+        udp_thread_data_game->client_socks[i] = -1;
+        udp_thread_data_game->receivers[i].dropped = 0;
+        udp_thread_data_game->nb_receiver_regions[i] = 0;
+    }
+    init_client_hosts(udp_thread_data_game, l);
+    udp_thread_data_game->nb_game_receivers = 0;
+    udp_thread_data_game->next_update_num = 0; // The number of the initial game board
+    udp_thread_data_game->last_keyframe_tick = -1;
+    udp_thread_data_game->keyframe_ticks = KEYFRAME_MIN_TICKS;
+    udp_thread_data_game->batch = NULL;
+    if (!is_shared) {
+        udp_thread_data_game->batch = create_recv_batch();
+        if (udp_thread_data_game->batch == NULL) {
+            goto EXIT_FREEING_DATA;
         }
-        team_waiting_server->sock_clients[connected_team_players] = sock;
-        team_tcp_threads_data_players[connected_team_players]->id = connected_team_players;
+    }
 
-        if (connected_team_players == 0 || connected_team_players == 3) {
-            team_tcp_threads_data_players[connected_team_players]->eq = 0;
-        } else {
-            team_tcp_threads_data_players[connected_team_players]->eq = 1;
+    dimension dim;
+    if (get_game_dimension(l->game_id, &dim) != EXIT_SUCCESS) {
+        goto EXIT_FREEING_DATA;
+    }
+    init_tick_buffers(&udp_thread_data_game->tick, dim);
+    udp_thread_data_game->max_queued = MAX_QUEUED_BOARDS * GAME_BOARD_SIZE(dim.height, dim.width);
+    if (udp_thread_data_game->tick.by_regions && transport == MULTICAST_TRANSPORT) {
+        udp_thread_data_game->region_addrs = create_region_addrs(l->server, &udp_thread_data_game->tick.regions);
+        if (udp_thread_data_game->region_addrs == NULL) {
+            goto EXIT_FREEING_DATA;
         }
+    }
 
-        *(team_tcp_threads_data_players[connected_team_players]->connected_players) = connected_team_players;
-        connected_team_players++;
+    if (pthread_mutex_init(&udp_thread_data_game->lock_finished_flag, NULL) != 0) {
+        goto EXIT_FREEING_DATA;
+    }
+    if (pthread_mutex_init(&udp_thread_data_game->lock_ingress, NULL) != 0) {
+        pthread_mutex_destroy(&udp_thread_data_game->lock_finished_flag);
+        goto EXIT_FREEING_DATA;
+    }
+    if (pthread_mutex_init(&udp_thread_data_game->lock_client_addrs, NULL) != 0) {
+        pthread_mutex_destroy(&udp_thread_data_game->lock_ingress);
+        pthread_mutex_destroy(&udp_thread_data_game->lock_finished_flag);
+        goto EXIT_FREEING_DATA;
+    }
 
-        pthread_t t;
-        if (pthread_create(&t, NULL, serve_client_tcp, team_tcp_threads_data_players[connected_team_players - 1]) < 0) {
-            perror("thread creation");
-            return EXIT_FAILURE;
+    if (is_shared) {
+        register_session(udp_thread_data_game);
+        if (schedule_tick_task(game_scheduler, game_tick, udp_thread_data_game) != EXIT_SUCCESS) {
+            unregister_session(udp_thread_data_game);
+            pthread_mutex_destroy(&udp_thread_data_game->lock_client_addrs);
+            pthread_mutex_destroy(&udp_thread_data_game->lock_ingress);
+            pthread_mutex_destroy(&udp_thread_data_game->lock_finished_flag);
+            goto EXIT_FREEING_DATA;
         }
+        return EXIT_SUCCESS;
     }
-    free(head);
 
-    connected_solo_players %= PLAYER_NUM;
-    connected_team_players %= PLAYER_NUM;
+    pthread_t recv_thread;
+    if (pthread_create(&recv_thread, NULL, serv_client_recv_game_action, udp_thread_data_game) != 0) {
+        pthread_mutex_destroy(&udp_thread_data_game->lock_client_addrs);
+        pthread_mutex_destroy(&udp_thread_data_game->lock_ingress);
+        pthread_mutex_destroy(&udp_thread_data_game->lock_finished_flag);
+        goto EXIT_FREEING_DATA;
+    }
+    pthread_detach(recv_thread);
+
+    if (schedule_tick_task(game_scheduler, game_tick, udp_thread_data_game) != EXIT_SUCCESS) {
+        // The reception thread is left as the last reference, it frees the game (and releases the lobby) on exit
+        pthread_mutex_lock(&udp_thread_data_game->lock_finished_flag);
+        udp_thread_data_game->finished_flag = true;
+        udp_thread_data_game->references--;
+        pthread_mutex_unlock(&udp_thread_data_game->lock_finished_flag);
+        wake_up_game_reception(udp_thread_data_game->server);
+        return EXIT_FAILURE;
+    }
 
     return EXIT_SUCCESS;
+
+EXIT_FREEING_DATA:
+    free_recv_batch(udp_thread_data_game->batch);
+    free(udp_thread_data_game->region_addrs);
+    free(udp_thread_data_game);
+    return EXIT_FAILURE;
+}
+
+/** Accepts a pending connection, its socket is non-blocking
+ * Returns -1 if no connection is pending or in case of error
+ */
+int try_to_init_socket_of_client() {
+    struct sockaddr_in6 client_addr;
+    int client_addr_len = sizeof(client_addr);
+    int res = accept4(sock_tcp, (struct sockaddr *)&client_addr, (socklen_t *)&client_addr_len, SOCK_NONBLOCK);
+    if (res < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            perror("client acceptance");
+        }
+        return -1;
+    }
+
+    print_ip_of_client(client_addr);
+    return res;
 }
 
+/** Accepts the players and dispatches their connections between the reactors, which handle the rest of the
+ * communication
+ */
 int connect_players_to_game() {
-    listen_players();
+    RETURN_FAILURE_IF_ERROR(listen_players());
     printf("Waiting players on %u port.\n", get_port_tcp());
 
-    struct pollfd *polls = init_polls_connexion(sock_tcp);
-    unsigned nbfds = 1;
-    unsigned s = INITIAL_POLL_FD_SIZE;
-
+    unsigned next_reactor = 0;
     while (1) {
-        poll(polls, nbfds, -1);
-
-        for (unsigned i = 1; i < nbfds; i++) {
-            if (polls[i].revents & POLL_IN) {
-                connect_one_player_to_game(polls[i].fd);
-                remove_polls_to_poll(polls, &nbfds, i);
-            }
-            if (polls[i].revents & POLL_HUP) {
-                close(polls[i].fd);
-                remove_polls_to_poll(polls, &nbfds, i);
+        struct pollfd p = {.fd = sock_tcp, .events = POLLIN};
+        if (poll(&p, 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
             }
+            perror("poll sock_tcp");
+            return EXIT_FAILURE;
         }
-        if (polls[0].revents & POLL_IN) {
-            int sock = try_to_init_socket_of_client();
-            add_polls_to_poll(polls, &nbfds, &s, sock);
+
+        // Every pending connection is accepted, the handshake is left to the reactors
+        int sock;
+        while ((sock = try_to_init_socket_of_client()) >= 0) {
+            if (add_connection_to_reactor(sock, &reactor_contexts[next_reactor]) != EXIT_SUCCESS) {
+                close(sock);
+                continue;
+            }
+            next_reactor = (next_reactor + 1) % NB_REACTORS;
         }
     }
 
-    printf("All players are connected.\n");
     return EXIT_SUCCESS;
 }
 
+void flush_game_egress(void *egress) {
+    flush_egress_queue((egress_queue *)egress);
+}
+
 int game_loop_server() {
-    int return_value;
+    int return_value = EXIT_SUCCESS;
+
+    signal(SIGPIPE, SIG_IGN); // A client leaving must not stop the server
+
+    if (init_socket(&sock_egress, false) != EXIT_SUCCESS) {
+        return_value = EXIT_FAILURE;
+        goto exit_closing_sockets_and_free_addr_mult;
+    }
+    game_egress = create_egress_queue(sock_egress, true);
+    if (game_egress == NULL) {
+        return_value = EXIT_FAILURE;
+        goto exit_closing_sockets_and_free_addr_mult;
+    }
 
-    lock_game_model = malloc(sizeof(pthread_mutex_t));
-    RETURN_FAILURE_IF_NULL(lock_game_model);
-    if (pthread_mutex_init(lock_game_model, NULL) < 0) {
+    game_scheduler = create_tick_scheduler(TICK_PERIOD);
+    if (game_scheduler == NULL) {
+        return_value = EXIT_FAILURE;
         goto exit_closing_sockets_and_free_addr_mult;
     }
+    set_tick_end_callback(game_scheduler, flush_game_egress, game_egress);
+    if (start_tick_scheduler(game_scheduler) != EXIT_SUCCESS) {
+        return_value = EXIT_FAILURE;
+        goto exit_freeing_scheduler;
+    }
+
+    if (init_reactors() != EXIT_SUCCESS) {
+        return_value = EXIT_FAILURE;
+        goto exit_freeing_reactors;
+    }
+    if (start_shared_ingress() != EXIT_SUCCESS) {
+        return_value = EXIT_FAILURE;
+        goto exit_stopping_ingress;
+    }
+    if (start_provisioning() != EXIT_SUCCESS) {
+        return_value = EXIT_FAILURE;
+        goto exit_stopping_ingress;
+    }
 
     if (connect_players_to_game() != EXIT_SUCCESS) {
         return_value = EXIT_FAILURE;
-        goto exit_closing_sockets_and_free_addr_mult;
     }
-    sleep(1); // Wait all clients for the join mutex
-    goto exit_closing_sockets_and_free_addr_mult;
+    stop_provisioning();
+    free_endpoint_pool();
+
+exit_stopping_ingress:
+    stop_shared_ingress();
+
+exit_freeing_reactors:
+    free_reactors();
+
+exit_freeing_scheduler:
+    free_tick_scheduler(game_scheduler);
 
 exit_closing_sockets_and_free_addr_mult:
+    free_egress_queue(game_egress);
+    close_socket(sock_egress);
     close_socket_tcp();
-    free(lock_game_model);
     return return_value;
 }
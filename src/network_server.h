@@ -3,13 +3,15 @@
 
 #include "communication_server.h"
 
+#include <stdbool.h>
+
 #define MIN_PORT 1024
 #define MAX_PORT 49151
+#define MAX_INGRESS_SOCKETS 64
 
 /** Parameter for a server managing a single game */
 typedef struct server_information {
-    int sock_udp;
-    int sock_mult;
+    int sock_udp; // -1 with the shared ingress
 
     int sock_clients[PLAYER_NUM]; // socket TCP to send game informations
 
@@ -20,8 +22,28 @@ typedef struct server_information {
     struct sockaddr_in6 *addr_mult;
 } server_information;
 
-int init_socket_tcp();
-void init_state(uint16_t connexion_port);
+/** Binds the TCP socket of the connections on connexion_port, or on a random port if it is not a valid port
+ * A shared socket is bound with SO_REUSEPORT, so that the workers accept the players on the same port
+ */
+int init_socket_tcp(uint16_t connexion_port, bool shared);
+uint16_t get_port_tcp();
+void close_socket_tcp();
+
+/** Sets the dimension of the games created from now on, GAMEBOARD_WIDTH x GAMEBOARD_HEIGHT by default
+ */
+void set_game_dimension(dimension dim);
+
+/** Receives the actions of all the games on nb_sockets UDP sockets sharing a port, up to MAX_INGRESS_SOCKETS,
+ * instead of a socket and a thread per game: the datagrams are routed to their game by their session token
+ */
+void set_shared_ingress(unsigned nb_sockets);
+
+/** Chooses how the game messages reach the clients, MULTICAST_TRANSPORT by default, before game_loop_server
+ * In unicast, they go to the address each client sends its datagrams from, the clients learn the transport with the
+ * informations of their game
+ */
+void set_game_transport(game_transport game_transport);
+void init_state();
 int game_loop_server();
 
 #endif // SRC_NETWORK_SERVER_H__H_
@@ -0,0 +1,166 @@
+#include "reactor.h"
+#include "utils.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+reactor *create_reactor() {
+    reactor *r = malloc(sizeof(reactor));
+    RETURN_NULL_IF_NULL_PERROR(r, "malloc reactor");
+
+    r->epoll_fd = epoll_create1(0);
+    if (r->epoll_fd < 0) {
+        perror("epoll_create1");
+        free(r);
+        return NULL;
+    }
+
+    r->wakeup_fd = eventfd(0, EFD_NONBLOCK);
+    if (r->wakeup_fd < 0) {
+        perror("eventfd reactor");
+        close(r->epoll_fd);
+        free(r);
+        return NULL;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL; // The wakeup fd is the only one without handler
+    if (epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, r->wakeup_fd, &ev) < 0) {
+        perror("epoll_ctl wakeup_fd");
+        close(r->wakeup_fd);
+        close(r->epoll_fd);
+        free(r);
+        return NULL;
+    }
+
+    atomic_init(&r->stopped, false);
+    r->started = false;
+    r->timer_period_ms = -1;
+    r->timer_callback = NULL;
+    r->timer_data = NULL;
+    r->removed_handlers = NULL;
+
+    return r;
+}
+
+reactor_handler *reactor_add(reactor *r, int fd, uint32_t events, reactor_callback callback, void *data) {
+    reactor_handler *handler = malloc(sizeof(reactor_handler));
+    RETURN_NULL_IF_NULL_PERROR(handler, "malloc reactor_handler");
+
+    handler->fd = fd;
+    handler->callback = callback;
+    handler->data = data;
+    handler->next_removed = NULL;
+
+    struct epoll_event ev;
+    ev.events = events | EPOLLET;
+    ev.data.ptr = handler;
+    if (epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        perror("epoll_ctl add");
+        free(handler);
+        return NULL;
+    }
+
+    return handler;
+}
+
+void reactor_remove(reactor *r, reactor_handler *handler) {
+    RETURN_IF_NULL(handler);
+
+    epoll_ctl(r->epoll_fd, EPOLL_CTL_DEL, handler->fd, NULL);
+
+    // Other events of the current batch may still point to the handler
+    handler->callback = NULL;
+    handler->next_removed = r->removed_handlers;
+    r->removed_handlers = handler;
+}
+
+static void free_removed_handlers(reactor *r) {
+    while (r->removed_handlers != NULL) {
+        reactor_handler *next = r->removed_handlers->next_removed;
+        free(r->removed_handlers);
+        r->removed_handlers = next;
+    }
+}
+
+static int get_timeout_ms(reactor *r, long next_timer_ms) {
+    if (r->timer_callback == NULL) {
+        return -1;
+    }
+    long remaining = next_timer_ms - get_time_ms();
+    return remaining > 0 ? remaining : 0;
+}
+
+static void *run_reactor(void *arg) {
+    reactor *r = (reactor *)arg;
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    long next_timer_ms = get_time_ms() + r->timer_period_ms;
+
+    while (!atomic_load(&r->stopped)) {
+        int nb = epoll_wait(r->epoll_fd, events, REACTOR_MAX_EVENTS, get_timeout_ms(r, next_timer_ms));
+        if (nb < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < nb; i++) {
+            reactor_handler *handler = events[i].data.ptr;
+            if (handler == NULL) {
+                uint64_t value;
+                while (read(r->wakeup_fd, &value, sizeof(value)) > 0) {
+                }
+                continue;
+            }
+            if (handler->callback != NULL) {
+                handler->callback(handler->fd, events[i].events, handler->data);
+            }
+        }
+        free_removed_handlers(r);
+
+        if (r->timer_callback != NULL && get_time_ms() >= next_timer_ms) {
+            r->timer_callback(r->timer_data);
+            free_removed_handlers(r);
+            next_timer_ms = get_time_ms() + r->timer_period_ms;
+        }
+    }
+
+    return NULL;
+}
+
+int start_reactor(reactor *r, int timer_period_ms, reactor_timer_callback timer_callback, void *timer_data) {
+    r->timer_period_ms = timer_period_ms;
+    r->timer_callback = timer_callback;
+    r->timer_data = timer_data;
+
+    if (pthread_create(&r->thread, NULL, run_reactor, r) != 0) {
+        perror("pthread_create reactor");
+        return EXIT_FAILURE;
+    }
+    r->started = true;
+    return EXIT_SUCCESS;
+}
+
+void free_reactor(reactor *r) {
+    RETURN_IF_NULL(r);
+
+    atomic_store(&r->stopped, true);
+    if (r->started) {
+        uint64_t value = 1;
+        if (write(r->wakeup_fd, &value, sizeof(value)) < 0) {
+            perror("write wakeup_fd");
+        }
+        pthread_join(r->thread, NULL);
+    }
+
+    free_removed_handlers(r);
+    close(r->wakeup_fd);
+    close(r->epoll_fd);
+    free(r);
+}
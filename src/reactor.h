@@ -0,0 +1,60 @@
+#ifndef SRC_REACTOR_H_
+#define SRC_REACTOR_H_
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+
+#define REACTOR_MAX_EVENTS 64
+
+/** Called by the reactor thread when the registered file descriptor is ready */
+typedef void (*reactor_callback)(int fd, uint32_t events, void *data);
+
+/** Called by the reactor thread every period given to start_reactor */
+typedef void (*reactor_timer_callback)(void *data);
+
+typedef struct reactor_handler {
+    int fd;
+    reactor_callback callback;
+    void *data;
+    struct reactor_handler *next_removed;
+} reactor_handler;
+
+/** Epoll event loop running on its own thread */
+typedef struct reactor {
+    int epoll_fd;
+    int wakeup_fd;
+    atomic_bool stopped; // Set by free_reactor from another thread
+    pthread_t thread;
+    bool started; // The thread is only joined if it was started
+
+    int timer_period_ms;
+    reactor_timer_callback timer_callback;
+    void *timer_data;
+
+    reactor_handler *removed_handlers; // Freed at the end of the current batch of events
+} reactor;
+
+reactor *create_reactor();
+
+/** Registers fd in edge-triggered mode for the given events (EPOLLET is added)
+ * Returns the handler to give back to reactor_remove, NULL in case of error
+ */
+reactor_handler *reactor_add(reactor *r, int fd, uint32_t events, reactor_callback callback, void *data);
+
+/** Unregisters the handler, it must be called from the reactor thread (inside a callback)
+ * The fd is not closed
+ */
+void reactor_remove(reactor *r, reactor_handler *handler);
+
+/** Starts the thread of the event loop, timer_callback is called every timer_period_ms
+ */
+int start_reactor(reactor *r, int timer_period_ms, reactor_timer_callback timer_callback, void *timer_data);
+
+/** Stops the event loop, waits for its thread and frees the reactor
+ */
+void free_reactor(reactor *r);
+
+#endif // SRC_REACTOR_H_
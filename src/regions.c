@@ -0,0 +1,45 @@
+#include "regions.h"
+#include "utils.h"
+
+void init_region_grid(region_grid *grid, dimension dim) {
+    grid->dim = dim;
+    grid->columns = (dim.width + REGION_SIDE - 1) / REGION_SIDE;
+    grid->rows = (dim.height + REGION_SIDE - 1) / REGION_SIDE;
+}
+
+int get_region_count(const region_grid *grid) {
+    return grid->columns * grid->rows;
+}
+
+int get_region_of_tile(const region_grid *grid, int x, int y) {
+    return (y / REGION_SIDE) * grid->columns + x / REGION_SIDE;
+}
+
+void get_region_area(const region_grid *grid, int region, coord *origin, dimension *size) {
+    origin->x = (region % grid->columns) * REGION_SIDE;
+    origin->y = (region / grid->columns) * REGION_SIDE;
+    size->width = min(REGION_SIDE, grid->dim.width - origin->x);
+    size->height = min(REGION_SIDE, grid->dim.height - origin->y);
+}
+
+unsigned get_regions_around(const region_grid *grid, int x, int y, int regions[MAX_SUBSCRIBED_REGIONS]) {
+    int column = x / REGION_SIDE;
+    int row = y / REGION_SIDE;
+
+    unsigned nb = 0;
+    for (int r = max(0, row - REGION_RADIUS); r <= min(grid->rows - 1, row + REGION_RADIUS); r++) {
+        for (int c = max(0, column - REGION_RADIUS); c <= min(grid->columns - 1, column + REGION_RADIUS); c++) {
+            regions[nb] = r * grid->columns + c;
+            nb++;
+        }
+    }
+    return nb;
+}
+
+void get_region_group(const uint16_t game_group[8], int region, uint16_t region_group[8]) {
+    for (int i = 0; i < 8; i++) {
+        region_group[i] = game_group[i];
+    }
+    // The groups of the games are random, the ports of the games tell apart the rare collisions
+    region_group[7] = game_group[7] + 1 + region;
+}
@@ -0,0 +1,45 @@
+#ifndef SRC_REGIONS_H_
+#define SRC_REGIONS_H_
+
+#include "constants.h"
+#include "model.h"
+
+#include <stdint.h>
+
+/** The large boards are split in square regions, each one with its own multicast group and sequence of updates,
+ * so that a client only receives the regions around its player
+ */
+#define REGION_SIDE 32 // in tiles, the packed tiles of a whole region fit in a datagram
+#define REGION_TILES (REGION_SIDE * REGION_SIDE)
+#define REGION_RADIUS 1 // Regions subscribed around the one of the player, in each direction
+#define MAX_SUBSCRIBED_REGIONS ((2 * REGION_RADIUS + 1) * (2 * REGION_RADIUS + 1))
+#define MAX_REGIONS                                                                                                    \
+    (((MAX_GAMEBOARD_WIDTH + REGION_SIDE - 1) / REGION_SIDE) * ((MAX_GAMEBOARD_HEIGHT + REGION_SIDE - 1) / REGION_SIDE))
+
+typedef struct region_grid {
+    dimension dim; // Of the board
+    int columns;
+    int rows;
+} region_grid;
+
+void init_region_grid(region_grid *grid, dimension dim);
+
+int get_region_count(const region_grid *grid);
+
+/** Returns the region of the tile (x, y), which has to be on the board
+ */
+int get_region_of_tile(const region_grid *grid, int x, int y);
+
+/** Writes the first tile and the dimension of the region, the regions of the last row and column may be smaller
+ */
+void get_region_area(const region_grid *grid, int region, coord *origin, dimension *size);
+
+/** Writes in regions the regions at most REGION_RADIUS regions away from the one of (x, y), and returns their number
+ */
+unsigned get_regions_around(const region_grid *grid, int x, int y, int regions[MAX_SUBSCRIBED_REGIONS]);
+
+/** Writes in region_group the multicast group of the region, derived from the group of the game
+ */
+void get_region_group(const uint16_t game_group[8], int region, uint16_t region_group[8]);
+
+#endif // SRC_REGIONS_H_
@@ -7,9 +7,15 @@
 
 #include "network_server.h"
 #include "utils.h"
+#include "workers.h"
 
 typedef struct flags {
     char *connexion_port;
+    char *width;
+    char *height;
+    char *workers;
+    char *ingress;
+    char *transport;
 } flags;
 
 static flags *server_flags;
@@ -18,6 +24,11 @@ int init_server_flags() {
     server_flags = malloc(sizeof(flags));
     RETURN_FAILURE_IF_NULL_PERROR(server_flags, "malloc server_flags");
     server_flags->connexion_port = NULL;
+    server_flags->width = NULL;
+    server_flags->height = NULL;
+    server_flags->workers = NULL;
+    server_flags->ingress = NULL;
+    server_flags->transport = NULL;
 
     return EXIT_SUCCESS;
 }
@@ -26,6 +37,16 @@ void parse_client_flags(int argc, char *argv[]) {
     for (int i = 2; i < argc; i++) {
         if (strcmp(argv[i - 1], "-p") == 0) {
             server_flags->connexion_port = argv[i];
+        } else if (strcmp(argv[i - 1], "-W") == 0) {
+            server_flags->width = argv[i];
+        } else if (strcmp(argv[i - 1], "-H") == 0) {
+            server_flags->height = argv[i];
+        } else if (strcmp(argv[i - 1], "-n") == 0) {
+            server_flags->workers = argv[i];
+        } else if (strcmp(argv[i - 1], "-u") == 0) {
+            server_flags->ingress = argv[i];
+        } else if (strcmp(argv[i - 1], "-t") == 0) {
+            server_flags->transport = argv[i];
         }
     }
 }
@@ -45,10 +66,59 @@ int main(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
     }
+
+    dimension dim = {GAMEBOARD_WIDTH, GAMEBOARD_HEIGHT};
+    if (server_flags->width != NULL) {
+        dim.width = parse_unsigned_within_bounds(server_flags->width, MIN_GAMEBOARD_WIDTH, MAX_GAMEBOARD_WIDTH);
+    }
+    if (server_flags->height != NULL) {
+        dim.height = parse_unsigned_within_bounds(server_flags->height, MIN_GAMEBOARD_HEIGHT, MAX_GAMEBOARD_HEIGHT);
+    }
+    if (dim.width < 0 || dim.height < 0) {
+        fprintf(stderr, "The dimension of the game board is not valid.\n");
+        free(server_flags);
+        return EXIT_FAILURE;
+    }
+    set_game_dimension(dim);
+
+    int nb_workers = 0;
+    if (server_flags->workers != NULL) {
+        nb_workers = parse_unsigned_within_bounds(server_flags->workers, 1, MAX_WORKERS);
+        if (nb_workers < 0) {
+            fprintf(stderr, "The number of workers is not valid.\n");
+            free(server_flags);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (server_flags->ingress != NULL) {
+        int nb_ingress = parse_unsigned_within_bounds(server_flags->ingress, 1, MAX_INGRESS_SOCKETS);
+        if (nb_ingress < 0) {
+            fprintf(stderr, "The number of ingress sockets is not valid.\n");
+            free(server_flags);
+            return EXIT_FAILURE;
+        }
+        set_shared_ingress(nb_ingress);
+    }
+
+    if (server_flags->transport != NULL) {
+        if (strcmp(server_flags->transport, "unicast") == 0) {
+            set_game_transport(UNICAST_TRANSPORT);
+        } else if (strcmp(server_flags->transport, "multicast") != 0) {
+            fprintf(stderr, "The transport is not valid, it is either multicast or unicast.\n");
+            free(server_flags);
+            return EXIT_FAILURE;
+        }
+    }
     free(server_flags);
 
-    RETURN_FAILURE_IF_ERROR(init_socket_tcp());
+    if (nb_workers > 0) {
+        RETURN_FAILURE_IF_ERROR(init_socket_tcp(connexion_port, true));
+        return run_workers(nb_workers, get_port_tcp());
+    }
+
+    RETURN_FAILURE_IF_ERROR(init_socket_tcp(connexion_port, false));
 
-    init_state(connexion_port);
+    init_state();
     RETURN_FAILURE_IF_ERROR(game_loop_server());
 }
@@ -0,0 +1,71 @@
+#include "tcp_output.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+void init_tcp_output(tcp_output *out, int sock) {
+    out->sock = sock;
+    out->nb_pending = 0;
+}
+
+/** Sends what the socket takes of the bytes without blocking
+ * Returns the number of bytes sent, -1 if the socket is closed
+ */
+static ssize_t send_available(int sock, const char *bytes, size_t size) {
+    size_t sent = 0;
+    while (sent < size) {
+        ssize_t res = send(sock, bytes + sent, size - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (res < 0 && errno == EINTR) {
+            continue;
+        }
+        if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (res <= 0) {
+            perror("send tcp");
+            return -1;
+        }
+        sent += res;
+    }
+    return sent;
+}
+
+int flush_tcp_output(tcp_output *out) {
+    if (out->nb_pending == 0) {
+        return EXIT_SUCCESS;
+    }
+    ssize_t sent = send_available(out->sock, out->pending, out->nb_pending);
+    if (sent < 0) {
+        return EXIT_FAILURE;
+    }
+    out->nb_pending -= sent;
+    memmove(out->pending, out->pending + sent, out->nb_pending);
+    return EXIT_SUCCESS;
+}
+
+int send_tcp_output(tcp_output *out, const void *message, size_t size) {
+    size_t sent = 0;
+    if (out->nb_pending == 0) { // Otherwise the message goes after the pending bytes
+        ssize_t res = send_available(out->sock, message, size);
+        if (res < 0) {
+            return EXIT_FAILURE;
+        }
+        sent = res;
+    }
+
+    size_t remaining = size - sent;
+    if (remaining > TCP_OUTPUT_SIZE - out->nb_pending) {
+        fprintf(stderr, "send tcp: the client does not receive anything\n");
+        return EXIT_FAILURE;
+    }
+    memcpy(out->pending + out->nb_pending, (const char *)message + sent, remaining);
+    out->nb_pending += remaining;
+    return EXIT_SUCCESS;
+}
+
+bool has_pending_tcp_output(const tcp_output *out) {
+    return out->nb_pending > 0;
+}
@@ -0,0 +1,35 @@
+#ifndef SRC_TCP_OUTPUT_H_
+#define SRC_TCP_OUTPUT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TCP_OUTPUT_SIZE 4096 // Bytes kept for a client whose socket is full, many chat messages
+
+/** Messages to a client on its non-blocking TCP socket
+ * The bytes the socket does not take at once are kept, and sent once it is writable again, so that a slow client
+ * never blocks the thread sending to it
+ * It is not synchronized, its users lock it
+ */
+typedef struct tcp_output {
+    int sock;
+    char pending[TCP_OUTPUT_SIZE];
+    size_t nb_pending;
+} tcp_output;
+
+void init_tcp_output(tcp_output *out, int sock);
+
+/** Sends the message after the pending bytes, the bytes the socket does not take are kept
+ * Returns EXIT_FAILURE if the socket is closed, or if the client is too far behind for the message to be kept, it
+ * has then to be disconnected
+ */
+int send_tcp_output(tcp_output *out, const void *message, size_t size);
+
+/** Sends the pending bytes the socket takes, once it is writable again
+ * Returns EXIT_FAILURE if the socket is closed
+ */
+int flush_tcp_output(tcp_output *out);
+
+bool has_pending_tcp_output(const tcp_output *out);
+
+#endif // SRC_TCP_OUTPUT_H_
@@ -0,0 +1,164 @@
+#include "tick_scheduler.h"
+#include "utils.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NS_PER_SEC 1000000000L
+
+static long timespec_diff_ns(const struct timespec *a, const struct timespec *b) {
+    return (a->tv_sec - b->tv_sec) * NS_PER_SEC + (a->tv_nsec - b->tv_nsec);
+}
+
+static void add_ns(struct timespec *ts, long ns) {
+    ts->tv_sec += ns / NS_PER_SEC;
+    ts->tv_nsec += ns % NS_PER_SEC;
+    if (ts->tv_nsec >= NS_PER_SEC) {
+        ts->tv_sec++;
+        ts->tv_nsec -= NS_PER_SEC;
+    }
+}
+
+tick_scheduler *create_tick_scheduler(long period_ms) {
+    tick_scheduler *scheduler = malloc(sizeof(tick_scheduler));
+    RETURN_NULL_IF_NULL_PERROR(scheduler, "malloc tick_scheduler");
+
+    if (pthread_mutex_init(&scheduler->lock_new_tasks, NULL) != 0) {
+        perror("pthread_mutex_init tick_scheduler");
+        free(scheduler);
+        return NULL;
+    }
+
+    scheduler->period_ns = period_ms * 1000000L;
+    scheduler->ticks = 0;
+    scheduler->overruns = 0;
+    scheduler->tasks = NULL;
+    scheduler->new_tasks = NULL;
+    scheduler->tick_end = NULL;
+    scheduler->tick_end_data = NULL;
+    scheduler->stopped = false;
+    scheduler->started = false;
+
+    return scheduler;
+}
+
+int schedule_tick_task(tick_scheduler *scheduler, tick_callback callback, void *data) {
+    tick_task *task = malloc(sizeof(tick_task));
+    RETURN_FAILURE_IF_NULL_PERROR(task, "malloc tick_task");
+
+    task->callback = callback;
+    task->data = data;
+
+    pthread_mutex_lock(&scheduler->lock_new_tasks);
+    task->next = scheduler->new_tasks;
+    scheduler->new_tasks = task;
+    pthread_mutex_unlock(&scheduler->lock_new_tasks);
+
+    return EXIT_SUCCESS;
+}
+
+static void run_tasks(tick_scheduler *scheduler) {
+    pthread_mutex_lock(&scheduler->lock_new_tasks);
+    while (scheduler->new_tasks != NULL) {
+        tick_task *task = scheduler->new_tasks;
+        scheduler->new_tasks = task->next;
+        task->next = scheduler->tasks;
+        scheduler->tasks = task;
+    }
+    pthread_mutex_unlock(&scheduler->lock_new_tasks);
+
+    tick_task **link = &scheduler->tasks;
+    while (*link != NULL) {
+        tick_task *task = *link;
+        if (task->callback(task->data, scheduler->ticks)) {
+            link = &task->next;
+        } else {
+            *link = task->next;
+            free(task);
+        }
+    }
+
+    if (scheduler->tick_end != NULL) {
+        scheduler->tick_end(scheduler->tick_end_data);
+    }
+}
+
+/** Sets the deadline of the next tick, skipping the ticks which are more than a period late */
+static void advance_deadline(tick_scheduler *scheduler) {
+    scheduler->ticks++;
+    add_ns(&scheduler->next_deadline, scheduler->period_ns);
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long late_ns = timespec_diff_ns(&now, &scheduler->next_deadline);
+    if (late_ns >= scheduler->period_ns) {
+        long skipped = late_ns / scheduler->period_ns;
+        scheduler->ticks += skipped;
+        scheduler->overruns += skipped;
+        add_ns(&scheduler->next_deadline, skipped * scheduler->period_ns);
+    }
+}
+
+static void *run_tick_scheduler(void *arg) {
+    tick_scheduler *scheduler = (tick_scheduler *)arg;
+
+    while (!scheduler->stopped) {
+        int res = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &scheduler->next_deadline, NULL);
+        if (res == EINTR) {
+            continue;
+        }
+        if (res != 0) {
+            errno = res;
+            perror("clock_nanosleep");
+            break;
+        }
+        if (scheduler->stopped) {
+            break;
+        }
+
+        run_tasks(scheduler);
+        advance_deadline(scheduler);
+    }
+
+    return NULL;
+}
+
+void set_tick_end_callback(tick_scheduler *scheduler, tick_end_callback callback, void *data) {
+    scheduler->tick_end = callback;
+    scheduler->tick_end_data = data;
+}
+
+int start_tick_scheduler(tick_scheduler *scheduler) {
+    clock_gettime(CLOCK_MONOTONIC, &scheduler->next_deadline);
+    add_ns(&scheduler->next_deadline, scheduler->period_ns);
+
+    if (pthread_create(&scheduler->thread, NULL, run_tick_scheduler, scheduler) != 0) {
+        perror("pthread_create tick_scheduler");
+        return EXIT_FAILURE;
+    }
+    scheduler->started = true;
+    return EXIT_SUCCESS;
+}
+
+static void free_tasks(tick_task *task) {
+    while (task != NULL) {
+        tick_task *next = task->next;
+        free(task);
+        task = next;
+    }
+}
+
+void free_tick_scheduler(tick_scheduler *scheduler) {
+    RETURN_IF_NULL(scheduler);
+
+    scheduler->stopped = true;
+    if (scheduler->started) {
+        pthread_join(scheduler->thread, NULL);
+    }
+
+    free_tasks(scheduler->tasks);
+    free_tasks(scheduler->new_tasks);
+    pthread_mutex_destroy(&scheduler->lock_new_tasks);
+    free(scheduler);
+}
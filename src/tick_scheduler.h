@@ -0,0 +1,61 @@
+#ifndef SRC_TICK_SCHEDULER_H_
+#define SRC_TICK_SCHEDULER_H_
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <time.h>
+
+/** Called by the scheduler thread at each tick with the number of the tick
+ * Returns false when the task is over, it is then removed from the scheduler
+ */
+typedef bool (*tick_callback)(void *data, unsigned long tick);
+
+/** Called by the scheduler thread after the tasks of each tick */
+typedef void (*tick_end_callback)(void *data);
+
+typedef struct tick_task {
+    tick_callback callback;
+    void *data;
+    struct tick_task *next;
+} tick_task;
+
+/** Thread running its tasks every period, on deadlines of the monotonic clock
+ * When a tick ends after the deadline of the next one, the next tick is run at once (catch up) and the following
+ * late ticks are skipped, their numbers are not given to the tasks
+ */
+typedef struct tick_scheduler {
+    long period_ns;
+    struct timespec next_deadline;
+    unsigned long ticks;    // Number of the next tick, skipped ticks included
+    unsigned long overruns; // Number of skipped ticks
+
+    tick_task *tasks;     // Only used by the scheduler thread
+    tick_task *new_tasks; // Added by the other threads, run from the next tick
+    pthread_mutex_t lock_new_tasks;
+
+    tick_end_callback tick_end; // NULL if nothing is done after the tasks
+    void *tick_end_data;
+
+    atomic_bool stopped;
+    pthread_t thread;
+    bool started; // The thread is only joined if it was started
+} tick_scheduler;
+
+tick_scheduler *create_tick_scheduler(long period_ms);
+
+/** Adds a task run at each tick from the next one, it can be called from any thread
+ */
+int schedule_tick_task(tick_scheduler *scheduler, tick_callback callback, void *data);
+
+/** Has to be called before the scheduler is started
+ */
+void set_tick_end_callback(tick_scheduler *scheduler, tick_end_callback callback, void *data);
+
+int start_tick_scheduler(tick_scheduler *scheduler);
+
+/** Stops the thread of the scheduler and frees it, the remaining tasks are not run anymore
+ */
+void free_tick_scheduler(tick_scheduler *scheduler);
+
+#endif // SRC_TICK_SCHEDULER_H_
@@ -0,0 +1,253 @@
+#include "update_stream.h"
+#include "utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Signed distance between two update numbers, which wrap around with their 16 bits */
+static int16_t num_distance(uint16_t num, uint16_t reference) {
+    return (int16_t)(num - reference);
+}
+
+void init_update_stream(update_stream *stream) {
+    stream->region = -1;
+    stream->origin = (coord){0, 0};
+    stream->synced = false;
+    stream->expected_num = 0;
+    for (int i = 0; i < UPDATE_REORDER_SLOTS; i++) {
+        stream->pending[i].count = 0;
+    }
+    stream->bands.active = false;
+    stream->bands.dim = (dimension){0, 0};
+    stream->bands.tiles = NULL;
+    stream->bands.rows = NULL;
+    stream->gap_since = -1;
+    stream->last_request = -1;
+}
+
+void free_update_stream(update_stream *stream) {
+    free(stream->bands.tiles);
+    free(stream->bands.rows);
+    stream->bands.tiles = NULL;
+    stream->bands.rows = NULL;
+    stream->bands.dim = (dimension){0, 0};
+}
+
+void init_region_stream(update_stream *stream, const region_grid *grid, int region) {
+    init_update_stream(stream);
+
+    dimension area;
+    stream->region = region;
+    get_region_area(grid, region, &stream->origin, &area);
+}
+
+void update_board(board *b, const game_board_view *view) {
+    // The grid is only reallocated when the dimension of the board changes
+    if (b->dim.width != view->width || b->dim.height != view->height) {
+        char *grid = realloc(b->grid, view->height * view->width);
+        RETURN_IF_NULL_PERROR(grid, "realloc board grid");
+        b->grid = grid;
+        b->dim.width = view->width;
+        b->dim.height = view->height;
+    }
+
+    memcpy(b->grid, view->tiles, b->dim.height * b->dim.width);
+}
+
+/** Applies the differences of view, relative to the origin of the stream */
+static void apply_update_view(const update_stream *stream, board *b, const game_board_update_view *view) {
+    for (int i = 0; i < view->nb; i++) {
+        tile_diff diff = get_game_board_update_diff(view, i);
+        int x = stream->origin.x + diff.x;
+        int y = stream->origin.y + diff.y;
+        if (x >= b->dim.width || y >= b->dim.height) {
+            continue;
+        }
+        b->grid[y * b->dim.width + x] = diff.tile;
+    }
+}
+
+/** Applies the buffered updates following the last applied one, as long as all their fragments are received */
+static void drain_pending_updates(update_stream *stream, board *b) {
+    while (true) {
+        pending_update *pending = &stream->pending[stream->expected_num % UPDATE_REORDER_SLOTS];
+        if (pending->count == 0 || pending->num != stream->expected_num || pending->nb_received < pending->count) {
+            return;
+        }
+
+        for (int i = 0; i < pending->count; i++) {
+            game_board_update_view view;
+            if (deserialize_game_board_update_view(pending->fragments[i], pending->sizes[i], &view) == EXIT_SUCCESS) {
+                apply_update_view(stream, b, &view);
+            }
+        }
+        pending->count = 0;
+        stream->expected_num++;
+    }
+}
+
+/** Forgets the buffered updates older than the expected one */
+static void drop_stale_updates(update_stream *stream) {
+    for (int i = 0; i < UPDATE_REORDER_SLOTS; i++) {
+        pending_update *pending = &stream->pending[i];
+        if (pending->count != 0 && num_distance(pending->num, stream->expected_num) < 0) {
+            pending->count = 0;
+        }
+    }
+}
+
+static bool has_pending_updates(const update_stream *stream) {
+    for (int i = 0; i < UPDATE_REORDER_SLOTS; i++) {
+        if (stream->pending[i].count != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool apply_keyframe(update_stream *stream, board *b, const game_board_view *view) {
+    if (stream->synced && num_distance(view->num, stream->expected_num) < 0) {
+        return false;
+    }
+
+    update_board(b, view);
+    stream->synced = true;
+    stream->expected_num = view->num;
+
+    drop_stale_updates(stream);
+    drain_pending_updates(stream, b);
+    return true;
+}
+
+bool apply_region_keyframe(update_stream *stream, board *b, const game_region_view *view) {
+    if (view->region != stream->region || b->dim.height != view->height || b->dim.width != view->width) {
+        return false;
+    }
+    if (stream->synced && num_distance(view->num, stream->expected_num) < 0) {
+        return false;
+    }
+
+    region_grid grid;
+    init_region_grid(&grid, b->dim);
+    coord origin;
+    dimension area;
+    get_region_area(&grid, view->region, &origin, &area);
+    for (int row = 0; row < area.height; row++) {
+        memcpy(b->grid + (origin.y + row) * b->dim.width + origin.x, view->tiles + row * area.width, area.width);
+    }
+    stream->synced = true;
+    stream->expected_num = view->num;
+
+    drop_stale_updates(stream);
+    drain_pending_updates(stream, b);
+    return true;
+}
+
+/** Resizes the board assembled from the bands, the previous bands are lost */
+static int resize_keyframe_bands(keyframe_bands *bands, uint16_t height, uint16_t width) {
+    char *tiles = realloc(bands->tiles, (size_t)height * width);
+    RETURN_FAILURE_IF_NULL_PERROR(tiles, "realloc keyframe tiles");
+    bands->tiles = tiles;
+
+    bool *rows = realloc(bands->rows, height * sizeof(bool));
+    RETURN_FAILURE_IF_NULL_PERROR(rows, "realloc keyframe rows");
+    bands->rows = rows;
+
+    bands->dim.height = height;
+    bands->dim.width = width;
+    bands->active = false;
+    return EXIT_SUCCESS;
+}
+
+bool apply_keyframe_band(update_stream *stream, board *b, const game_board_band_view *band) {
+    keyframe_bands *bands = &stream->bands;
+    if (stream->synced && num_distance(band->num, stream->expected_num) < 0) {
+        return false;
+    }
+    if (bands->active && num_distance(band->num, bands->num) < 0) {
+        return false; // The bands of a more recent board are already being received
+    }
+
+    if (bands->dim.height != band->height || bands->dim.width != band->width) {
+        if (resize_keyframe_bands(bands, band->height, band->width) != EXIT_SUCCESS) {
+            return false;
+        }
+    }
+    if (!bands->active || bands->num != band->num) {
+        memset(bands->rows, false, band->height * sizeof(bool));
+        bands->nb_rows = 0;
+        bands->num = band->num;
+        bands->active = true;
+    }
+
+    memcpy(bands->tiles + band->first_row * band->width, band->tiles, band->nb_rows * band->width);
+    for (int row = band->first_row; row < band->first_row + band->nb_rows; row++) {
+        if (!bands->rows[row]) {
+            bands->rows[row] = true;
+            bands->nb_rows++;
+        }
+    }
+    if (bands->nb_rows < band->height) {
+        return false;
+    }
+
+    bands->active = false;
+    game_board_view view = {bands->num, band->height, band->width, bands->tiles};
+    return apply_keyframe(stream, b, &view);
+}
+
+update_status apply_update(update_stream *stream, board *b, const char *update, size_t size) {
+    game_board_update_view view;
+    if (size > sizeof(stream->pending[0].fragments[0]) ||
+        deserialize_game_board_update_view(update, size, &view) != EXIT_SUCCESS ||
+        view.count > MAX_UPDATE_FRAGMENTS || view.region != stream->region) {
+        return UPDATE_INVALID;
+    }
+    if (stream->synced && num_distance(view.num, stream->expected_num) < 0) {
+        return UPDATE_DROPPED;
+    }
+
+    // The most recent update takes the slot, it keeps the gap visible until a whole board catches up
+    pending_update *pending = &stream->pending[view.num % UPDATE_REORDER_SLOTS];
+    if (pending->count == 0 || pending->num != view.num || pending->count != view.count) {
+        pending->num = view.num;
+        pending->count = view.count;
+        pending->nb_received = 0;
+        for (int i = 0; i < view.count; i++) {
+            pending->received[i] = false;
+        }
+    }
+    if (!pending->received[view.index]) {
+        memcpy(pending->fragments[view.index], update, size);
+        pending->sizes[view.index] = size;
+        pending->received[view.index] = true;
+        pending->nb_received++;
+    }
+
+    if (!stream->synced) {
+        return UPDATE_BUFFERED;
+    }
+    drain_pending_updates(stream, b);
+    return num_distance(view.num, stream->expected_num) < 0 ? UPDATE_APPLIED : UPDATE_BUFFERED;
+}
+
+bool should_request_keyframe(update_stream *stream, long now) {
+    if (stream->synced && !has_pending_updates(stream)) {
+        stream->gap_since = -1;
+        return false;
+    }
+
+    if (stream->gap_since == -1) {
+        stream->gap_since = now;
+    }
+    if (now - stream->gap_since < KEYFRAME_REQUEST_DELAY) {
+        return false;
+    }
+    if (stream->last_request != -1 && now - stream->last_request < KEYFRAME_REQUEST_DELAY) {
+        return false;
+    }
+
+    stream->last_request = now;
+    return true;
+}
@@ -0,0 +1,87 @@
+#ifndef SRC_UPDATE_STREAM_H_
+#define SRC_UPDATE_STREAM_H_
+
+#include "messages.h"
+#include "model.h"
+
+#include <stdbool.h>
+
+#define UPDATE_REORDER_SLOTS 8     // Number of updates kept while an earlier one is missing
+#define KEYFRAME_REQUEST_DELAY 100 // in ms, how long a missing update is waited for before asking for a whole board
+
+typedef enum update_status { UPDATE_APPLIED, UPDATE_BUFFERED, UPDATE_DROPPED, UPDATE_INVALID } update_status;
+
+/** Fragments of an update received before the updates preceding it */
+typedef struct pending_update {
+    uint16_t num;
+    uint8_t count; // Number of fragments of the update, 0 when the slot is free
+    uint8_t nb_received;
+    bool received[MAX_UPDATE_FRAGMENTS];
+    size_t sizes[MAX_UPDATE_FRAGMENTS];
+    char fragments[MAX_UPDATE_FRAGMENTS][MAX_UPDATE_FRAGMENT_SIZE];
+} pending_update;
+
+/** Whole board received band by band, applied once all its rows are there */
+typedef struct keyframe_bands {
+    bool active; // Bands of the board num are being received
+    uint16_t num;
+    dimension dim;
+    char *tiles; // dim.height * dim.width tiles
+    bool *rows;  // Rows received
+    unsigned nb_rows;
+} keyframe_bands;
+
+/** Rebuilds the game board of a client from the whole boards and the numbered updates of the server
+ * The updates received out of order or in several fragments are kept until they can be applied in order,
+ * or until a whole board replaces them
+ */
+typedef struct update_stream {
+    int region;            // Region of a large board whose updates are applied, -1 for the whole board
+    coord origin;          // First tile of the region, the differences of its updates are relative to it
+    bool synced;           // A whole board has been applied
+    uint16_t expected_num; // Number of the next update to apply
+    pending_update pending[UPDATE_REORDER_SLOTS];
+    keyframe_bands bands;
+    long gap_since;    // in ms, -1 while no update is missing
+    long last_request; // in ms, -1 before the first keyframe request
+} update_stream;
+
+void init_update_stream(update_stream *stream);
+
+void free_update_stream(update_stream *stream);
+
+/** Initializes the stream of the updates of a region, which are only applied after a whole region */
+void init_region_stream(update_stream *stream, const region_grid *grid, int region);
+
+/** Replaces the grid of b by the tiles of view, the grid is only reallocated when the dimension changes */
+void update_board(board *b, const game_board_view *view);
+
+/** Applies the whole board view to b and the buffered updates following it
+ * Returns false if the board is older than the updates already applied, b is then unchanged
+ */
+bool apply_keyframe(update_stream *stream, board *b, const game_board_view *view);
+
+/** Keeps the band of a whole board, which is applied to b as by apply_keyframe once all its rows are received
+ * Returns true if the band completes a board which is applied
+ */
+bool apply_keyframe_band(update_stream *stream, board *b, const game_board_band_view *band);
+
+/** Applies the whole region view, with the buffered updates following it, to b, which must have the dimension
+ * of the board of the region
+ * Returns false if the region is older than the updates already applied or if b is not the board of the region
+ */
+bool apply_region_keyframe(update_stream *stream, board *b, const game_region_view *view);
+
+/** Applies the size bytes of update, or of one of its fragments, to b if it is the expected one and if all its
+ * fragments are received, followed by the buffered updates
+ * The updates ahead of the expected one are buffered, the older ones are dropped
+ * Before the first whole board, every update is buffered, and the updates of another region are invalid
+ */
+update_status apply_update(update_stream *stream, board *b, const char *update, size_t size);
+
+/** Returns true if an update has been missing for KEYFRAME_REQUEST_DELAY ms at time now
+ * and no whole board has been asked for during this delay, the request is then considered as sent
+ */
+bool should_request_keyframe(update_stream *stream, long now);
+
+#endif // SRC_UPDATE_STREAM_H_
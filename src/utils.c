@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 int min(int a, int b) {
     return a < b ? a : b;
@@ -13,6 +14,12 @@ int max(int a, int b) {
     return a > b ? a : b;
 }
 
+long get_time_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
 bool is_integer(const char *str) {
     for (size_t i = 0; i < strlen(str); ++i) {
         if (!isdigit(str[i])) {
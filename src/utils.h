@@ -91,6 +91,10 @@
 int min(int, int);
 int max(int, int);
 
+/** Returns the time of the monotonic clock in milliseconds
+ */
+long get_time_ms();
+
 /** Returns -1 in case of error, since the minimum is necessarily greater than or equal to 0
  */
 int parse_unsigned_within_bounds(const char *, unsigned, unsigned);
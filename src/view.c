@@ -38,6 +38,18 @@ static window_context *chat_input_wc;
 
 static const padding SCREEN_PADDING = {PADDING_SCREEN_TOP, PADDING_SCREEN_LEFT};
 
+/** Tiles of the board as they were last drawn, only the tiles which changed since are drawn again
+ * The whole board is drawn when the shadow is not valid: before the first drawing, when the dimension of the board
+ * changes or when the focus moves
+ */
+static struct {
+    char *tiles;
+    dimension dim;
+    bool is_valid;
+} shadow = {NULL, {0, 0}, false};
+
+static int focus = -1; // The chat has the focus if 1, the game if 0, -1 before the first drawing
+
 static void get_height_width_terminal(dimension *);
 static bool is_valid_terminal_size();
 
@@ -51,7 +63,7 @@ static int split_terminal_window(window_context *, window_context *);
 static int split_chat_window(window_context *, window_context *, window_context *);
 
 // Helper functions for refreshing the game and chat windows
-static void print_game(board *, window_context *);
+static void print_game(const board *, window_context *);
 static void print_chat(GAME_MODE, chat *, int, window_context *, window_context *);
 
 static void toggle_focus(chat *, window_context *, window_context *, window_context *);
@@ -117,6 +129,10 @@ int init_view() {
 }
 
 void end_view() {
+    free(shadow.tiles);
+    shadow.tiles = NULL;
+    shadow.is_valid = false;
+    focus = -1;
     del_all_windows(); // Delete all the windows and free the memory
     curs_set(1);       // Set the cursor to visible again
     endwin();          /* End curses mode */
@@ -156,17 +172,17 @@ void get_computed_board_dimension(dimension *dim) {
     }
 }
 
-void refresh_game(GAME_MODE game_mode, board *b, chat *c, int player_id) {
+void refresh_game(GAME_MODE game_mode, const board *b, chat *c, int player_id) {
     toggle_focus(c, game_wc, chat_history_wc, chat_input_wc);
     print_game(b, game_wc);
-    wrefresh(game_wc->win); // Refresh the game window
+    wnoutrefresh(game_wc->win); // Refresh the game window
 
     print_chat(game_mode, c, player_id, chat_history_wc, chat_input_wc);
-    wrefresh(chat_input_wc->win);   // Refresh the chat input window (Before chat_win refresh)
-    wrefresh(chat_history_wc->win); // Refresh the chat history window
-    wrefresh(chat_wc->win);         // Refresh the chat window
+    wnoutrefresh(chat_input_wc->win);   // Refresh the chat input window (Before chat_win refresh)
+    wnoutrefresh(chat_history_wc->win); // Refresh the chat history window
+    wnoutrefresh(chat_wc->win);         // Refresh the chat window
 
-    refresh(); // Apply the changes to the terminal
+    doupdate(); // Apply the changes of all the windows to the terminal at once
 }
 
 bool is_valid_terminal_size() {
@@ -290,94 +306,128 @@ int split_chat_window(window_context *chat_wc, window_context *chat_history_wc,
     return EXIT_SUCCESS;
 }
 
-void activate_color_for_tile(window_context *wc, TILE tile) {
+/** Returns the color pair of the tile, 0 if it is drawn without color */
+int get_color_pair_of_tile(TILE tile) {
     switch (tile) {
         case PLAYER_1:
-            wattron(wc->win, COLOR_PAIR(4));
-            break;
+            return 4;
         case PLAYER_2:
-            wattron(wc->win, COLOR_PAIR(5));
-            break;
+            return 5;
         case PLAYER_3:
-            wattron(wc->win, COLOR_PAIR(6));
-            break;
+            return 6;
         case PLAYER_4:
-            wattron(wc->win, COLOR_PAIR(7));
-            break;
+            return 7;
         case VERTICAL_BORDER:
         case HORIZONTAL_BORDER:
-            wattron(wc->win, COLOR_PAIR(8));
-            break;
+            return 8;
         case INDESTRUCTIBLE_WALL:
-            wattron(wc->win, COLOR_PAIR(9));
-            break;
+            return 9;
         case DESTRUCTIBLE_WALL:
-            wattron(wc->win, COLOR_PAIR(10));
-            break;
-        case EMPTY:
-            break;
+            return 10;
         case BOMB:
-            wattron(wc->win, COLOR_PAIR(11));
-            break;
+            return 11;
+        case EMPTY:
         case EXPLOSION:
             break;
     }
+    return 0;
+}
+
+void activate_color_for_tile(window_context *wc, TILE tile) {
+    int pair = get_color_pair_of_tile(tile);
+    if (pair != 0) {
+        wattron(wc->win, COLOR_PAIR(pair));
+    }
 }
 
 void deactivate_color_for_tile(window_context *wc, TILE tile) {
-    switch (tile) {
-        case PLAYER_1:
-            wattroff(wc->win, COLOR_PAIR(4));
-            break;
-        case PLAYER_2:
-            wattroff(wc->win, COLOR_PAIR(5));
-            break;
-        case PLAYER_3:
-            wattroff(wc->win, COLOR_PAIR(6));
-            break;
-        case PLAYER_4:
-            wattroff(wc->win, COLOR_PAIR(7));
-            break;
-        case VERTICAL_BORDER:
-        case HORIZONTAL_BORDER:
-            wattroff(wc->win, COLOR_PAIR(8));
-            break;
-        case INDESTRUCTIBLE_WALL:
-            wattroff(wc->win, COLOR_PAIR(9));
-            break;
-        case DESTRUCTIBLE_WALL:
-            wattroff(wc->win, COLOR_PAIR(10));
-            break;
-        case EMPTY:
-            break;
-        case BOMB:
-            wattroff(wc->win, COLOR_PAIR(11));
-            break;
-        case EXPLOSION:
-            break;
+    int pair = get_color_pair_of_tile(tile);
+    if (pair != 0) {
+        wattroff(wc->win, COLOR_PAIR(pair));
+    }
+}
+
+/** Makes the shadow the size of the board, it is then not valid
+ * Returns EXIT_FAILURE if it could not be allocated, the whole board is then drawn each time
+ */
+int resize_shadow(dimension dim) {
+    shadow.is_valid = false;
+    char *tiles = realloc(shadow.tiles, dim.height * dim.width);
+    RETURN_FAILURE_IF_NULL_PERROR(tiles, "realloc shadow");
+    shadow.tiles = tiles;
+    shadow.dim = dim;
+    return EXIT_SUCCESS;
+}
+
+/** The shadow has the dimension of the board, it can be compared with it */
+bool is_shadow_of(dimension dim) {
+    return shadow.tiles != NULL && shadow.dim.height == dim.height && shadow.dim.width == dim.width;
+}
+
+/** Tiles of the board inside the game window, the board may be larger than the window */
+typedef struct visible_tiles {
+    int first_x;
+    int end_x; // Excluded
+    int first_y;
+    int end_y; // Excluded
+} visible_tiles;
+
+/** The tile (x, y) is drawn at the row y + 1 + pad.top and the column x + 1 + pad.left of the window */
+visible_tiles get_visible_tiles(dimension dim, padding pad, const window_context *game_wc) {
+    visible_tiles visible;
+    visible.first_x = pad.left + 1 < 0 ? -(pad.left + 1) : 0;
+    visible.end_x = game_wc->dim.width - pad.left - 1 < dim.width ? game_wc->dim.width - pad.left - 1 : dim.width;
+    visible.first_y = pad.top + 1 < 0 ? -(pad.top + 1) : 0;
+    visible.end_y = game_wc->dim.height - pad.top - 1 < dim.height ? game_wc->dim.height - pad.top - 1 : dim.height;
+    if (visible.end_x < visible.first_x) {
+        visible.end_x = visible.first_x;
+    }
+    if (visible.end_y < visible.first_y) {
+        visible.end_y = visible.first_y;
     }
+    return visible;
 }
 
-void print_game(board *b, window_context *game_wc) {
-    // Update grid
+/** Draws the visible tiles of the row y which differ from the shadow, or all of them if the shadow is not valid
+ * The consecutive tiles of the same color are drawn together, with a single change of the attributes
+ */
+void print_game_row(const board *b, int y, const visible_tiles *visible, bool is_shadow_valid, padding pad,
+                    window_context *game_wc) {
+    const char *row = b->grid + coord_to_int_dim(0, y, b->dim);
+    const char *shadow_row = is_shadow_valid ? shadow.tiles + y * b->dim.width : NULL;
+    char run[MAX_GAMEBOARD_WIDTH];
+
+    int x = visible->first_x;
+    while (x < visible->end_x) {
+        if (is_shadow_valid && row[x] == shadow_row[x]) {
+            x++;
+            continue;
+        }
+
+        int first = x;
+        int pair = get_color_pair_of_tile(row[x]);
+        int length = 0;
+        while (x < visible->end_x && length < (int)sizeof(run) && (!is_shadow_valid || row[x] != shadow_row[x]) &&
+               get_color_pair_of_tile(row[x]) == pair) {
+            run[length] = tile_to_char(row[x]);
+            length++;
+            x++;
+        }
+
+        if (pair != 0) {
+            wattron(game_wc->win, COLOR_PAIR(pair));
+        }
+        mvwaddnstr(game_wc->win, y + 1 + pad.top, first + 1 + pad.left, run, length);
+        if (pair != 0) {
+            wattroff(game_wc->win, COLOR_PAIR(pair));
+        }
+    }
+}
+
+void print_game_borders(const board *b, padding pad, window_context *game_wc) {
     int x, y;
-    dimension dim = b->dim;
-    int pad_top = (game_wc->dim.height - dim.height - 2) / 2; // We can substract 2 or 1 but the first enable a left
-                                                              // align whether 1 is for a right align
-    int pad_left = (game_wc->dim.width - dim.width - 2) / 2;
-    padding pad = {pad_top, pad_left};
     char vb = tile_to_char(VERTICAL_BORDER);
     char hb = tile_to_char(HORIZONTAL_BORDER);
-    for (y = 0; y < b->dim.height; y++) {
-        for (x = 0; x < b->dim.width; x++) {
-            int pos = coord_to_int_dim(x, y, dim);
-            TILE t = b->grid[pos];
-            char c = tile_to_char(t);
-            activate_color_for_tile(game_wc, t);
-            mvwaddch(game_wc->win, y + 1 + pad.top, x + 1 + pad.left, c);
-            deactivate_color_for_tile(game_wc, t);
-        }
-    }
 
     activate_color_for_tile(game_wc, HORIZONTAL_BORDER);
     for (x = 0; x < b->dim.width + 2; x++) {
@@ -394,6 +444,44 @@ void print_game(board *b, window_context *game_wc) {
     deactivate_color_for_tile(game_wc, VERTICAL_BORDER);
 }
 
+/** Draws the tiles which changed since the last drawing, the whole board and its borders if the shadow is not valid
+ */
+void print_game(const board *b, window_context *game_wc) {
+    dimension dim = b->dim;
+    int pad_top = (game_wc->dim.height - dim.height - 2) / 2; // We can substract 2 or 1 but the first enable a left
+                                                              // align whether 1 is for a right align
+    int pad_left = (game_wc->dim.width - dim.width - 2) / 2;
+    padding pad = {pad_top, pad_left};
+
+    if (!is_shadow_of(dim)) {
+        resize_shadow(dim);
+    }
+    // The shadow is not used if it could not be resized to the board
+    bool is_shadow_valid = shadow.is_valid && is_shadow_of(dim);
+    if (!is_shadow_valid) {
+        print_game_borders(b, pad, game_wc);
+    }
+
+    // Only the tiles inside the window are drawn, and then copied into the shadow
+    visible_tiles visible = get_visible_tiles(dim, pad, game_wc);
+    size_t visible_size = visible.end_x - visible.first_x;
+    for (int y = visible.first_y; y < visible.end_y; y++) {
+        size_t offset = coord_to_int_dim(visible.first_x, y, dim);
+        if (is_shadow_valid && memcmp(b->grid + offset, shadow.tiles + offset, visible_size) == 0) {
+            continue; // Most rows do not change between two drawings
+        }
+        print_game_row(b, y, &visible, is_shadow_valid, pad, game_wc);
+    }
+
+    if (is_shadow_of(dim)) {
+        for (int y = visible.first_y; y < visible.end_y; y++) {
+            size_t offset = coord_to_int_dim(visible.first_x, y, dim);
+            memcpy(shadow.tiles + offset, b->grid + offset, visible_size);
+        }
+        shadow.is_valid = true;
+    }
+}
+
 void activate_color_for_player(window_context *wc, int player_id) {
     switch (player_id) {
         case 1:
@@ -540,7 +628,14 @@ void print_chat(GAME_MODE game_mode, chat *c, int player_id, window_context *cha
     print_chat_history(game_mode, c, chat_history_wc);
 }
 
+/** Changes the colors of the windows when the focus moves, the board is then drawn again */
 void toggle_focus(chat *c, window_context *game_wc, window_context *chat_history_wc, window_context *chat_input_wc) {
+    if (focus == c->on_focus) {
+        return;
+    }
+    focus = c->on_focus;
+    shadow.is_valid = false;
+
     if (!c->on_focus) {
         wbkgd(game_wc->win, COLOR_PAIR(2));
         wbkgd(chat_history_wc->win, COLOR_PAIR(1));
@@ -19,8 +19,8 @@ void end_view();
  */
 void get_computed_board_dimension(dimension *);
 
-/** Updates terminal display with board data
+/** Updates terminal display with board data, only the tiles which changed since the last update are drawn
  */
-void refresh_game(GAME_MODE, board *, chat *, int);
+void refresh_game(GAME_MODE, const board *, chat *, int);
 
 #endif // SRC_VIEW_H_
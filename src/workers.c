@@ -0,0 +1,178 @@
+#define _GNU_SOURCE // sched_setaffinity
+
+#include "workers.h"
+#include "network_server.h"
+#include "utils.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct worker {
+    pid_t pid;    // -1 while the worker is not running
+    long started; // in ms
+} worker;
+
+static worker workers[MAX_WORKERS];
+static cpu_set_t cores; // Cores available to the server, the workers are spread on them
+
+static volatile sig_atomic_t stopping = 0;
+
+static void stop_workers_on_signal(int sig) {
+    (void)sig;
+    stopping = 1;
+}
+
+/** Pins the worker index to a core, the workers share the cores if there are more workers than cores */
+static void pin_worker(unsigned index) {
+    int nb_cores = CPU_COUNT(&cores);
+    if (nb_cores == 0) {
+        return;
+    }
+
+    int skipped = index % nb_cores; // Available cores before the one of the worker
+    int core = 0;
+    while (!CPU_ISSET(core, &cores) || skipped-- > 0) {
+        core++;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) < 0) {
+        perror("sched_setaffinity worker");
+    }
+}
+
+/** Body of a worker, which never returns */
+static void run_worker(unsigned index, uint16_t port) {
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+
+    // The workers must not draw the same ports and multicast groups
+    srandom(time(NULL) ^ getpid());
+    pin_worker(index);
+
+    // The socket of the parent only keeps the port while the workers restart
+    close_socket_tcp();
+    if (init_socket_tcp(port, true) != EXIT_SUCCESS) {
+        exit(EXIT_FAILURE);
+    }
+
+    init_state();
+    exit(game_loop_server());
+}
+
+static int start_worker(unsigned index, uint16_t port) {
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork worker");
+        return EXIT_FAILURE;
+    }
+    if (pid == 0) {
+        run_worker(index, port);
+    }
+
+    workers[index].pid = pid;
+    workers[index].started = get_time_ms();
+    return EXIT_SUCCESS;
+}
+
+static int find_worker(pid_t pid, unsigned nb_workers) {
+    for (unsigned i = 0; i < nb_workers; i++) {
+        if (workers[i].pid == pid) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void stop_workers(unsigned nb_workers) {
+    for (unsigned i = 0; i < nb_workers; i++) {
+        if (workers[i].pid != -1) {
+            kill(workers[i].pid, SIGTERM);
+        }
+    }
+    for (unsigned i = 0; i < nb_workers; i++) {
+        if (workers[i].pid != -1) {
+            waitpid(workers[i].pid, NULL, 0);
+            workers[i].pid = -1;
+        }
+    }
+}
+
+/** Restarts a worker which stopped, a worker which keeps crashing is only restarted every WORKER_RESTART_DELAY ms */
+static void restart_worker(unsigned index, int status, uint16_t port) {
+    if (WIFSIGNALED(status)) {
+        fprintf(stderr, "The worker %u was stopped by the signal %d.\n", index, WTERMSIG(status));
+    } else {
+        fprintf(stderr, "The worker %u exited with the status %d.\n", index, WEXITSTATUS(status));
+    }
+
+    workers[index].pid = -1;
+    long uptime = get_time_ms() - workers[index].started;
+    if (uptime < WORKER_RESTART_DELAY) {
+        usleep((WORKER_RESTART_DELAY - uptime) * 1000);
+    }
+    if (!stopping) {
+        start_worker(index, port);
+    }
+}
+
+int run_workers(unsigned nb_workers, uint16_t port) {
+    if (nb_workers == 0 || nb_workers > MAX_WORKERS) {
+        return EXIT_FAILURE;
+    }
+    if (sched_getaffinity(0, sizeof(cores), &cores) < 0) {
+        perror("sched_getaffinity");
+        CPU_ZERO(&cores);
+    }
+
+    // Without SA_RESTART, so that waitpid is interrupted by the signals
+    struct sigaction action;
+    action.sa_handler = stop_workers_on_signal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = 0;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    for (unsigned i = 0; i < nb_workers; i++) {
+        workers[i].pid = -1;
+    }
+    for (unsigned i = 0; i < nb_workers; i++) {
+        if (start_worker(i, port) != EXIT_SUCCESS) {
+            stop_workers(nb_workers);
+            return EXIT_FAILURE;
+        }
+    }
+    printf("%u workers wait players on %u port.\n", nb_workers, port);
+    fflush(stdout);
+
+    while (!stopping) {
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno != EINTR) {
+                perror("waitpid workers");
+                break;
+            }
+            continue;
+        }
+
+        int index = find_worker(pid, nb_workers);
+        if (index >= 0) {
+            restart_worker(index, status, port);
+        }
+    }
+
+    stop_workers(nb_workers);
+    close_socket_tcp();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,15 @@
+#ifndef SRC_WORKERS_H_
+#define SRC_WORKERS_H_
+
+#include <stdint.h>
+
+#define MAX_WORKERS 64
+#define WORKER_RESTART_DELAY 1000 // in ms, a worker stopping sooner after its start is restarted after this delay
+
+/** Forks nb_workers processes, each one pinned to a core, which accept the players on the TCP socket port
+ * with their own games and waiting lobbies, the TCP socket of the parent has to be bound with SO_REUSEPORT
+ * The parent restarts the workers which stop, until it receives SIGINT or SIGTERM
+ */
+int run_workers(unsigned nb_workers, uint16_t port);
+
+#endif // SRC_WORKERS_H_
@@ -1,8 +1,12 @@
 #include "test.h"
 
-#define TEST_NUM 4
+#define TEST_NUM 13
 
-test tests[TEST_NUM] = {serialization_connection, serialization_game, serialization_chat, game_table};
+test tests[TEST_NUM] = {serialization_connection, serialization_game,   serialization_chat,
+                         game_table,               bitboard_planes,      tick_scheduler_ticks,
+                         action_ring_queue,        tick_allocations,     update_stream_reconstruction,
+                         matchmaking_queue,        egress_batches,       reactor_events,
+                         tcp_output_queue};
 
 int main(int argc, char *argv[]) {
     return cinta_main(argc, argv, tests, TEST_NUM);
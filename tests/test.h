@@ -7,5 +7,14 @@ test_info *serialization_connection();
 test_info *serialization_game();
 test_info *serialization_chat();
 test_info *game_table();
+test_info *bitboard_planes();
+test_info *tick_scheduler_ticks();
+test_info *action_ring_queue();
+test_info *tick_allocations();
+test_info *update_stream_reconstruction();
+test_info *matchmaking_queue();
+test_info *egress_batches();
+test_info *reactor_events();
+test_info *tcp_output_queue();
 
 #endif // TEST_H
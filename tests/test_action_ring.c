@@ -0,0 +1,103 @@
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "../src/action_ring.h"
+#include "test.h"
+
+#define NUMBER_TESTS 3
+#define NB_THREADED_ACTIONS 10000
+
+void test_push_pop(test_info *info);
+void test_full_ring(test_info *info);
+void test_threaded_ring(test_info *info);
+
+test_info *action_ring_queue() {
+    test_case cases[NUMBER_TESTS] = {
+        QUICK_CASE("Pushing and popping actions", test_push_pop),
+        QUICK_CASE("Dropping actions when the ring is full", test_full_ring),
+        QUICK_CASE("Producer and consumer threads", test_threaded_ring),
+    };
+
+    return cinta_run_cases("Action ring tests", cases, NUMBER_TESTS);
+}
+
+void test_push_pop(test_info *info) {
+    action_ring *ring = malloc(sizeof(action_ring));
+    init_action_ring(ring);
+
+    game_action actions[3] = {
+        {SOLO, 0, 0, 1, GAME_UP, 0},
+        {SOLO, 1, 0, 2, GAME_LEFT, 0},
+        {SOLO, 2, 0, 3, GAME_PLACE_BOMB, 0},
+    };
+    game_action res[ACTION_RING_CAPACITY];
+
+    CINTA_ASSERT_INT(pop_actions(ring, res, ACTION_RING_CAPACITY), 0, info);
+    CINTA_ASSERT_INT(push_actions(ring, actions, 3), 3, info);
+    CINTA_ASSERT_INT(pop_actions(ring, res, 2), 2, info);
+    CINTA_ASSERT_INT(res[0].message_number, 1, info);
+    CINTA_ASSERT_INT(res[1].action, GAME_LEFT, info);
+    CINTA_ASSERT_INT(pop_actions(ring, res, ACTION_RING_CAPACITY), 1, info);
+    CINTA_ASSERT_INT(res[0].id, 2, info);
+
+    free(ring);
+}
+
+void test_full_ring(test_info *info) {
+    action_ring *ring = malloc(sizeof(action_ring));
+    init_action_ring(ring);
+
+    game_action actions[ACTION_RING_CAPACITY];
+    for (int i = 0; i < ACTION_RING_CAPACITY; i++) {
+        actions[i].message_number = i;
+    }
+
+    CINTA_ASSERT_INT(push_actions(ring, actions, 10), 10, info);
+    CINTA_ASSERT_INT(push_actions(ring, actions, ACTION_RING_CAPACITY), ACTION_RING_CAPACITY - 10, info);
+    CINTA_ASSERT_INT(push_actions(ring, actions, 1), 0, info);
+
+    // The slots wrap around once some actions are popped
+    game_action res[ACTION_RING_CAPACITY];
+    CINTA_ASSERT_INT(pop_actions(ring, res, 20), 20, info);
+    CINTA_ASSERT_INT(res[10].message_number, 0, info);
+    CINTA_ASSERT_INT(push_actions(ring, actions, 20), 20, info);
+    CINTA_ASSERT_INT(pop_actions(ring, res, ACTION_RING_CAPACITY), ACTION_RING_CAPACITY, info);
+    CINTA_ASSERT_INT(res[ACTION_RING_CAPACITY - 1].message_number, 19, info);
+
+    free(ring);
+}
+
+void *produce_actions(void *arg) {
+    action_ring *ring = (action_ring *)arg;
+    game_action action = {SOLO, 0, 0, 0, GAME_NONE, 0};
+    while (action.message_number < NB_THREADED_ACTIONS) {
+        action.message_number += push_actions(ring, &action, 1);
+    }
+    return NULL;
+}
+
+void test_threaded_ring(test_info *info) {
+    action_ring *ring = malloc(sizeof(action_ring));
+    init_action_ring(ring);
+
+    pthread_t producer;
+    pthread_create(&producer, NULL, produce_actions, ring);
+
+    // The actions are received once each and in order
+    bool valid = true;
+    int expected = 0;
+    game_action res[ACTION_RING_CAPACITY];
+    while (expected < NB_THREADED_ACTIONS) {
+        unsigned nb = pop_actions(ring, res, ACTION_RING_CAPACITY);
+        for (unsigned i = 0; i < nb; i++) {
+            if (res[i].message_number != expected) {
+                valid = false;
+            }
+            expected++;
+        }
+    }
+    pthread_join(producer, NULL);
+
+    CINTA_ASSERT(valid, info);
+    free(ring);
+}
@@ -0,0 +1,75 @@
+#include <stdlib.h>
+
+#include "../src/bitboard.h"
+#include "test.h"
+
+#define NUMBER_TESTS 3
+
+void test_set_tile(test_info *info);
+void test_find_first(test_info *info);
+void test_find_last(test_info *info);
+
+test_info *bitboard_planes() {
+    test_case cases[NUMBER_TESTS] = {
+        QUICK_CASE("Setting tiles in the planes", test_set_tile),
+        QUICK_CASE("Finding the first tile of planes", test_find_first),
+        QUICK_CASE("Finding the last tile of planes", test_find_last),
+    };
+
+    return cinta_run_cases("Bitboard tests", cases, NUMBER_TESTS);
+}
+
+void test_set_tile(test_info *info) {
+    dimension dim = {50, 23};
+    bitboard *bb = create_bitboard(dim);
+    CINTA_ASSERT_NOT_NULL(bb, info);
+
+    set_bitboard_tile(bb, 70, EMPTY, BOMB);
+    CINTA_ASSERT_INT(get_bitboard_tile(bb, 70), BOMB, info);
+    CINTA_ASSERT(is_in_planes(bb, BLOCKING_TILES, 70), info);
+    CINTA_ASSERT_FALSE(is_in_planes(bb, WALL_TILES, 70), info);
+
+    set_bitboard_tile(bb, 70, BOMB, EXPLOSION);
+    CINTA_ASSERT_INT(get_bitboard_tile(bb, 70), EXPLOSION, info);
+    CINTA_ASSERT_FALSE(is_in_planes(bb, BLOCKING_TILES, 70), info);
+
+    set_bitboard_tile(bb, 70, EXPLOSION, EMPTY);
+    CINTA_ASSERT_INT(get_bitboard_tile(bb, 70), EMPTY, info);
+    CINTA_ASSERT_INT(get_bitboard_tile(bb, 69), EMPTY, info);
+
+    free_bitboard(bb);
+}
+
+void test_find_first(test_info *info) {
+    dimension dim = {50, 23};
+    bitboard *bb = create_bitboard(dim);
+
+    set_bitboard_tile(bb, 60, EMPTY, DESTRUCTIBLE_WALL);
+    set_bitboard_tile(bb, 130, EMPTY, INDESTRUCTIBLE_WALL);
+    set_bitboard_tile(bb, 200, EMPTY, PLAYER_2);
+
+    CINTA_ASSERT_INT(find_first_in_planes(bb, WALL_TILES, 0, 1149), 60, info);
+    CINTA_ASSERT_INT(find_first_in_planes(bb, WALL_TILES, 61, 1149), 130, info); // Across words
+    CINTA_ASSERT_INT(find_first_in_planes(bb, WALL_TILES, 61, 129), -1, info);
+    CINTA_ASSERT_INT(find_first_in_planes(bb, WALL_TILES, 60, 60), 60, info);
+    CINTA_ASSERT_INT(find_first_in_planes(bb, TILE_MASK(PLAYER_2), 0, 1149), 200, info);
+    CINTA_ASSERT_INT(find_first_in_planes(bb, TILE_MASK(PLAYER_1), 0, 1149), -1, info);
+
+    free_bitboard(bb);
+}
+
+void test_find_last(test_info *info) {
+    dimension dim = {50, 23};
+    bitboard *bb = create_bitboard(dim);
+
+    set_bitboard_tile(bb, 63, EMPTY, DESTRUCTIBLE_WALL);
+    set_bitboard_tile(bb, 64, EMPTY, INDESTRUCTIBLE_WALL);
+    set_bitboard_tile(bb, 1149, EMPTY, BOMB);
+
+    CINTA_ASSERT_INT(find_last_in_planes(bb, WALL_TILES, 0, 1149), 64, info);
+    CINTA_ASSERT_INT(find_last_in_planes(bb, WALL_TILES, 0, 63), 63, info);
+    CINTA_ASSERT_INT(find_last_in_planes(bb, WALL_TILES, 65, 1149), -1, info);
+    CINTA_ASSERT_INT(find_last_in_planes(bb, BLOCKING_TILES, 0, 1149), 1149, info);
+
+    free_bitboard(bb);
+}
@@ -0,0 +1,158 @@
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../src/egress.h"
+#include "test.h"
+
+#define NUMBER_TESTS 3
+#define NB_BANDS 10
+#define BAND_SIZE 1000
+
+void test_single_flush(test_info *info);
+void test_full_queue_flushed(test_info *info);
+void test_bounded_receivers(test_info *info);
+
+test_info *egress_batches() {
+    test_case cases[NUMBER_TESTS] = {
+        QUICK_CASE("Sending the datagrams of a tick with one call", test_single_flush),
+        QUICK_CASE("Flushing a full queue before queuing more", test_full_queue_flushed),
+        QUICK_CASE("Sending a datagram to each receiver within its bound", test_bounded_receivers),
+    };
+
+    return cinta_run_cases("Egress tests", cases, NUMBER_TESTS);
+}
+
+/** Binds a socket on a port of the loopback chosen by the kernel, addr is its address */
+static int bind_receiver(struct sockaddr_in6 *addr) {
+    int sock = socket(AF_INET6, SOCK_DGRAM, 0);
+    int buffer_size = 1 << 20; // The small datagrams of a whole batch use more than the default buffer
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    memset(addr, 0, sizeof(struct sockaddr_in6));
+    addr->sin6_family = AF_INET6;
+    addr->sin6_addr = in6addr_loopback;
+    socklen_t len = sizeof(struct sockaddr_in6);
+    if (sock < 0 || bind(sock, (struct sockaddr *)addr, len) < 0 ||
+        getsockname(sock, (struct sockaddr *)addr, &len) < 0) {
+        return -1;
+    }
+    return sock;
+}
+
+/** Receives the datagrams already there, checks that the i-th one has size and starts with the byte first + i */
+static int receive_all(int sock, size_t size, char first, test_info *info) {
+    char datagram[BAND_SIZE];
+    int nb = 0;
+    ssize_t res;
+    while ((res = recv(sock, datagram, sizeof(datagram), MSG_DONTWAIT)) >= 0) {
+        CINTA_ASSERT_INT(size, res, info);
+        CINTA_ASSERT_INT((char)(first + nb), datagram[0], info);
+        nb++;
+    }
+    return nb;
+}
+
+void test_single_flush(test_info *info) {
+    struct sockaddr_in6 addrs[2];
+    int receivers[2] = {bind_receiver(&addrs[0]), bind_receiver(&addrs[1])};
+    int sock = socket(AF_INET6, SOCK_DGRAM, 0);
+    CINTA_ASSERT(receivers[0] >= 0 && receivers[1] >= 0 && sock >= 0, info);
+
+    egress_queue *queue = create_egress_queue(sock, true);
+    CINTA_ASSERT_NOT_NULL(queue, info);
+
+    // The bands of a board go to the same address, they may be split by the kernel
+    char band[BAND_SIZE];
+    for (int i = 0; i < NB_BANDS; i++) {
+        memset(band, 'a' + i, sizeof(band));
+        CINTA_ASSERT_INT(EXIT_SUCCESS, queue_datagram(queue, &addrs[0], band, sizeof(band)), info);
+    }
+    char update[10];
+    for (int i = 0; i < 3; i++) {
+        memset(update, 'A' + i, sizeof(update));
+        CINTA_ASSERT_INT(EXIT_SUCCESS, queue_datagram(queue, &addrs[1], update, sizeof(update)), info);
+    }
+    CINTA_ASSERT_INT(EXIT_SUCCESS, flush_egress_queue(queue), info);
+    CINTA_ASSERT_INT(1, get_egress_syscalls(queue), info);
+    CINTA_ASSERT_INT(NB_BANDS + 3, get_egress_datagrams(queue), info);
+
+    usleep(10000);
+    CINTA_ASSERT_INT(NB_BANDS, receive_all(receivers[0], BAND_SIZE, 'a', info), info);
+    CINTA_ASSERT_INT(3, receive_all(receivers[1], sizeof(update), 'A', info), info);
+
+    free_egress_queue(queue);
+    close(sock);
+    close(receivers[0]);
+    close(receivers[1]);
+}
+
+void test_full_queue_flushed(test_info *info) {
+    struct sockaddr_in6 addr;
+    int receiver = bind_receiver(&addr);
+    int sock = socket(AF_INET6, SOCK_DGRAM, 0);
+    CINTA_ASSERT(receiver >= 0 && sock >= 0, info);
+
+    egress_queue *queue = create_egress_queue(sock, false);
+    CINTA_ASSERT_NOT_NULL(queue, info);
+
+    char large[EGRESS_MAX_MESSAGE_SIZE + 1] = {0};
+    CINTA_ASSERT_INT(EXIT_FAILURE, queue_datagram(queue, &addr, large, sizeof(large)), info);
+
+    // One more datagram than a batch holds
+    char datagram[1];
+    for (int i = 0; i <= EGRESS_BATCH_SIZE; i++) {
+        datagram[0] = (char)i;
+        CINTA_ASSERT_INT(EXIT_SUCCESS, queue_datagram(queue, &addr, datagram, sizeof(datagram)), info);
+    }
+    CINTA_ASSERT_INT(1, get_egress_syscalls(queue), info);
+    CINTA_ASSERT_INT(EXIT_SUCCESS, flush_egress_queue(queue), info);
+    CINTA_ASSERT_INT(2, get_egress_syscalls(queue), info);
+
+    usleep(10000);
+    CINTA_ASSERT_INT(EGRESS_BATCH_SIZE + 1, receive_all(receiver, sizeof(datagram), 0, info), info);
+
+    free_egress_queue(queue);
+    close(sock);
+    close(receiver);
+}
+
+void test_bounded_receivers(test_info *info) {
+    egress_receiver receivers[2];
+    int socks[2] = {bind_receiver(&receivers[0].addr), bind_receiver(&receivers[1].addr)};
+    int sock = socket(AF_INET6, SOCK_DGRAM, 0);
+    CINTA_ASSERT(socks[0] >= 0 && socks[1] >= 0 && sock >= 0, info);
+
+    egress_queue *queue = create_egress_queue(sock, true);
+    CINTA_ASSERT_NOT_NULL(queue, info);
+
+    // The second receiver has only room for one more band
+    for (int i = 0; i < 2; i++) {
+        receivers[i].sock = -1;
+        receivers[i].queued = i * BAND_SIZE;
+        receivers[i].dropped = 0;
+    }
+    egress_receiver *const all[2] = {&receivers[0], &receivers[1]};
+
+    char band[BAND_SIZE];
+    for (int i = 0; i < 3; i++) {
+        memset(band, 'a' + i, sizeof(band));
+        CINTA_ASSERT_INT(EXIT_SUCCESS, queue_datagram_to_receivers(queue, all, 2, 3 * BAND_SIZE, band, sizeof(band)),
+                         info);
+    }
+    CINTA_ASSERT_INT(EXIT_SUCCESS, flush_egress_queue(queue), info);
+    CINTA_ASSERT_INT(1, get_egress_syscalls(queue), info);
+    CINTA_ASSERT_INT(5, get_egress_datagrams(queue), info);
+    CINTA_ASSERT_INT(0, receivers[0].dropped, info);
+    CINTA_ASSERT_INT(1, receivers[1].dropped, info);
+
+    usleep(10000);
+    CINTA_ASSERT_INT(3, receive_all(socks[0], BAND_SIZE, 'a', info), info);
+    CINTA_ASSERT_INT(2, receive_all(socks[1], BAND_SIZE, 'a', info), info);
+
+    free_egress_queue(queue);
+    close(sock);
+    close(socks[0]);
+    close(socks[1]);
+}
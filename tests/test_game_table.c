@@ -1,15 +1,23 @@
-
 #include "../src/model.h"
 #include "test.h"
 
+#include <pthread.h>
+
+#define NB_CONCURRENT_THREADS 4
+#define NB_CONCURRENT_GAMES 100
+
 void test_add_game(test_info *);
+void test_concurrent_games(test_info *);
+void test_tick_diff(test_info *);
 
 test_info *game_table() {
-    test_case cases[1] = {
+    test_case cases[3] = {
         QUICK_CASE("Add game", test_add_game),
+        QUICK_CASE("Concurrent add and remove of games", test_concurrent_games),
+        QUICK_CASE("Differences of a tick", test_tick_diff),
     };
 
-    return cinta_run_cases("Game table tests", cases, 1);
+    return cinta_run_cases("Game table tests", cases, 3);
 }
 
 void test_add_game(test_info *info) {
@@ -22,3 +30,75 @@ void test_add_game(test_info *info) {
 
     reset_games();
 }
+
+void *play_games(void *arg) {
+    bool *valid = (bool *)arg;
+    dimension dim = {30, 32};
+    player_action actions[1] = {{0, GAME_RIGHT}};
+
+    for (int i = 0; i < NB_CONCURRENT_GAMES; i++) {
+        int game_id = init_model(dim, i % 2 == 0 ? SOLO : TEAM);
+        if (game_id < 0 || get_game_mode(game_id) != (i % 2 == 0 ? SOLO : TEAM)) {
+            *valid = false;
+            continue;
+        }
+
+        unsigned size_tile_diff;
+        tile_diff *diffs = update_game_board(game_id, actions, 1, &size_tile_diff);
+        free(diffs);
+        if (is_game_over(game_id)) {
+            *valid = false;
+        }
+
+        remove_game(game_id);
+    }
+    return NULL;
+}
+
+void test_concurrent_games(test_info *info) {
+    pthread_t threads[NB_CONCURRENT_THREADS];
+    bool valid[NB_CONCURRENT_THREADS];
+
+    for (int i = 0; i < NB_CONCURRENT_THREADS; i++) {
+        valid[i] = true;
+        pthread_create(&threads[i], NULL, play_games, &valid[i]);
+    }
+    for (int i = 0; i < NB_CONCURRENT_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        CINTA_ASSERT(valid[i], info);
+    }
+
+    reset_games();
+}
+
+void test_tick_diff(test_info *info) {
+    dimension dim = {30, 32};
+    int game_id = init_model(dim, SOLO);
+    unsigned size_tile_diff;
+
+    // The first player starts at (0, 0) and (1, 0) is always empty
+    player_action move_right[1] = {{0, GAME_RIGHT}};
+    tile_diff *diffs = update_game_board(game_id, move_right, 1, &size_tile_diff);
+    CINTA_ASSERT_INT(size_tile_diff, 2, info);
+    for (unsigned i = 0; i < size_tile_diff; i++) {
+        CINTA_ASSERT_INT(diffs[i].y, 0, info);
+        CINTA_ASSERT_INT(diffs[i].tile, diffs[i].x == 0 ? EMPTY : PLAYER_1, info);
+    }
+    free(diffs);
+
+    // A tile changed back to its value of the previous tick is not a difference
+    player_action move_back_and_forth[2] = {{0, GAME_LEFT}, {0, GAME_RIGHT}};
+    diffs = update_game_board(game_id, move_back_and_forth, 2, &size_tile_diff);
+    CINTA_ASSERT_INT(size_tile_diff, 0, info);
+    free(diffs);
+
+    // The changes made between ticks are part of the next differences
+    set_player_dead(game_id, 0);
+    diffs = update_game_board(game_id, NULL, 0, &size_tile_diff);
+    CINTA_ASSERT_INT(size_tile_diff, 1, info);
+    CINTA_ASSERT_INT(diffs[0].x, 1, info);
+    CINTA_ASSERT_INT(diffs[0].tile, EMPTY, info);
+    free(diffs);
+
+    reset_games();
+}
@@ -0,0 +1,108 @@
+#include <stdlib.h>
+
+#include "../src/matchmaking.h"
+#include "test.h"
+
+#define NUMBER_TESTS 4
+
+void test_lobbies_filled_in_order(test_info *info);
+void test_place_given_back(test_info *info);
+void test_places_closed(test_info *info);
+void test_places_settled_again(test_info *info);
+
+test_info *matchmaking_queue() {
+    test_case cases[NUMBER_TESTS] = {
+        QUICK_CASE("Filling the oldest lobby first", test_lobbies_filled_in_order),
+        QUICK_CASE("Backfilling the place of a player who left", test_place_given_back),
+        QUICK_CASE("Closing the places of a lobby", test_places_closed),
+        QUICK_CASE("Settling the absent places of a lobby which expires again", test_places_settled_again),
+    };
+
+    return cinta_run_cases("Matchmaking tests", cases, NUMBER_TESTS);
+}
+
+void test_lobbies_filled_in_order(test_info *info) {
+    match_queue queue;
+    init_match_queue(&queue);
+    match_entry lobbies[2];
+    init_match_entry(&lobbies[0]);
+    init_match_entry(&lobbies[1]);
+    int id;
+
+    CINTA_ASSERT(take_place(&queue, &id) == NULL, info);
+    enqueue_lobby(&queue, &lobbies[0]);
+    enqueue_lobby(&queue, &lobbies[1]);
+    for (int i = 0; i < PLAYER_NUM; i++) {
+        CINTA_ASSERT(take_place(&queue, &id) == &lobbies[0], info);
+        CINTA_ASSERT_INT(id, i, info);
+    }
+    CINTA_ASSERT_FALSE(lobbies[0].queued, info);
+    CINTA_ASSERT_INT(queue.size, 1, info);
+    CINTA_ASSERT(take_place(&queue, &id) == &lobbies[1], info);
+    CINTA_ASSERT_INT(id, 0, info);
+}
+
+void test_place_given_back(test_info *info) {
+    match_queue queue;
+    init_match_queue(&queue);
+    match_entry lobbies[2];
+    init_match_entry(&lobbies[0]);
+    init_match_entry(&lobbies[1]);
+    enqueue_lobby(&queue, &lobbies[0]);
+    int id;
+    for (int i = 0; i < PLAYER_NUM; i++) {
+        take_place(&queue, &id);
+    }
+    enqueue_lobby(&queue, &lobbies[1]);
+
+    // The full lobby goes back before the newer one
+    give_back_place(&queue, &lobbies[0], 2);
+    CINTA_ASSERT(queue.head == &lobbies[0], info);
+    CINTA_ASSERT(take_place(&queue, &id) == &lobbies[0], info);
+    CINTA_ASSERT_INT(id, 2, info);
+    CINTA_ASSERT(queue.head == &lobbies[1], info);
+
+    // A lobby still waiting for players keeps its rank
+    take_place(&queue, &id);
+    give_back_place(&queue, &lobbies[1], id);
+    CINTA_ASSERT_INT(queue.size, 1, info);
+    CINTA_ASSERT(take_place(&queue, &id) == &lobbies[1], info);
+    CINTA_ASSERT_INT(id, 0, info);
+}
+
+void test_places_closed(test_info *info) {
+    match_queue queue;
+    init_match_queue(&queue);
+    match_entry lobby;
+    init_match_entry(&lobby);
+    enqueue_lobby(&queue, &lobby);
+    int id;
+    take_place(&queue, &id);
+
+    close_places(&queue, &lobby);
+    CINTA_ASSERT_FALSE(lobby.queued, info);
+    CINTA_ASSERT_INT(queue.size, 0, info);
+    CINTA_ASSERT(take_place(&queue, &id) == NULL, info);
+    dequeue_lobby(&queue, &lobby); // Nothing to remove
+    CINTA_ASSERT(queue.head == NULL && queue.tail == NULL, info);
+}
+
+void test_places_settled_again(test_info *info) {
+    settled_places places;
+    init_settled_places(&places);
+
+    // The lobby expires with the players 0, 1 and 2, who are then ready
+    CINTA_ASSERT(settle_place(&places, 3), info);
+    for (int i = 0; i < 3; i++) {
+        settle_place(&places, i);
+    }
+    CINTA_ASSERT(are_places_settled(&places), info);
+
+    // The player 2 leaves before the start, then the lobby expires again without him
+    unsettle_place(&places, 2);
+    CINTA_ASSERT_FALSE(are_places_settled(&places), info);
+    CINTA_ASSERT(settle_place(&places, 2), info);
+    CINTA_ASSERT_FALSE(settle_place(&places, 3), info); // Already absent at the first expiry
+    CINTA_ASSERT_INT(places.nb_settled, PLAYER_NUM, info);
+    CINTA_ASSERT(are_places_settled(&places), info);
+}
@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../src/reactor.h"
+#include "test.h"
+
+#define NUMBER_TESTS 3
+
+void test_readable_and_timer(test_info *info);
+void test_handler_removal(test_info *info);
+void test_free_without_start(test_info *info);
+
+test_info *reactor_events() {
+    test_case cases[NUMBER_TESTS] = {
+        QUICK_CASE("Calling back the readable sockets and the timer", test_readable_and_timer),
+        QUICK_CASE("Removing a handler from its callback", test_handler_removal),
+        QUICK_CASE("Freeing a reactor which was not started", test_free_without_start),
+    };
+
+    return cinta_run_cases("Reactor tests", cases, NUMBER_TESTS);
+}
+
+typedef struct socket_events {
+    reactor *r;
+    reactor_handler *handler;
+    bool remove; // The handler removes itself on its first call
+    unsigned calls;
+    unsigned bytes; // Read by the callbacks
+} socket_events;
+
+void read_socket(int fd, uint32_t events, void *data) {
+    socket_events *counter = (socket_events *)data;
+    counter->calls++;
+    if (events & EPOLLIN) {
+        char buffer[16];
+        ssize_t res;
+        // Edge-triggered, everything has to be read
+        while ((res = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+            counter->bytes += res;
+        }
+    }
+    if (counter->remove) {
+        reactor_remove(counter->r, counter->handler);
+    }
+}
+
+void count_timer(void *data) {
+    (*(unsigned *)data)++;
+}
+
+void test_readable_and_timer(test_info *info) {
+    int fds[2];
+    CINTA_ASSERT_INT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0, info);
+    reactor *r = create_reactor();
+    CINTA_ASSERT_NOT_NULL(r, info);
+
+    socket_events counter = {r, NULL, false, 0, 0};
+    unsigned timer_calls = 0;
+    counter.handler = reactor_add(r, fds[0], EPOLLIN, read_socket, &counter);
+    CINTA_ASSERT_NOT_NULL(counter.handler, info);
+    start_reactor(r, 10, count_timer, &timer_calls);
+
+    CINTA_ASSERT_INT(write(fds[1], "0123456789", 10), 10, info);
+    usleep(50000);
+    CINTA_ASSERT_INT(write(fds[1], "01234", 5), 5, info);
+    usleep(50000);
+    free_reactor(r);
+
+    CINTA_ASSERT_INT(counter.bytes, 15, info);
+    CINTA_ASSERT(counter.calls >= 2, info);
+    CINTA_ASSERT(timer_calls >= 2, info); // About 10, with a wide margin for loaded machines
+    close(fds[0]);
+    close(fds[1]);
+}
+
+void test_handler_removal(test_info *info) {
+    int fds[2];
+    CINTA_ASSERT_INT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0, info);
+    reactor *r = create_reactor();
+    CINTA_ASSERT_NOT_NULL(r, info);
+
+    socket_events counter = {r, NULL, true, 0, 0};
+    counter.handler = reactor_add(r, fds[0], EPOLLIN, read_socket, &counter);
+    CINTA_ASSERT_NOT_NULL(counter.handler, info);
+    start_reactor(r, 1000, NULL, NULL);
+
+    CINTA_ASSERT_INT(write(fds[1], "01", 2), 2, info);
+    usleep(50000);
+    CINTA_ASSERT_INT(write(fds[1], "23", 2), 2, info);
+    usleep(50000);
+    free_reactor(r);
+
+    CINTA_ASSERT_INT(counter.calls, 1, info);
+    CINTA_ASSERT_INT(counter.bytes, 2, info);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+void test_free_without_start(test_info *info) {
+    reactor *r = create_reactor();
+    CINTA_ASSERT_NOT_NULL(r, info);
+    CINTA_ASSERT(!r->started, info);
+    free_reactor(r); // There is no thread to wait for
+}
@@ -15,8 +15,9 @@ void test_team_message_invalid_type(test_info *info);
 void test_team_message_invalid_id(test_info *info);
 void test_team_message_invalid_eq(test_info *info);
 void test_team_message_ignore_eq_on_global(test_info *info);
+void test_message_view(test_info *info);
 
-#define NUMBER_TESTS 10
+#define NUMBER_TESTS 11
 
 test_info *serialization_chat() {
     test_case cases[NUMBER_TESTS] = {
@@ -30,6 +31,7 @@ test_info *serialization_chat() {
         QUICK_CASE("Team message invalid id", test_team_message_invalid_id),
         QUICK_CASE("Team message invalid eq", test_team_message_invalid_eq),
         QUICK_CASE("Team message ignore eq on global", test_team_message_ignore_eq_on_global),
+        QUICK_CASE("Message view", test_message_view),
     };
 
     return cinta_run_cases("Serialization tests | Chat", cases, NUMBER_TESTS);
@@ -216,3 +218,24 @@ void test_team_message_ignore_eq_on_global(test_info *info) {
     free(deserialized);
     free(msg);
 }
+
+void test_message_view(test_info *info) {
+    chat_message_view msg = {TEAM_M, 2, 1, 5, "hello world"};
+    char serialized[CHAT_MESSAGE_SIZE(5)];
+
+    CINTA_ASSERT_INT(client_serialize_chat_message_into(&msg, serialized, sizeof(serialized) - 1), -1, info);
+    CINTA_ASSERT_INT(client_serialize_chat_message_into(&msg, serialized, sizeof(serialized)), sizeof(serialized),
+                     info);
+
+    chat_message_view view;
+    CINTA_ASSERT_INT(server_deserialize_chat_message_view(serialized, sizeof(serialized), &view), EXIT_FAILURE, info);
+    CINTA_ASSERT_INT(client_deserialize_chat_message_view(serialized, sizeof(serialized) - 1, &view), EXIT_FAILURE,
+                     info);
+    CINTA_ASSERT_INT(client_deserialize_chat_message_view(serialized, sizeof(serialized), &view), EXIT_SUCCESS, info);
+    CINTA_ASSERT_INT(view.type, TEAM_M, info);
+    CINTA_ASSERT_INT(view.id, 2, info);
+    CINTA_ASSERT_INT(view.eq, 1, info);
+    CINTA_ASSERT_INT(view.message_length, 5, info);
+    CINTA_ASSERT(view.message == serialized + 3, info);
+    CINTA_ASSERT(strncmp(view.message, "hello", 5) == 0, info);
+}
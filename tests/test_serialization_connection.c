@@ -4,7 +4,7 @@
 #include "../src/messages.h"
 #include "test.h"
 
-#define NUMBER_TESTS 16
+#define NUMBER_TESTS 17
 
 void test_initial_connection_solo(test_info *info);
 void test_initial_connection_team(test_info *info);
@@ -18,6 +18,7 @@ void test_ready_connection_invalid_team_number(test_info *info);
 void test_ready_connection_invalid_id(test_info *info);
 void test_ready_connection_ignores_eq(test_info *info);
 void test_ready_connnection_invalid_eq(test_info *info);
+void test_ready_connection_of_player(test_info *info);
 
 void test_connection_information_solo(test_info *info);
 void test_connection_information_team(test_info *info);
@@ -40,6 +41,7 @@ test_info *serialization_connection() {
         QUICK_CASE("De/Serializing invalid ready connection with invalid id", test_ready_connection_invalid_id),
         QUICK_CASE("De/Serializing ready connection solo ignores eq", test_ready_connection_ignores_eq),
         QUICK_CASE("De/Serializing invalid ready connection with invalid eq", test_ready_connnection_invalid_eq),
+        QUICK_CASE("Checking the ready connection of a player", test_ready_connection_of_player),
         QUICK_CASE("De/Serializing connection information in SOLO mode", test_connection_information_solo),
         QUICK_CASE("De/Serializing connection information in TEAM mode", test_connection_information_team),
         QUICK_CASE("De/Serializing invalid connection information with invalid game mode",
@@ -201,6 +203,23 @@ void test_ready_connnection_invalid_eq(test_info *info) {
     free(connection);
 }
 
+void test_ready_connection_of_player(test_info *info) {
+    ready_connection_header header = {TEAM, 2, 1};
+    connection_header_raw raw;
+    CINTA_ASSERT_INT(serialize_ready_connection_into(&header, &raw), EXIT_SUCCESS, info);
+    ready_connection_header received;
+    CINTA_ASSERT_INT(deserialize_ready_connection_into(&raw, &received), EXIT_SUCCESS, info);
+
+    CINTA_ASSERT(is_ready_connection_of(&received, TEAM, 2, 1), info);
+    CINTA_ASSERT_FALSE(is_ready_connection_of(&received, SOLO, 2, 1), info);
+    CINTA_ASSERT_FALSE(is_ready_connection_of(&received, TEAM, 1, 1), info);
+    CINTA_ASSERT_FALSE(is_ready_connection_of(&received, TEAM, 2, 0), info);
+
+    // The team is not checked in SOLO
+    received.game_mode = SOLO;
+    CINTA_ASSERT(is_ready_connection_of(&received, SOLO, 2, 0), info);
+}
+
 void test_connection_information(GAME_MODE game_mode, test_info *info, int portudp, int portmdiff, int *adrmdiff) {
     connection_information *header = malloc(sizeof(connection_information));
     header->game_mode = game_mode;
@@ -217,6 +236,8 @@ void test_connection_information(GAME_MODE game_mode, test_info *info, int portu
         for (int i = 0; i < 8; i++) {
             header->adrmdiff[i] = adrmdiff[i];
         }
+        header->token = 0x12345678u * (i + 1);
+        header->transport = i % 2 == 0 ? MULTICAST_TRANSPORT : UNICAST_TRANSPORT;
 
         connection_information_raw *connection = serialize_connection_information(header);
         connection_information *deserialized = deserialize_connection_information(connection);
@@ -228,6 +249,8 @@ void test_connection_information(GAME_MODE game_mode, test_info *info, int portu
         for (int i = 0; i < 8; i++) {
             CINTA_ASSERT_INT(header->adrmdiff[i], deserialized->adrmdiff[i], info);
         }
+        CINTA_ASSERT(header->token == deserialized->token, info);
+        CINTA_ASSERT(header->transport == deserialized->transport, info);
 
         free(connection);
         free(deserialized);
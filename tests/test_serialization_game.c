@@ -1,4 +1,6 @@
+#include <arpa/inet.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "../src/messages.h"
 #include "test.h"
@@ -17,12 +19,19 @@ void test_medium_board(test_info *info);
 void test_big_board(test_info *info);
 void test_invalid_header(test_info *info);
 void test_invalid_board(test_info *info);
+void test_board_view(test_info *info);
+void test_packed_board_runs(test_info *info);
+void test_packed_board_nibbles(test_info *info);
+void test_large_board_bands(test_info *info);
 
 void test_game_board_update_small(test_info *info);
 void test_game_board_update_medium(test_info *info);
 void test_game_board_update_large(test_info *info);
 void test_game_board_update_invalid_header(test_info *info);
 void test_game_board_update_invalid_diff(test_info *info);
+void test_game_board_update_view(test_info *info);
+void test_game_board_update_fragment(test_info *info);
+void test_game_region(test_info *info);
 
 void test_game_end_solo(test_info *info);
 void test_game_end_team(test_info *info);
@@ -32,7 +41,7 @@ void test_team_ignore_id(test_info *info);
 void test_invalid_game_end_eq(test_info *info);
 void test_solo_ignores_eq(test_info *info);
 
-#define NUMBER_TESTS 25
+#define NUMBER_TESTS 32
 
 test_info *serialization_game() {
     test_case cases[NUMBER_TESTS] = {
@@ -50,12 +59,19 @@ test_info *serialization_game() {
         QUICK_CASE("Test big board", test_big_board),
         QUICK_CASE("Test invalid header", test_invalid_header),
         QUICK_CASE("Test invalid board", test_invalid_board),
+        QUICK_CASE("Test board view", test_board_view),
+        QUICK_CASE("Test packed board with runs", test_packed_board_runs),
+        QUICK_CASE("Test packed board with nibbles", test_packed_board_nibbles),
+        QUICK_CASE("Test large board bands", test_large_board_bands),
 
         QUICK_CASE("Test game board update small", test_game_board_update_small),
         QUICK_CASE("Test game board update medium", test_game_board_update_medium),
         QUICK_CASE("Test game board update large", test_game_board_update_large),
         QUICK_CASE("Test game board update invalid header", test_game_board_update_invalid_header),
         QUICK_CASE("Test game board update invalid diff", test_game_board_update_invalid_diff),
+        QUICK_CASE("Test game board update view", test_game_board_update_view),
+        QUICK_CASE("Test game board update fragment", test_game_board_update_fragment),
+        QUICK_CASE("Test game region", test_game_region),
 
         QUICK_CASE("Test game end solo", test_game_end_solo),
         QUICK_CASE("Test game end team", test_game_end_team),
@@ -82,6 +98,7 @@ void test_game_action(GAME_MODE game_mode, test_info *info, int message_number)
 
                 action->message_number = message_number;
                 action->action = (GAME_ACTION)k;
+                action->token = 0xdeadbeef - k;
 
                 char *serialized = serialize_game_action(action);
                 game_action *deserialized = deserialize_game_action(serialized);
@@ -91,6 +108,7 @@ void test_game_action(GAME_MODE game_mode, test_info *info, int message_number)
                 CINTA_ASSERT_INT(action->id, deserialized->id, info);
                 CINTA_ASSERT_INT(action->message_number, deserialized->message_number, info);
                 CINTA_ASSERT_INT(action->action, deserialized->action, info);
+                CINTA_ASSERT(action->token == deserialized->token, info);
 
                 free(serialized);
                 free(deserialized);
@@ -268,6 +286,119 @@ void test_invalid_board(test_info *info) {
     free(game_info);
 }
 
+void test_board_view(test_info *info) {
+    char tiles[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 0, 1, 2};
+    game_board_view view = {42, 3, 4, tiles};
+    char serialized[GAME_BOARD_SIZE(3, 4)];
+
+    CINTA_ASSERT_INT(serialize_game_board_into(&view, serialized, sizeof(serialized) - 1), -1, info);
+    CINTA_ASSERT_INT(serialize_game_board_into(&view, serialized, sizeof(serialized)), sizeof(serialized), info);
+
+    game_board_view deserialized;
+    CINTA_ASSERT_INT(deserialize_game_board_view(serialized, sizeof(serialized) - 1, &deserialized), EXIT_FAILURE,
+                     info);
+    CINTA_ASSERT_INT(deserialize_game_board_view(serialized, sizeof(serialized), &deserialized), EXIT_SUCCESS, info);
+    CINTA_ASSERT_INT(deserialized.num, 42, info);
+    CINTA_ASSERT_INT(deserialized.height, 3, info);
+    CINTA_ASSERT_INT(deserialized.width, 4, info);
+    CINTA_ASSERT(deserialized.tiles == serialized + 6, info);
+
+    // The legacy decoder reads the same bytes
+    game_board_information *legacy = deserialize_game_board(serialized);
+    for (int i = 0; i < 12; i++) {
+        CINTA_ASSERT_INT(legacy->board[i], tiles[i], info);
+    }
+    free_game_board_information(legacy);
+}
+
+void test_packed_board(char *tiles, int height, int width, tile_encoding encoding, test_info *info) {
+    game_board_view view = {3, height, width, tiles};
+    char serialized[PACKED_GAME_BOARD_SIZE(UINT8_MAX, UINT8_MAX)];
+    char unpacked[UINT8_MAX * UINT8_MAX];
+
+    int size = serialize_packed_game_board_into(&view, serialized, sizeof(serialized));
+    CINTA_ASSERT(size > 0 && (size_t)size <= PACKED_GAME_BOARD_SIZE(height, width), info);
+    CINTA_ASSERT_INT(serialized[6], encoding, info);
+
+    game_board_view deserialized;
+    CINTA_ASSERT_INT(deserialize_game_board_into(serialized, size - 1, unpacked, sizeof(unpacked), &deserialized),
+                     EXIT_FAILURE, info);
+    CINTA_ASSERT_INT(deserialize_game_board_into(serialized, size, unpacked, sizeof(unpacked), &deserialized),
+                     EXIT_SUCCESS, info);
+    CINTA_ASSERT_INT(deserialized.num, 3, info);
+    CINTA_ASSERT_INT(deserialized.height, height, info);
+    CINTA_ASSERT_INT(deserialized.width, width, info);
+    CINTA_ASSERT(memcmp(deserialized.tiles, tiles, height * width) == 0, info);
+
+    game_board_information *legacy = deserialize_game_board(serialized);
+    CINTA_ASSERT_INT(legacy->board[height * width - 1], tiles[height * width - 1], info);
+    free_game_board_information(legacy);
+}
+
+void test_packed_board_runs(test_info *info) {
+    char tiles[21 * 51];
+    for (int i = 0; i < 21 * 51; i++) {
+        tiles[i] = i < 300 ? EMPTY : DESTRUCTIBLE_WALL;
+    }
+    tiles[21 * 51 - 1] = PLAYER_4;
+    test_packed_board(tiles, 21, 51, TILE_RUNS, info);
+}
+
+void test_packed_board_nibbles(test_info *info) {
+    char tiles[21 * 51];
+    for (int i = 0; i < 21 * 51; i++) {
+        tiles[i] = i % 2 == 0 ? INDESTRUCTIBLE_WALL : EMPTY;
+    }
+    test_packed_board(tiles, 21, 51, TILE_NIBBLES, info);
+}
+
+void test_large_board_bands(test_info *info) {
+    uint16_t height = 300;
+    uint16_t width = 512;
+    char *tiles = malloc(height * width);
+    for (int i = 0; i < height * width; i++) {
+        tiles[i] = i % 9;
+    }
+    game_board_view view = {42, height, width, tiles};
+    char serialized[GAME_BOARD_BAND_SIZE];
+
+    // A large board does not fit in a single message
+    CINTA_ASSERT_INT(serialize_packed_game_board_into(&view, serialized, sizeof(serialized)), -1, info);
+
+    uint16_t nb_rows = GAME_BOARD_BAND_ROWS(width);
+    CINTA_ASSERT_INT(nb_rows, 4, info);
+    int size = serialize_game_board_band_into(&view, 296, nb_rows, serialized, sizeof(serialized));
+    CINTA_ASSERT_INT(size, GAME_BOARD_BAND_SIZE, info);
+    CINTA_ASSERT_INT(serialize_game_board_band_into(&view, 297, nb_rows, serialized, sizeof(serialized)), -1, info);
+
+    char band_tiles[GAME_BOARD_BAND_TILES];
+    game_board_band_view band;
+    CINTA_ASSERT_INT(deserialize_game_board_band_into(serialized, size - 1, band_tiles, sizeof(band_tiles), &band),
+                     EXIT_FAILURE, info);
+    CINTA_ASSERT_INT(deserialize_game_board_band_into(serialized, size, band_tiles, sizeof(band_tiles), &band),
+                     EXIT_SUCCESS, info);
+    CINTA_ASSERT_INT(band.num, 42, info);
+    CINTA_ASSERT_INT(band.height, height, info);
+    CINTA_ASSERT_INT(band.width, width, info);
+    CINTA_ASSERT_INT(band.first_row, 296, info);
+    CINTA_ASSERT_INT(band.nb_rows, nb_rows, info);
+    CINTA_ASSERT(memcmp(band.tiles, tiles + 296 * width, nb_rows * width) == 0, info);
+
+    // The dimension of the board is bounded
+    uint16_t field = htons(MAX_GAMEBOARD_HEIGHT + 1);
+    memcpy(serialized + 4, &field, sizeof(field));
+    CINTA_ASSERT_INT(deserialize_game_board_band_into(serialized, size, band_tiles, sizeof(band_tiles), &band),
+                     EXIT_FAILURE, info);
+    field = htons(height);
+    memcpy(serialized + 4, &field, sizeof(field));
+    field = 0;
+    memcpy(serialized + 6, &field, sizeof(field));
+    CINTA_ASSERT_INT(deserialize_game_board_band_into(serialized, size, band_tiles, sizeof(band_tiles), &band),
+                     EXIT_FAILURE, info);
+
+    free(tiles);
+}
+
 void test_update(int nb, test_info *info, int seed, int message_number) {
     game_board_update *update = malloc(sizeof(game_board_update));
     update->num = message_number;
@@ -445,3 +576,86 @@ void test_solo_ignores_eq(test_info *info) {
     free(deserialized);
     free(serialized);
 }
+
+void test_game_board_update_view(test_info *info) {
+    tile_diff diffs[2] = {{1, 2, BOMB}, {3, 4, EXPLOSION}};
+    game_board_update update = {7, 2, diffs};
+    char serialized[GAME_BOARD_UPDATE_SIZE(2)];
+
+    CINTA_ASSERT_INT(serialize_game_board_update_into(&update, serialized, sizeof(serialized)), sizeof(serialized),
+                     info);
+
+    game_board_update_view view;
+    CINTA_ASSERT_INT(deserialize_game_board_update_view(serialized, sizeof(serialized) - 1, &view), EXIT_FAILURE,
+                     info);
+    CINTA_ASSERT_INT(deserialize_game_board_update_view(serialized, sizeof(serialized), &view), EXIT_SUCCESS, info);
+    CINTA_ASSERT_INT(view.num, 7, info);
+    CINTA_ASSERT_INT(view.nb, 2, info);
+    for (int i = 0; i < 2; i++) {
+        tile_diff diff = get_game_board_update_diff(&view, i);
+        CINTA_ASSERT_INT(diff.x, diffs[i].x, info);
+        CINTA_ASSERT_INT(diff.y, diffs[i].y, info);
+        CINTA_ASSERT_INT(diff.tile, diffs[i].tile, info);
+    }
+}
+
+void test_game_board_update_fragment(test_info *info) {
+    tile_diff diffs[2] = {{5, 6, DESTRUCTIBLE_WALL}, {7, 8, EMPTY}};
+    game_board_update_fragment fragment = {300, 2, 3, 2, diffs};
+    char serialized[UPDATE_FRAGMENT_SIZE(2)];
+
+    CINTA_ASSERT_INT(serialize_game_board_update_fragment_into(&fragment, serialized, sizeof(serialized)),
+                     sizeof(serialized), info);
+
+    game_board_update_view view;
+    CINTA_ASSERT_INT(deserialize_game_board_update_view(serialized, sizeof(serialized) - 1, &view), EXIT_FAILURE,
+                     info);
+    CINTA_ASSERT_INT(deserialize_game_board_update_view(serialized, sizeof(serialized), &view), EXIT_SUCCESS, info);
+    CINTA_ASSERT_INT(view.num, 300, info);
+    CINTA_ASSERT_INT(view.index, 2, info);
+    CINTA_ASSERT_INT(view.count, 3, info);
+    CINTA_ASSERT_INT(view.nb, 2, info);
+    tile_diff diff = get_game_board_update_diff(&view, 1);
+    CINTA_ASSERT_INT(diff.x, 7, info);
+    CINTA_ASSERT_INT(diff.tile, EMPTY, info);
+
+    // The index of a fragment is below the number of fragments
+    fragment.index = 3;
+    CINTA_ASSERT_INT(serialize_game_board_update_fragment_into(&fragment, serialized, sizeof(serialized)), -1, info);
+}
+
+void test_game_region(test_info *info) {
+    tile_diff diffs[2] = {{31, 0, BOMB}, {2, 17, PLAYER_1}};
+    game_board_update_fragment fragment = {9, 0, 1, 2, diffs};
+    char serialized[REGION_UPDATE_SIZE(2)];
+
+    CINTA_ASSERT_INT(serialize_region_update_fragment_into(&fragment, 300, serialized, sizeof(serialized)),
+                     sizeof(serialized), info);
+    game_board_update_view view;
+    CINTA_ASSERT_INT(deserialize_game_board_update_view(serialized, sizeof(serialized), &view), EXIT_SUCCESS, info);
+    CINTA_ASSERT_INT(view.region, 300, info);
+    CINTA_ASSERT_INT(view.num, 9, info);
+    CINTA_ASSERT_INT(view.nb, 2, info);
+    tile_diff diff = get_game_board_update_diff(&view, 1);
+    CINTA_ASSERT_INT(diff.x, 2, info);
+    CINTA_ASSERT_INT(diff.y, 17, info);
+    CINTA_ASSERT_INT(diff.tile, PLAYER_1, info);
+
+    // The last region of a row of a 300 tiles wide board is 12 tiles wide
+    char tiles[REGION_TILES];
+    for (int i = 0; i < 12 * REGION_SIDE; i++) {
+        tiles[i] = i % 3 == 0 ? EMPTY : DESTRUCTIBLE_WALL;
+    }
+    game_region_view region = {4, 300, 300, 9, tiles};
+    char serialized_region[GAME_REGION_SIZE];
+    int size = serialize_game_region_into(&region, serialized_region, sizeof(serialized_region));
+    CINTA_ASSERT(size > GAME_REGION_HEADER_SIZE, info);
+
+    char received[REGION_TILES];
+    game_region_view res;
+    CINTA_ASSERT_INT(deserialize_game_region_into(serialized_region, size, received, sizeof(received), &res),
+                     EXIT_SUCCESS, info);
+    CINTA_ASSERT_INT(res.num, 4, info);
+    CINTA_ASSERT_INT(res.region, 9, info);
+    CINTA_ASSERT_INT(memcmp(res.tiles, tiles, 12 * REGION_SIDE), 0, info);
+}
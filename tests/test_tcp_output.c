@@ -0,0 +1,90 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../src/tcp_output.h"
+#include "test.h"
+
+#define NUMBER_TESTS 2
+#define MESSAGE_SIZE 1000
+
+void test_sent_at_once(test_info *info);
+void test_kept_until_writable(test_info *info);
+
+test_info *tcp_output_queue() {
+    test_case cases[NUMBER_TESTS] = {
+        QUICK_CASE("Sending at once while the socket takes everything", test_sent_at_once),
+        QUICK_CASE("Keeping what a full socket does not take", test_kept_until_writable),
+    };
+
+    return cinta_run_cases("TCP output tests", cases, NUMBER_TESTS);
+}
+
+void test_sent_at_once(test_info *info) {
+    int fds[2];
+    CINTA_ASSERT_INT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0, info);
+    tcp_output out;
+    init_tcp_output(&out, fds[0]);
+
+    CINTA_ASSERT_INT(send_tcp_output(&out, "hello", 5), EXIT_SUCCESS, info);
+    CINTA_ASSERT_FALSE(has_pending_tcp_output(&out), info);
+    char received[5];
+    CINTA_ASSERT_INT(recv(fds[1], received, sizeof(received), MSG_DONTWAIT), 5, info);
+    CINTA_ASSERT(memcmp(received, "hello", 5) == 0, info);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/** Receives everything already there, checks that the bytes follow the sequence from *next, which is moved */
+static size_t receive_sequence(int sock, unsigned char *next, test_info *info) {
+    unsigned char received[MESSAGE_SIZE];
+    size_t total = 0;
+    ssize_t res;
+    while ((res = recv(sock, received, sizeof(received), MSG_DONTWAIT)) > 0) {
+        for (ssize_t i = 0; i < res; i++) {
+            CINTA_ASSERT_INT(received[i], *next, info);
+            (*next)++;
+        }
+        total += res;
+    }
+    return total;
+}
+
+void test_kept_until_writable(test_info *info) {
+    int fds[2];
+    CINTA_ASSERT_INT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0, info);
+    tcp_output out;
+    init_tcp_output(&out, fds[0]);
+
+    // The client does not read, the messages which do not fit in the socket are kept in order
+    unsigned char message[MESSAGE_SIZE];
+    unsigned char next_sent = 0;
+    size_t sent = 0;
+    int res = EXIT_SUCCESS;
+    while (res == EXIT_SUCCESS) {
+        for (size_t i = 0; i < MESSAGE_SIZE; i++) {
+            message[i] = next_sent + i;
+        }
+        res = send_tcp_output(&out, message, MESSAGE_SIZE);
+        if (res == EXIT_SUCCESS) {
+            next_sent += MESSAGE_SIZE;
+            sent += MESSAGE_SIZE;
+        }
+    }
+    // A client too far behind is given up instead of blocking the sender
+    CINTA_ASSERT(has_pending_tcp_output(&out), info);
+    CINTA_ASSERT(out.nb_pending > TCP_OUTPUT_SIZE - MESSAGE_SIZE, info);
+
+    // Once the client reads, the kept bytes follow
+    unsigned char next_received = 0;
+    size_t received = 0;
+    while (has_pending_tcp_output(&out)) {
+        received += receive_sequence(fds[1], &next_received, info);
+        CINTA_ASSERT_INT(flush_tcp_output(&out), EXIT_SUCCESS, info);
+    }
+    received += receive_sequence(fds[1], &next_received, info);
+    CINTA_ASSERT(received >= sent, info); // The message given up may have been partly sent
+    close(fds[0]);
+    close(fds[1]);
+}
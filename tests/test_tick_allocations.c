@@ -0,0 +1,113 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "../src/game_tick.h"
+#include "test.h"
+
+#define NUMBER_TESTS 2
+#define NB_COUNTED_TICKS 200
+
+static atomic_bool counting_allocations = false;
+static atomic_uint nb_allocations = 0;
+
+// The sanitizers replace the allocator themselves, the allocations cannot be counted with them
+#if !defined(__SANITIZE_THREAD__) && !defined(__SANITIZE_ADDRESS__)
+#define COUNT_ALLOCATIONS
+
+// The allocations of the whole test binary go through these definitions, they are only counted during the ticks
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static void count_allocation() {
+    if (atomic_load(&counting_allocations)) {
+        atomic_fetch_add(&nb_allocations, 1);
+    }
+}
+
+void *malloc(size_t size) {
+    count_allocation();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+    count_allocation();
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    count_allocation();
+    return __libc_realloc(ptr, size);
+}
+#endif
+
+void test_player_actions_order(test_info *info);
+void test_ticks_without_allocation(test_info *info);
+
+test_info *tick_allocations() {
+    test_case cases[NUMBER_TESTS] = {
+        QUICK_CASE("Moves before bombs in the player actions", test_player_actions_order),
+        QUICK_CASE("Ticks without allocation", test_ticks_without_allocation),
+    };
+
+    return cinta_run_cases("Tick allocation tests", cases, NUMBER_TESTS);
+}
+
+void test_player_actions_order(test_info *info) {
+    int last_num[PLAYER_NUM] = {0, 0, 0, 0};
+    game_action actions[3] = {
+        {SOLO, 0, 0, 1, GAME_PLACE_BOMB, 0},
+        {SOLO, 1, 0, 1, GAME_UP, 0},
+        {SOLO, 2, 0, 1, GAME_LEFT, 0},
+    };
+    player_action res[MAX_TICK_PLAYER_ACTIONS];
+
+    CINTA_ASSERT_INT(get_player_actions(actions, 3, last_num, res), 3, info);
+    CINTA_ASSERT_INT(res[0].action, GAME_LEFT, info);
+    CINTA_ASSERT_INT(res[1].action, GAME_UP, info);
+    CINTA_ASSERT_INT(res[2].action, GAME_PLACE_BOMB, info);
+    CINTA_ASSERT_INT(res[2].id, 0, info);
+    CINTA_ASSERT_INT(last_num[0], 1, info);
+}
+
+void test_ticks_without_allocation(test_info *info) {
+    dimension dim = {GAMEBOARD_WIDTH, GAMEBOARD_HEIGHT};
+    int game_id = init_model(dim, SOLO);
+    action_ring *ring = malloc(sizeof(action_ring));
+    tick_buffers *buffers = malloc(sizeof(tick_buffers));
+    init_action_ring(ring);
+    init_tick_buffers(buffers, dim);
+
+    int last_num[PLAYER_NUM];
+    for (int i = 0; i < PLAYER_NUM; i++) {
+        last_num[i] = LIMIT_LAST_NUM_MESSAGE_CLIENT - 1;
+    }
+    GAME_ACTION moves[4] = {GAME_RIGHT, GAME_DOWN, GAME_LEFT, GAME_UP};
+
+    atomic_store(&nb_allocations, 0);
+    atomic_store(&counting_allocations, true);
+    bool valid = true;
+    for (int tick = 0; tick < NB_COUNTED_TICKS; tick++) {
+        game_action actions[2 * PLAYER_NUM];
+        for (int id = 0; id < PLAYER_NUM; id++) {
+            game_action move = {SOLO, id, 0, (2 * tick) % LIMIT_LAST_NUM_MESSAGE_CLIENT, moves[tick % 4], 0};
+            game_action bomb = {SOLO, id, 0, (2 * tick + 1) % LIMIT_LAST_NUM_MESSAGE_CLIENT, GAME_PLACE_BOMB, 0};
+            actions[2 * id] = move;
+            actions[2 * id + 1] = bomb;
+        }
+        push_actions(ring, actions, 2 * PLAYER_NUM);
+        if (prepare_game_update(game_id, ring, last_num, tick, buffers) == -1) {
+            valid = false;
+        }
+    }
+    atomic_store(&counting_allocations, false);
+
+    CINTA_ASSERT(valid, info);
+#ifdef COUNT_ALLOCATIONS
+    CINTA_ASSERT_INT(atomic_load(&nb_allocations), 0, info);
+#endif
+
+    free(buffers);
+    free(ring);
+    remove_game(game_id);
+}
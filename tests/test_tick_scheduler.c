@@ -0,0 +1,67 @@
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../src/tick_scheduler.h"
+#include "test.h"
+
+#define NUMBER_TESTS 2
+
+void test_tick_rate(test_info *info);
+void test_task_removal(test_info *info);
+
+test_info *tick_scheduler_ticks() {
+    test_case cases[NUMBER_TESTS] = {
+        QUICK_CASE("Ticks at a fixed rate", test_tick_rate),
+        QUICK_CASE("Removing a task which is over", test_task_removal),
+    };
+
+    return cinta_run_cases("Tick scheduler tests", cases, NUMBER_TESTS);
+}
+
+typedef struct tick_counter {
+    unsigned calls;
+    unsigned max_calls;
+    unsigned long last_tick;
+    bool increasing; // The numbers of the ticks always increase
+} tick_counter;
+
+bool count_tick(void *data, unsigned long tick) {
+    tick_counter *counter = (tick_counter *)data;
+    if (counter->calls > 0 && tick <= counter->last_tick) {
+        counter->increasing = false;
+    }
+    counter->last_tick = tick;
+    counter->calls++;
+    return counter->max_calls == 0 || counter->calls < counter->max_calls;
+}
+
+void test_tick_rate(test_info *info) {
+    tick_scheduler *scheduler = create_tick_scheduler(5);
+    CINTA_ASSERT_NOT_NULL(scheduler, info);
+
+    tick_counter counters[2] = {{0, 0, 0, true}, {0, 0, 0, true}};
+    schedule_tick_task(scheduler, count_tick, &counters[0]);
+    schedule_tick_task(scheduler, count_tick, &counters[1]);
+    start_tick_scheduler(scheduler);
+    usleep(200000);
+    free_tick_scheduler(scheduler);
+
+    // About 40 ticks, with a wide margin for loaded machines
+    for (int i = 0; i < 2; i++) {
+        CINTA_ASSERT(counters[i].calls >= 20 && counters[i].calls <= 42, info);
+        CINTA_ASSERT(counters[i].increasing, info);
+    }
+}
+
+void test_task_removal(test_info *info) {
+    tick_scheduler *scheduler = create_tick_scheduler(2);
+    CINTA_ASSERT_NOT_NULL(scheduler, info);
+
+    tick_counter counter = {0, 3, 0, true};
+    start_tick_scheduler(scheduler);
+    schedule_tick_task(scheduler, count_tick, &counter);
+    usleep(50000);
+    free_tick_scheduler(scheduler);
+
+    CINTA_ASSERT_INT(counter.calls, 3, info);
+}
@@ -0,0 +1,228 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/update_stream.h"
+#include "test.h"
+
+#define NUMBER_TESTS 7
+#define BOARD_SIDE 4
+
+void test_updates_in_order(test_info *info);
+void test_updates_reordered(test_info *info);
+void test_fragments_reassembled(test_info *info);
+void test_keyframe_catches_up(test_info *info);
+void test_keyframe_requests(test_info *info);
+void test_keyframe_bands(test_info *info);
+void test_region_stream(test_info *info);
+
+test_info *update_stream_reconstruction() {
+    test_case cases[NUMBER_TESTS] = {
+        QUICK_CASE("Applying the updates in order", test_updates_in_order),
+        QUICK_CASE("Buffering the updates received out of order", test_updates_reordered),
+        QUICK_CASE("Reassembling the fragments of an update", test_fragments_reassembled),
+        QUICK_CASE("Catching up a missing update with a whole board", test_keyframe_catches_up),
+        QUICK_CASE("Asking for a whole board while an update is missing", test_keyframe_requests),
+        QUICK_CASE("Assembling a large board from its bands", test_keyframe_bands),
+        QUICK_CASE("Applying the updates of a region", test_region_stream),
+    };
+
+    return cinta_run_cases("Update stream tests", cases, NUMBER_TESTS);
+}
+
+static char empty_tiles[BOARD_SIDE * BOARD_SIDE];
+
+static board *create_test_board() {
+    board *b = malloc(sizeof(board));
+    b->dim = (dimension){BOARD_SIDE, BOARD_SIDE};
+    b->grid = calloc(BOARD_SIDE * BOARD_SIDE, sizeof(char));
+    return b;
+}
+
+static void apply_empty_keyframe(update_stream *stream, board *b, uint16_t num) {
+    memset(empty_tiles, EMPTY, sizeof(empty_tiles));
+    game_board_view view = {num, BOARD_SIDE, BOARD_SIDE, empty_tiles};
+    apply_keyframe(stream, b, &view);
+}
+
+/** Applies an update of num which places a wall on the tile x */
+static update_status apply_wall_update(update_stream *stream, board *b, uint16_t num, uint8_t x) {
+    tile_diff diff = {x, 0, INDESTRUCTIBLE_WALL};
+    game_board_update update = {num, 1, &diff};
+    char serialized[GAME_BOARD_UPDATE_SIZE(1)];
+    int size = serialize_game_board_update_into(&update, serialized, sizeof(serialized));
+    return apply_update(stream, b, serialized, size);
+}
+
+void test_updates_in_order(test_info *info) {
+    update_stream stream;
+    init_update_stream(&stream);
+    board *b = create_test_board();
+
+    apply_empty_keyframe(&stream, b, 65535);
+    CINTA_ASSERT_INT(apply_wall_update(&stream, b, 65535, 0), UPDATE_APPLIED, info);
+    CINTA_ASSERT_INT(apply_wall_update(&stream, b, 0, 1), UPDATE_APPLIED, info); // The numbers wrap around
+    CINTA_ASSERT_INT(apply_wall_update(&stream, b, 0, 2), UPDATE_DROPPED, info);
+    CINTA_ASSERT_INT(stream.expected_num, 1, info);
+    CINTA_ASSERT_CHAR(b->grid[1], INDESTRUCTIBLE_WALL, info);
+    CINTA_ASSERT_CHAR(b->grid[2], EMPTY, info);
+
+    free_board(b);
+}
+
+void test_updates_reordered(test_info *info) {
+    update_stream stream;
+    init_update_stream(&stream);
+    board *b = create_test_board();
+
+    apply_empty_keyframe(&stream, b, 10);
+    CINTA_ASSERT_INT(apply_wall_update(&stream, b, 12, 2), UPDATE_BUFFERED, info);
+    CINTA_ASSERT_INT(apply_wall_update(&stream, b, 11, 1), UPDATE_BUFFERED, info);
+    CINTA_ASSERT_CHAR(b->grid[1], EMPTY, info);
+
+    CINTA_ASSERT_INT(apply_wall_update(&stream, b, 10, 0), UPDATE_APPLIED, info);
+    CINTA_ASSERT_INT(stream.expected_num, 13, info);
+    CINTA_ASSERT_CHAR(b->grid[1], INDESTRUCTIBLE_WALL, info);
+    CINTA_ASSERT_CHAR(b->grid[2], INDESTRUCTIBLE_WALL, info);
+
+    free_board(b);
+}
+
+/** Applies the fragment index of the update num which places a wall on the tile x */
+static update_status apply_wall_fragment(update_stream *stream, board *b, uint16_t num, uint8_t index, uint8_t x) {
+    tile_diff diff = {x, 0, INDESTRUCTIBLE_WALL};
+    game_board_update_fragment fragment = {num, index, 2, 1, &diff};
+    char serialized[UPDATE_FRAGMENT_SIZE(1)];
+    int size = serialize_game_board_update_fragment_into(&fragment, serialized, sizeof(serialized));
+    return apply_update(stream, b, serialized, size);
+}
+
+void test_fragments_reassembled(test_info *info) {
+    update_stream stream;
+    init_update_stream(&stream);
+    board *b = create_test_board();
+
+    apply_empty_keyframe(&stream, b, 3);
+    CINTA_ASSERT_INT(apply_wall_fragment(&stream, b, 4, 1, 3), UPDATE_BUFFERED, info);
+    CINTA_ASSERT_INT(apply_wall_fragment(&stream, b, 3, 1, 1), UPDATE_BUFFERED, info);
+    CINTA_ASSERT_INT(apply_wall_fragment(&stream, b, 3, 1, 1), UPDATE_BUFFERED, info); // Duplicated fragment
+    CINTA_ASSERT_CHAR(b->grid[1], EMPTY, info);
+
+    CINTA_ASSERT_INT(apply_wall_fragment(&stream, b, 3, 0, 0), UPDATE_APPLIED, info);
+    CINTA_ASSERT_INT(stream.expected_num, 4, info);
+    CINTA_ASSERT_CHAR(b->grid[0], INDESTRUCTIBLE_WALL, info);
+    CINTA_ASSERT_CHAR(b->grid[1], INDESTRUCTIBLE_WALL, info);
+    CINTA_ASSERT_CHAR(b->grid[3], EMPTY, info);
+
+    CINTA_ASSERT_INT(apply_wall_fragment(&stream, b, 4, 0, 2), UPDATE_APPLIED, info);
+    CINTA_ASSERT_CHAR(b->grid[3], INDESTRUCTIBLE_WALL, info);
+
+    free_board(b);
+}
+
+void test_keyframe_catches_up(test_info *info) {
+    update_stream stream;
+    init_update_stream(&stream);
+    board *b = create_test_board();
+
+    // The updates received before the first whole board wait for it
+    CINTA_ASSERT_INT(apply_wall_update(&stream, b, 4, 0), UPDATE_BUFFERED, info);
+    CINTA_ASSERT_INT(apply_wall_update(&stream, b, 6, 2), UPDATE_BUFFERED, info);
+    apply_empty_keyframe(&stream, b, 5);
+    CINTA_ASSERT_INT(stream.expected_num, 5, info);
+    CINTA_ASSERT_CHAR(b->grid[0], EMPTY, info);
+
+    // The update 5 is lost, the next whole board replaces it
+    apply_empty_keyframe(&stream, b, 6);
+    CINTA_ASSERT_INT(stream.expected_num, 7, info);
+    CINTA_ASSERT_CHAR(b->grid[2], INDESTRUCTIBLE_WALL, info);
+
+    // An older whole board is ignored
+    game_board_view view = {5, BOARD_SIDE, BOARD_SIDE, empty_tiles};
+    CINTA_ASSERT_FALSE(apply_keyframe(&stream, b, &view), info);
+    CINTA_ASSERT_CHAR(b->grid[2], INDESTRUCTIBLE_WALL, info);
+
+    free_board(b);
+}
+
+void test_keyframe_requests(test_info *info) {
+    update_stream stream;
+    init_update_stream(&stream);
+    board *b = create_test_board();
+
+    // A whole board is missing until the first one
+    CINTA_ASSERT_FALSE(should_request_keyframe(&stream, 1000), info);
+    CINTA_ASSERT(should_request_keyframe(&stream, 1000 + KEYFRAME_REQUEST_DELAY), info);
+    CINTA_ASSERT_FALSE(should_request_keyframe(&stream, 1000 + KEYFRAME_REQUEST_DELAY + 1), info);
+
+    apply_empty_keyframe(&stream, b, 0);
+    CINTA_ASSERT_FALSE(should_request_keyframe(&stream, 2000), info);
+
+    apply_wall_update(&stream, b, 1, 0);
+    CINTA_ASSERT_FALSE(should_request_keyframe(&stream, 3000), info);
+    CINTA_ASSERT(should_request_keyframe(&stream, 3000 + KEYFRAME_REQUEST_DELAY), info);
+
+    // The missing update comes, nothing is missing anymore
+    apply_wall_update(&stream, b, 0, 1);
+    CINTA_ASSERT_FALSE(should_request_keyframe(&stream, 4000), info);
+    CINTA_ASSERT_FALSE(should_request_keyframe(&stream, 5000), info);
+
+    free_board(b);
+}
+
+void test_keyframe_bands(test_info *info) {
+    update_stream stream;
+    init_update_stream(&stream);
+    board *b = create_test_board();
+
+    char rows[2][300];
+    memset(rows[0], DESTRUCTIBLE_WALL, sizeof(rows[0]));
+    memset(rows[1], BOMB, sizeof(rows[1]));
+    game_board_band_view band = {8, 2, 300, 1, 1, rows[1]};
+
+    CINTA_ASSERT_FALSE(apply_keyframe_band(&stream, b, &band), info);
+    CINTA_ASSERT_FALSE(apply_keyframe_band(&stream, b, &band), info); // Duplicated band
+    CINTA_ASSERT_INT(b->dim.width, BOARD_SIDE, info);
+
+    band.first_row = 0;
+    band.tiles = rows[0];
+    CINTA_ASSERT(apply_keyframe_band(&stream, b, &band), info);
+    CINTA_ASSERT_INT(stream.expected_num, 8, info);
+    CINTA_ASSERT_INT(b->dim.width, 300, info);
+    CINTA_ASSERT_CHAR(b->grid[299], DESTRUCTIBLE_WALL, info);
+    CINTA_ASSERT_CHAR(b->grid[300], BOMB, info);
+
+    free_update_stream(&stream);
+    free_board(b);
+}
+
+void test_region_stream(test_info *info) {
+    board *b = malloc(sizeof(board));
+    b->dim = (dimension){300, 300};
+    b->grid = calloc(300 * 300, sizeof(char));
+    region_grid grid;
+    init_region_grid(&grid, b->dim);
+    update_stream stream;
+    init_region_stream(&stream, &grid, 11); // Second region of the second row
+
+    // The updates of the whole board and of the other regions are not the ones of the stream
+    char update[REGION_UPDATE_SIZE(1)];
+    tile_diff diff = {1, 2, BOMB};
+    game_board_update_fragment fragment = {3, 0, 1, 1, &diff};
+    serialize_region_update_fragment_into(&fragment, 12, update, sizeof(update));
+    CINTA_ASSERT_INT(apply_update(&stream, b, update, sizeof(update)), UPDATE_INVALID, info);
+
+    serialize_region_update_fragment_into(&fragment, 11, update, sizeof(update));
+    CINTA_ASSERT_INT(apply_update(&stream, b, update, sizeof(update)), UPDATE_BUFFERED, info);
+
+    char tiles[REGION_TILES];
+    memset(tiles, DESTRUCTIBLE_WALL, sizeof(tiles));
+    game_region_view region = {3, 300, 300, 11, tiles};
+    CINTA_ASSERT(apply_region_keyframe(&stream, b, &region), info);
+    CINTA_ASSERT_INT(stream.expected_num, 4, info);
+    CINTA_ASSERT_CHAR(b->grid[REGION_SIDE * 300 + REGION_SIDE], DESTRUCTIBLE_WALL, info);
+    CINTA_ASSERT_CHAR(b->grid[REGION_SIDE * 300 + REGION_SIDE - 1], EMPTY, info);
+    CINTA_ASSERT_CHAR(b->grid[(REGION_SIDE + 2) * 300 + REGION_SIDE + 1], BOMB, info);
+
+    free_update_stream(&stream);
+    free_board(b);
+}